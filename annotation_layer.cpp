@@ -0,0 +1,137 @@
+#include "annotation_layer.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+AnnotationLayer::AnnotationLayer()
+    : m_leafCount(0), m_dirty(false), m_nextId(1), m_revision(0) {}
+
+int AnnotationLayer::add(double start, double end, const QString &label,
+                         const QColor &color) {
+  if (!std::isfinite(start) || !std::isfinite(end)) {
+    qWarning() << "AnnotationLayer: non-finite annotation position";
+    return -1;
+  }
+
+  Annotation annotation;
+  annotation.id = m_nextId++;
+  annotation.start = qMin(start, end);
+  annotation.end = qMax(start, end);
+  annotation.label = label;
+  annotation.color = color;
+
+  // Events usually arrive in order: then the tree takes the new leaf in
+  // place while it has room
+  const bool inOrder = m_annotations.isEmpty() ||
+                       annotation.start >= m_annotations.last().start;
+  m_annotations.append(annotation);
+  if (!m_dirty && inOrder && m_annotations.size() <= m_leafCount) {
+    setLeaf(m_annotations.size() - 1);
+  } else {
+    m_dirty = true;
+  }
+  ++m_revision;
+  return annotation.id;
+}
+
+bool AnnotationLayer::remove(int id) {
+  for (int i = 0; i < m_annotations.size(); ++i) {
+    if (m_annotations.at(i).id == id) {
+      m_annotations.remove(i);
+      m_dirty = true;
+      ++m_revision;
+      return true;
+    }
+  }
+  return false;
+}
+
+void AnnotationLayer::clear() {
+  m_annotations.clear();
+  m_maxEnd.clear();
+  m_leafCount = 0;
+  m_dirty = false;
+  ++m_revision;
+}
+
+int AnnotationLayer::count() const { return m_annotations.size(); }
+
+const Annotation &AnnotationLayer::at(int index) const {
+  return m_annotations.at(index);
+}
+
+quint64 AnnotationLayer::revision() const { return m_revision; }
+
+void AnnotationLayer::query(double xMin, double xMax,
+                            QVector<int> &indices) {
+  indices.resize(0);
+  if (m_dirty) {
+    rebuild();
+  }
+  if (m_annotations.isEmpty() || xMax < xMin) {
+    return;
+  }
+
+  // Everything starting after xMax is out; of the rest the tree skips
+  // whole ranges that end before xMin
+  const auto last = std::upper_bound(
+      m_annotations.constBegin(), m_annotations.constEnd(), xMax,
+      [](double x, const Annotation &a) { return x < a.start; });
+  const int end = int(last - m_annotations.constBegin());
+  if (end > 0) {
+    collect(1, 0, m_leafCount, end, xMin, indices);
+  }
+}
+
+qint64 AnnotationLayer::memoryUsage() const {
+  qint64 bytes = qint64(m_annotations.capacity()) * qint64(sizeof(Annotation)) +
+                 qint64(m_maxEnd.capacity()) * qint64(sizeof(double));
+  for (const Annotation &annotation : m_annotations) {
+    bytes += qint64(annotation.label.capacity()) * qint64(sizeof(QChar));
+  }
+  return bytes;
+}
+
+void AnnotationLayer::rebuild() {
+  std::stable_sort(m_annotations.begin(), m_annotations.end(),
+                   [](const Annotation &a, const Annotation &b) {
+                     return a.start < b.start;
+                   });
+
+  // Twice the room needed, so a run of in-order appends does not rebuild
+  m_leafCount = 64;
+  while (m_leafCount < 2 * m_annotations.size()) {
+    m_leafCount *= 2;
+  }
+  m_maxEnd.fill(-std::numeric_limits<double>::infinity(), 2 * m_leafCount);
+  for (int i = 0; i < m_annotations.size(); ++i) {
+    m_maxEnd[m_leafCount + i] = m_annotations.at(i).end;
+  }
+  for (int node = m_leafCount - 1; node > 0; --node) {
+    m_maxEnd[node] = qMax(m_maxEnd.at(2 * node), m_maxEnd.at(2 * node + 1));
+  }
+  m_dirty = false;
+}
+
+void AnnotationLayer::setLeaf(int index) {
+  int node = m_leafCount + index;
+  m_maxEnd[node] = m_annotations.at(index).end;
+  for (node /= 2; node > 0; node /= 2) {
+    m_maxEnd[node] = qMax(m_maxEnd.at(2 * node), m_maxEnd.at(2 * node + 1));
+  }
+}
+
+void AnnotationLayer::collect(int node, int nodeBegin, int nodeEnd, int end,
+                              double xMin, QVector<int> &indices) const {
+  if (nodeBegin >= end || m_maxEnd.at(node) < xMin) {
+    return;
+  }
+  if (nodeEnd - nodeBegin == 1) {
+    indices.append(nodeBegin);
+    return;
+  }
+  const int middle = (nodeBegin + nodeEnd) / 2;
+  collect(2 * node, nodeBegin, middle, end, xMin, indices);
+  collect(2 * node + 1, middle, nodeEnd, end, xMin, indices);
+}
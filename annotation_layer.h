@@ -0,0 +1,73 @@
+#ifndef ANNOTATION_LAYER_H
+#define ANNOTATION_LAYER_H
+
+#include <QColor>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// An event over x: a vertical marker when start == end, otherwise a span
+struct Annotation {
+    int id;
+    double start;
+    double end;
+    QString label;
+    // Invalid: the chart's default annotation colour
+    QColor color;
+
+    Annotation() : id(0), start(0.0), end(0.0) {}
+};
+
+// A visible annotation as laid out for the current view, in widget pixels
+struct PlacedAnnotation {
+    int index;       // into AnnotationLayer::at()
+    int left;        // clipped to the plot
+    int right;       // == left for markers
+    int labelRow;    // label line below the plot top, -1 when hidden
+    int labelWidth;
+};
+
+// Annotations sorted by start, with a segment tree holding the largest
+// end of every range of them, so those intersecting an x range are found
+// in O(log N + K) rather than by scanning every one each frame. Appends in
+// start order (events arriving live) update the tree in O(log N); other
+// inserts and removals rebuild it on the next query.
+class AnnotationLayer {
+public:
+    AnnotationLayer();
+
+    // Returns the new annotation's id, or -1 for non-finite positions
+    int add(double start, double end, const QString &label,
+            const QColor &color);
+    bool remove(int id);
+    void clear();
+
+    int count() const;
+    // Indices as returned by the last query(); later removals or
+    // out-of-order adds renumber them
+    const Annotation &at(int index) const;
+    // Changes with every add, remove or clear, for caches of the layout
+    quint64 revision() const;
+
+    // Indices of the annotations with start <= xMax and end >= xMin,
+    // in start order
+    void query(double xMin, double xMax, QVector<int> &indices);
+
+    qint64 memoryUsage() const;
+
+private:
+    void rebuild();
+    void setLeaf(int index);
+    void collect(int node, int nodeBegin, int nodeEnd, int end, double xMin,
+                 QVector<int> &indices) const;
+
+    QVector<Annotation> m_annotations;
+    // Max end per node; node 1 is the root, leaves start at m_leafCount
+    QVector<double> m_maxEnd;
+    int m_leafCount;
+    bool m_dirty;
+    int m_nextId;
+    quint64 m_revision;
+};
+
+#endif // ANNOTATION_LAYER_H
@@ -0,0 +1,133 @@
+// Checks the AnnotationLayer interval tree: after any mix of live appends,
+// out-of-order inserts and removals, query() must return exactly the
+// annotations a scan finds, in start order. Also checks ids, revisions
+// and the rejection of non-finite positions. Exits non-zero on the first
+// failure.
+#include "annotation_layer.h"
+#include <QColor>
+#include <QDebug>
+#include <QVector>
+#include <limits>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+// Compares query(xMin, xMax) with a scan of every annotation
+static bool matchesScan(AnnotationLayer &layer, double xMin, double xMax) {
+  QVector<int> indices;
+  layer.query(xMin, xMax, indices);
+
+  int expected = 0;
+  for (int i = 0; i < layer.count(); ++i) {
+    const Annotation &annotation = layer.at(i);
+    if (annotation.start <= xMax && annotation.end >= xMin) {
+      ++expected;
+    }
+  }
+  if (indices.size() != expected) {
+    return false;
+  }
+  for (int k = 0; k < indices.size(); ++k) {
+    const Annotation &annotation = layer.at(indices[k]);
+    if (annotation.start > xMax || annotation.end < xMin) {
+      return false;
+    }
+    if (k > 0 && layer.at(indices[k - 1]).start > annotation.start) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void randomEdits() {
+  AnnotationLayer layer;
+  QVector<int> ids;
+  int lastId = -1;
+  quint32 state = 3;
+  double now = 0.0;
+  bool ok = true;
+  bool uniqueIds = true;
+
+  for (int step = 0; step < 4000; ++step) {
+    state = state * 1664525u + 1013904223u;
+    const int op = int((state >> 16) % 10);
+    if (op < 7) {
+      // Mostly live events in start order, some back-filled
+      now += (state >> 8) % 5;
+      const double start = op == 0 ? double((state >> 4) % 5000) : now;
+      const double length = op % 3 == 0 ? double((state >> 12) % 40) : 0.0;
+      const double end = start + length;
+      const int id = layer.add(start, end, QString(), QColor());
+      uniqueIds = uniqueIds && id > lastId;
+      lastId = id;
+      ids.append(id);
+    } else if (op == 7 && !ids.isEmpty()) {
+      const int k = int((state >> 8) % quint32(ids.size()));
+      ok = ok && layer.remove(ids[k]);
+      ids.remove(k);
+    }
+
+    state = state * 1664525u + 1013904223u;
+    const double xMin = double((state >> 8) % 5000);
+    ok = ok && matchesScan(layer, xMin, xMin + double((state >> 20) % 300));
+    ok = ok && layer.count() == ids.size();
+  }
+  check(ok, "queries match a scan after appends, inserts and removals");
+  check(uniqueIds, "ids are unique and increasing");
+  check(matchesScan(layer, -std::numeric_limits<double>::infinity(),
+                    std::numeric_limits<double>::infinity()),
+        "an unbounded query returns everything");
+}
+
+static void bookkeeping() {
+  const double inf = std::numeric_limits<double>::infinity();
+  AnnotationLayer layer;
+  quint64 revision = layer.revision();
+
+  check(layer.add(std::numeric_limits<double>::quiet_NaN(), 1.0, QString(),
+                  QColor()) < 0 &&
+            layer.add(0.0, inf, QString(), QColor()) < 0,
+        "non-finite positions are rejected");
+
+  const int marker = layer.add(10.0, 10.0, "marker", QColor());
+  check(layer.revision() != revision, "add changes the revision");
+  revision = layer.revision();
+
+  // A span given end first is stored start first
+  layer.add(30.0, 20.0, "span", QColor());
+  QVector<int> indices;
+  layer.query(25.0, 25.0, indices);
+  check(indices.size() == 1 && layer.at(indices[0]).start == 20.0 &&
+            layer.at(indices[0]).end == 30.0,
+        "spans are found by their interior");
+
+  layer.query(10.0, 10.0, indices);
+  check(indices.size() == 1 && layer.at(indices[0]).label == "marker",
+        "markers are found at their position");
+
+  check(layer.remove(marker) && !layer.remove(marker),
+        "remove() finds an id only once");
+  check(layer.revision() != revision, "remove changes the revision");
+  check(matchesScan(layer, 0.0, 100.0), "query after removal");
+
+  layer.clear();
+  layer.query(-inf, inf, indices);
+  check(layer.count() == 0 && indices.isEmpty(), "clear() empties the layer");
+}
+
+int main() {
+  randomEdits();
+  bookkeeping();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "AnnotationLayer checks passed";
+  return 0;
+}
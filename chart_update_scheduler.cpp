@@ -0,0 +1,114 @@
+#include "chart_update_scheduler.h"
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QPointer>
+#include <QScreen>
+#include <QTimer>
+#include <QWidget>
+#include <algorithm>
+
+ChartUpdateScheduler *ChartUpdateScheduler::instance() {
+  // Owned by the application, so its timer goes away with the event loop
+  static QPointer<ChartUpdateScheduler> scheduler;
+  if (scheduler.isNull()) {
+    scheduler = new ChartUpdateScheduler(QCoreApplication::instance());
+  }
+  return scheduler;
+}
+
+ChartUpdateScheduler::ChartUpdateScheduler(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this)), m_maxFrameRate(60) {
+  m_timer->setTimerType(Qt::PreciseTimer);
+  connect(m_timer, &QTimer::timeout, this, [this]() { frame(); });
+}
+
+void ChartUpdateScheduler::setMaxFrameRate(int framesPerSecond) {
+  m_maxFrameRate = qMax(framesPerSecond, 1);
+  if (m_timer->isActive()) {
+    m_timer->start(frameIntervalMs());
+  }
+}
+
+int ChartUpdateScheduler::maxFrameRate() const { return m_maxFrameRate; }
+
+int ChartUpdateScheduler::frameIntervalMs() const {
+  double rate = m_maxFrameRate;
+  QScreen *screen = QGuiApplication::primaryScreen();
+  if (screen != nullptr && screen->refreshRate() > 0.0) {
+    rate = qMin(rate, screen->refreshRate());
+  }
+  return qMax(1, qRound(1000.0 / rate));
+}
+
+void ChartUpdateScheduler::requestUpdate(QWidget *chart) {
+  Entry &entry = m_entries[chart];
+  if (!entry.dirty) {
+    entry.dirty = true;
+    m_dirty.append(chart);
+  }
+  // The clock only runs while something is waiting for a frame
+  if (!m_timer->isActive()) {
+    m_timer->start(frameIntervalMs());
+  }
+}
+
+void ChartUpdateScheduler::setPriority(QWidget *chart, int priority) {
+  m_entries[chart].priority = priority;
+}
+
+int ChartUpdateScheduler::priority(const QWidget *chart) const {
+  return m_entries.value(const_cast<QWidget *>(chart)).priority;
+}
+
+void ChartUpdateScheduler::reportPaintTime(QWidget *chart, qint64 nsecs) {
+  auto it = m_entries.find(chart);
+  if (it != m_entries.end()) {
+    it->paintNsecs = nsecs;
+  }
+}
+
+void ChartUpdateScheduler::remove(QWidget *chart) {
+  m_entries.remove(chart);
+  m_dirty.removeAll(chart);
+}
+
+int ChartUpdateScheduler::pendingCount() const { return m_dirty.size(); }
+
+void ChartUpdateScheduler::frame() {
+  QVector<QWidget *> dirty;
+  dirty.swap(m_dirty);
+  std::stable_sort(dirty.begin(), dirty.end(),
+                   [this](QWidget *a, QWidget *b) {
+                     const Entry ea = m_entries.value(a);
+                     const Entry eb = m_entries.value(b);
+                     return ea.priority + ea.skippedFrames >
+                            eb.priority + eb.skippedFrames;
+                   });
+
+  // Half the frame for painting charts leaves the rest to everything else
+  const qint64 budget = qint64(frameIntervalMs()) * 1000000 / 2;
+  qint64 planned = 0;
+  for (QWidget *chart : dirty) {
+    Entry &entry = m_entries[chart];
+    if (!chart->isVisible() || chart->visibleRegion().isEmpty()) {
+      entry.dirty = false;
+      entry.skippedFrames = 0;
+      continue;
+    }
+    // The first chart always gets the frame, however slow it is
+    if (planned > 0 && planned + entry.paintNsecs > budget) {
+      ++entry.skippedFrames;
+      m_dirty.append(chart);
+      continue;
+    }
+    entry.dirty = false;
+    entry.skippedFrames = 0;
+    planned += entry.paintNsecs;
+    // Queued, so all charts of the frame are painted in one pass
+    chart->update();
+  }
+
+  if (m_dirty.isEmpty()) {
+    m_timer->stop();
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef CHART_UPDATE_SCHEDULER_H
+#define CHART_UPDATE_SCHEDULER_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <QtGlobal>
+
+class QTimer;
+class QWidget;
+
+// Shared frame clock for every chart in the process. Charts report new
+// data with requestUpdate() instead of calling update(); dirty charts are
+// repainted together once per frame, at most maxFrameRate() per second
+// and never faster than the primary screen refreshes, so the repaint rate
+// depends on frames shown rather than samples received. Charts that are
+// hidden or fully clipped are dropped from the frame (Qt paints them when
+// they are exposed). When the last frame's paint cost exceeds the frame
+// budget, higher priorities go first and the rest wait, gaining priority
+// for every frame they are skipped so none is starved. GUI thread only.
+class ChartUpdateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ChartUpdateScheduler *instance();
+
+    void setMaxFrameRate(int framesPerSecond);
+    int maxFrameRate() const;
+
+    void requestUpdate(QWidget *chart);
+    // Higher is repainted first when frames are over budget; default 0
+    void setPriority(QWidget *chart, int priority);
+    int priority(const QWidget *chart) const;
+    // Paint time of the chart's last frame, used to fill the budget
+    void reportPaintTime(QWidget *chart, qint64 nsecs);
+    void remove(QWidget *chart);
+
+    int pendingCount() const;
+
+private:
+    explicit ChartUpdateScheduler(QObject *parent = nullptr);
+
+    struct Entry {
+        int priority;
+        qint64 paintNsecs;
+        int skippedFrames;
+        bool dirty;
+
+        Entry() : priority(0), paintNsecs(0), skippedFrames(0), dirty(false) {}
+    };
+
+    int frameIntervalMs() const;
+    void frame();
+
+    QTimer *m_timer;
+    int m_maxFrameRate;
+    QHash<QWidget *, Entry> m_entries;
+    QVector<QWidget *> m_dirty;
+};
+
+#endif // CHART_UPDATE_SCHEDULER_H
@@ -0,0 +1,417 @@
+#include "compressed_series.h"
+#include <QMutexLocker>
+#include <QtAlgorithms>
+#include <cstring>
+
+static quint64 doubleBits(double value) {
+  quint64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static double bitsDouble(quint64 bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// MSB-first bit stream over 64-bit words
+class BitWriter {
+public:
+  explicit BitWriter(QVector<quint64> &words) : m_words(words), m_used(64) {}
+
+  void write(quint64 value, int bits) {
+    if (bits < 64) {
+      value &= (quint64(1) << bits) - 1;
+    }
+    if (m_used == 64) {
+      m_words.append(0);
+      m_used = 0;
+    }
+    const int free = 64 - m_used;
+    if (bits <= free) {
+      m_words.last() |= value << (free - bits);
+      m_used += bits;
+    } else {
+      const int rest = bits - free;
+      m_words.last() |= value >> rest;
+      m_words.append(value << (64 - rest));
+      m_used = rest;
+    }
+  }
+
+private:
+  QVector<quint64> &m_words;
+  int m_used;
+};
+
+class BitReader {
+public:
+  explicit BitReader(const quint64 *words) : m_words(words), m_position(0) {}
+
+  quint64 read(int bits) {
+    const quint64 *word = m_words + (m_position >> 6);
+    const int offset = int(m_position & 63);
+    const int available = 64 - offset;
+    m_position += bits;
+    if (bits <= available) {
+      return (word[0] << offset) >> (64 - bits);
+    }
+    const int rest = bits - available;
+    return (((word[0] << offset) >> offset) << rest) |
+           (word[1] >> (64 - rest));
+  }
+
+private:
+  const quint64 *m_words;
+  qint64 m_position;
+};
+
+CompressedSeries::CompressedSeries()
+    : m_encodedBytes(0), m_minY(0.0), m_maxY(0.0), m_cachedBlock(-1) {
+  m_tail.reserve(BlockSize);
+}
+
+void CompressedSeries::append(const QPointF &point) {
+  if (count() == 0) {
+    m_minY = m_maxY = point.y();
+  } else {
+    m_minY = qMin(m_minY, point.y());
+    m_maxY = qMax(m_maxY, point.y());
+  }
+
+  m_tail.append(point);
+  if (m_tail.size() == BlockSize) {
+    sealTail();
+  }
+}
+
+void CompressedSeries::append(const QPointF *points, int count) {
+  for (int i = 0; i < count; ++i) {
+    append(points[i]);
+  }
+}
+
+void CompressedSeries::clear() {
+  QMutexLocker locker(&m_cacheMutex);
+  m_blocks.clear();
+  m_tail.resize(0);
+  m_encodedBytes = 0;
+  m_minY = m_maxY = 0.0;
+  m_cachedBlock = -1;
+}
+
+void CompressedSeries::sealTail() {
+  Block block;
+  block.xFirst = m_tail.first().x();
+  block.xLast = m_tail.last().x();
+  block.minY = block.maxY = m_tail.first().y();
+  for (const QPointF &point : m_tail) {
+    block.minY = qMin(block.minY, point.y());
+    block.maxY = qMax(block.maxY, point.y());
+  }
+  encode(m_tail.constData(), m_tail.size(), block.bits);
+  block.bits.squeeze();
+
+  m_encodedBytes += blockBytes(block);
+  m_blocks.append(block);
+  m_tail.resize(0);
+}
+
+qint64 CompressedSeries::blockBytes(const Block &block) {
+  return qint64(block.bits.capacity()) * qint64(sizeof(quint64));
+}
+
+qint64 CompressedSeries::removeOldest(qint64 bytes,
+                                      QVector<QPointF> *evicted) {
+  int blocks = 0;
+  qint64 freed = 0;
+  while (blocks < m_blocks.size() && freed < bytes) {
+    freed += blockBytes(m_blocks.at(blocks));
+    ++blocks;
+  }
+  if (blocks == 0) {
+    return 0;
+  }
+
+  if (evicted) {
+    const int offset = evicted->size();
+    evicted->resize(offset + blocks * BlockSize);
+    for (int i = 0; i < blocks; ++i) {
+      decode(m_blocks.at(i).bits, BlockSize,
+             evicted->data() + offset + i * BlockSize);
+    }
+  }
+
+  QMutexLocker locker(&m_cacheMutex);
+  m_blocks.remove(0, blocks);
+  m_encodedBytes -= freed;
+  m_cachedBlock = -1;
+
+  // The extent may have left with the dropped blocks
+  bool found = false;
+  for (const Block &block : m_blocks) {
+    m_minY = found ? qMin(m_minY, block.minY) : block.minY;
+    m_maxY = found ? qMax(m_maxY, block.maxY) : block.maxY;
+    found = true;
+  }
+  for (const QPointF &point : m_tail) {
+    m_minY = found ? qMin(m_minY, point.y()) : point.y();
+    m_maxY = found ? qMax(m_maxY, point.y()) : point.y();
+    found = true;
+  }
+  return qint64(blocks) * BlockSize;
+}
+
+void CompressedSeries::encode(const QPointF *points, int count,
+                              QVector<quint64> &bits) {
+  BitWriter writer(bits);
+  quint64 x = doubleBits(points[0].x());
+  quint64 y = doubleBits(points[0].y());
+  writer.write(x, 64);
+  writer.write(y, 64);
+
+  quint64 delta = 0;
+  int leading = -1;
+  int trailing = 0;
+  for (int i = 1; i < count; ++i) {
+    // x: delta-of-delta in unsigned arithmetic, so it is exact for any input
+    const quint64 nextX = doubleBits(points[i].x());
+    const quint64 nextDelta = nextX - x;
+    const qint64 dod = qint64(nextDelta - delta);
+    if (dod == 0) {
+      writer.write(0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+      writer.write(0x2, 2);
+      writer.write(quint64(dod), 7);
+    } else if (dod >= -255 && dod <= 256) {
+      writer.write(0x6, 3);
+      writer.write(quint64(dod), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+      writer.write(0xe, 4);
+      writer.write(quint64(dod), 12);
+    } else {
+      writer.write(0xf, 4);
+      writer.write(quint64(dod), 64);
+    }
+    x = nextX;
+    delta = nextDelta;
+
+    // y: XOR with the previous value; reuse the previous window of
+    // meaningful bits when the new one fits inside it
+    const quint64 nextY = doubleBits(points[i].y());
+    const quint64 xored = nextY ^ y;
+    y = nextY;
+    if (xored == 0) {
+      writer.write(0, 1);
+      continue;
+    }
+    const int lz = qMin(int(qCountLeadingZeroBits(xored)), 31);
+    const int tz = int(qCountTrailingZeroBits(xored));
+    if (leading >= 0 && lz >= leading && tz >= trailing) {
+      writer.write(0x2, 2);
+      writer.write(xored >> trailing, 64 - leading - trailing);
+    } else {
+      const int meaningful = 64 - lz - tz;
+      writer.write(0x3, 2);
+      writer.write(quint64(lz), 5);
+      writer.write(quint64(meaningful - 1), 6);
+      writer.write(xored >> tz, meaningful);
+      leading = lz;
+      trailing = tz;
+    }
+  }
+}
+
+void CompressedSeries::decode(const QVector<quint64> &bits, int count,
+                              QPointF *out) {
+  BitReader reader(bits.constData());
+  quint64 x = reader.read(64);
+  quint64 y = reader.read(64);
+  out[0] = QPointF(bitsDouble(x), bitsDouble(y));
+
+  quint64 delta = 0;
+  int leading = 0;
+  int trailing = 0;
+  for (int i = 1; i < count; ++i) {
+    qint64 dod;
+    if (reader.read(1) == 0) {
+      dod = 0;
+    } else if (reader.read(1) == 0) {
+      dod = qint64(reader.read(7));
+      dod = dod > 64 ? dod - 128 : dod;
+    } else if (reader.read(1) == 0) {
+      dod = qint64(reader.read(9));
+      dod = dod > 256 ? dod - 512 : dod;
+    } else if (reader.read(1) == 0) {
+      dod = qint64(reader.read(12));
+      dod = dod > 2048 ? dod - 4096 : dod;
+    } else {
+      dod = qint64(reader.read(64));
+    }
+    delta += quint64(dod);
+    x += delta;
+
+    if (reader.read(1) != 0) {
+      if (reader.read(1) != 0) {
+        leading = int(reader.read(5));
+        trailing = 64 - leading - (int(reader.read(6)) + 1);
+      }
+      y ^= reader.read(64 - leading - trailing) << trailing;
+    }
+    out[i] = QPointF(bitsDouble(x), bitsDouble(y));
+  }
+}
+
+qint64 CompressedSeries::memoryUsage() const {
+  return m_encodedBytes + qint64(m_tail.capacity()) * qint64(sizeof(QPointF));
+}
+
+qint64 CompressedSeries::indexMemoryUsage() const {
+  return qint64(m_blocks.capacity()) * qint64(sizeof(Block));
+}
+
+qint64 CompressedSeries::cacheMemoryUsage() const {
+  QMutexLocker locker(&m_cacheMutex);
+  return qint64(m_cache.capacity()) * qint64(sizeof(QPointF));
+}
+
+qint64 CompressedSeries::count() const {
+  return qint64(m_blocks.size()) * BlockSize + m_tail.size();
+}
+
+QPointF CompressedSeries::pointAt(qint64 index) const {
+  const int block = int(index / BlockSize);
+  if (block >= m_blocks.size()) {
+    return m_tail.at(int(index - qint64(m_blocks.size()) * BlockSize));
+  }
+
+  QMutexLocker locker(&m_cacheMutex);
+  if (block != m_cachedBlock) {
+    m_cache.resize(BlockSize);
+    decode(m_blocks.at(block).bits, BlockSize, m_cache.data());
+    m_cachedBlock = block;
+  }
+  return m_cache.at(int(index % BlockSize));
+}
+
+qint64 CompressedSeries::lowerBound(double x) const {
+  // First block that reaches x, from the headers alone
+  int first = 0;
+  int len = m_blocks.size();
+  while (len > 0) {
+    int half = len / 2;
+    if (m_blocks.at(first + half).xLast < x) {
+      first += half + 1;
+      len -= half + 1;
+    } else {
+      len = half;
+    }
+  }
+
+  qint64 begin = qint64(first) * BlockSize;
+  qint64 size = first < m_blocks.size() ? BlockSize : m_tail.size();
+  while (size > 0) {
+    qint64 half = size / 2;
+    if (pointAt(begin + half).x() < x) {
+      begin += half + 1;
+      size -= half + 1;
+    } else {
+      size = half;
+    }
+  }
+  return begin;
+}
+
+bool CompressedSeries::yRange(qint64 first, qint64 last, double &minY,
+                              double &maxY) const {
+  first = qMax<qint64>(first, 0);
+  last = qMin(last, count());
+  if (first >= last) {
+    return false;
+  }
+  if (first == 0 && last == count()) {
+    minY = m_minY;
+    maxY = m_maxY;
+    return true;
+  }
+
+  bool found = false;
+  auto include = [&](double lo, double hi) {
+    minY = found ? qMin(minY, lo) : lo;
+    maxY = found ? qMax(maxY, hi) : hi;
+    found = true;
+  };
+
+  QVector<QPointF> decoded;
+  qint64 index = first;
+  while (index < last) {
+    const int block = int(index / BlockSize);
+    const qint64 blockStart = qint64(block) * BlockSize;
+    if (block >= m_blocks.size()) {
+      for (; index < last; ++index) {
+        const double y = m_tail.at(int(index - blockStart)).y();
+        include(y, y);
+      }
+      break;
+    }
+
+    const qint64 blockEnd = blockStart + BlockSize;
+    const qint64 end = qMin(last, blockEnd);
+    if (index == blockStart && end == blockEnd) {
+      // Whole block: the header is enough
+      include(m_blocks.at(block).minY, m_blocks.at(block).maxY);
+    } else {
+      decoded.resize(BlockSize);
+      decode(m_blocks.at(block).bits, BlockSize, decoded.data());
+      for (qint64 i = index; i < end; ++i) {
+        const double y = decoded.at(int(i - blockStart)).y();
+        include(y, y);
+      }
+    }
+    index = end;
+  }
+  return found;
+}
+
+bool CompressedSeries::xRange(double &minX, double &maxX) const {
+  if (count() == 0) {
+    return false;
+  }
+  minX = m_blocks.isEmpty() ? m_tail.first().x() : m_blocks.first().xFirst;
+  maxX = m_tail.isEmpty() ? m_blocks.last().xLast : m_tail.last().x();
+  return true;
+}
+
+qint64 CompressedSeries::readPoints(qint64 first, qint64 count,
+                                    QPointF *out) const {
+  first = qMax<qint64>(first, 0);
+  const qint64 last = qMin(first + count, this->count());
+  QVector<QPointF> decoded;
+
+  qint64 index = first;
+  while (index < last) {
+    const int block = int(index / BlockSize);
+    const qint64 blockStart = qint64(block) * BlockSize;
+    if (block >= m_blocks.size()) {
+      std::memcpy(out, m_tail.constData() + (index - blockStart),
+                  size_t(last - index) * sizeof(QPointF));
+      out += last - index;
+      break;
+    }
+
+    const qint64 end = qMin(last, blockStart + BlockSize);
+    if (index == blockStart && end - index == BlockSize) {
+      // Decode straight into the caller's buffer
+      decode(m_blocks.at(block).bits, BlockSize, out);
+    } else {
+      decoded.resize(BlockSize);
+      decode(m_blocks.at(block).bits, BlockSize, decoded.data());
+      std::memcpy(out, decoded.constData() + (index - blockStart),
+                  size_t(end - index) * sizeof(QPointF));
+    }
+    out += end - index;
+    index = end;
+  }
+  return qMax<qint64>(last - first, 0);
+}
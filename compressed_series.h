@@ -0,0 +1,76 @@
+#ifndef COMPRESSED_SERIES_H
+#define COMPRESSED_SERIES_H
+
+#include "series_data_source.h"
+#include <QMutex>
+#include <QVector>
+
+// Append-only series stored in compressed blocks, in the style of
+// Facebook's Gorilla time-series encoding:
+//   x - delta-of-delta of the IEEE-754 bit patterns, so evenly sampled x
+//       costs about one bit per point and nothing is lost
+//   y - XOR with the previous value, storing only the meaningful bits
+// Points arrive in an uncompressed tail and are sealed into a block every
+// BlockSize points. Each block header keeps its x span and y min/max, so
+// lowerBound() and yRange() skip whole blocks without decoding them.
+// Samples must be appended in ascending x.
+class CompressedSeries : public SeriesDataSource {
+public:
+    static const int BlockSize = 1024;
+
+    CompressedSeries();
+
+    void append(const QPointF &point);
+    void append(const QPointF *points, int count);
+    void clear();
+
+    // Drops the oldest sealed blocks until at least 'bytes' of encoded data
+    // are freed (the tail is kept). Their points are decoded into 'evicted'
+    // when given. Returns the number of points removed.
+    qint64 removeOldest(qint64 bytes, QVector<QPointF> *evicted = nullptr);
+
+    // Encoded blocks plus the tail, in bytes
+    qint64 memoryUsage() const override;
+    // Block headers
+    qint64 indexMemoryUsage() const override;
+    // The block pointAt() keeps decoded
+    qint64 cacheMemoryUsage() const;
+
+    qint64 count() const override;
+    QPointF pointAt(qint64 index) const override;
+    qint64 lowerBound(double x) const override;
+    bool yRange(qint64 first, qint64 last, double &minY,
+                double &maxY) const override;
+    bool xRange(double &minX, double &maxX) const override;
+    qint64 readPoints(qint64 first, qint64 count,
+                      QPointF *out) const override;
+
+private:
+    struct Block {
+        double xFirst, xLast;
+        double minY, maxY;
+        QVector<quint64> bits;
+    };
+
+    void sealTail();
+    static qint64 blockBytes(const Block &block);
+    static void encode(const QPointF *points, int count,
+                       QVector<quint64> &bits);
+    static void decode(const QVector<quint64> &bits, int count, QPointF *out);
+
+    QVector<Block> m_blocks;
+    QVector<QPointF> m_tail;
+    // Sum of blockBytes() over m_blocks, so accounting is O(1)
+    qint64 m_encodedBytes;
+
+    // Extent of everything appended so far
+    double m_minY, m_maxY;
+
+    // pointAt() decodes a whole block; the last one is kept for the next
+    // call. Guarded so pointAt() stays safe to call from several threads.
+    mutable QMutex m_cacheMutex;
+    mutable int m_cachedBlock;
+    mutable QVector<QPointF> m_cache;
+};
+
+#endif // COMPRESSED_SERIES_H
@@ -0,0 +1,163 @@
+// Checks that CompressedSeries gives back exactly what was appended: every
+// x and y bit pattern survives the Gorilla-style encoding, for regular and
+// irregular x, special y values and every delta-of-delta bucket, and
+// removeOldest() hands back the evicted blocks intact.
+// Exits non-zero on the first failure.
+#include "compressed_series.h"
+#include <QDebug>
+#include <QPointF>
+#include <QVector>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+static quint64 bitsOf(double value) {
+  quint64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static double doubleOf(quint64 bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static bool samePoint(const QPointF &a, const QPointF &b) {
+  return bitsOf(a.x()) == bitsOf(b.x()) && bitsOf(a.y()) == bitsOf(b.y());
+}
+
+// Appends 'points' and reads them back through pointAt() and readPoints()
+static void roundTrip(const QVector<QPointF> &points, const char *what) {
+  CompressedSeries series;
+  series.append(points.constData(), points.size());
+  if (series.count() != points.size()) {
+    check(false, what);
+    return;
+  }
+
+  bool ok = true;
+  for (int i = 0; i < points.size(); ++i) {
+    ok = ok && samePoint(series.pointAt(i), points[i]);
+  }
+  QVector<QPointF> read(points.size());
+  ok = ok && series.readPoints(0, read.size(), read.data()) == read.size();
+  for (int i = 0; i < points.size(); ++i) {
+    ok = ok && samePoint(read[i], points[i]);
+  }
+  check(ok, what);
+}
+
+static void evenlySpaced() {
+  QVector<QPointF> points;
+  for (int i = 0; i < 5 * CompressedSeries::BlockSize + 100; ++i) {
+    points.append(QPointF(1000.0 + i * 0.001, std::sin(i * 0.01)));
+  }
+  roundTrip(points, "evenly spaced x round-trips");
+}
+
+static void irregular() {
+  QVector<QPointF> points;
+  quint32 state = 12345;
+  double x = -50.0;
+  for (int i = 0; i < 3 * CompressedSeries::BlockSize + 7; ++i) {
+    state = state * 1664525u + 1013904223u;
+    x += (state >> 8) * 1e-6;
+    points.append(QPointF(x, double(int(state % 20001) - 10000) / 7.0));
+  }
+  roundTrip(points, "irregular x round-trips");
+}
+
+static void specialValues() {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double values[] = {0.0,  -0.0, nan, 1.5,  -inf, inf,
+                           -0.0, nan,  nan, -1.5, 0.0,  1e-310};
+  QVector<QPointF> points;
+  for (int i = 0; i < 2 * CompressedSeries::BlockSize + 3; ++i) {
+    points.append(QPointF(i, values[i % 12]));
+  }
+  roundTrip(points, "NaN, +-inf and -0.0 y round-trip bit for bit");
+}
+
+static void deltaOfDeltaBuckets() {
+  // x bit patterns whose delta changes by exactly each bucket boundary
+  const qint64 dods[] = {0,     1,    -63,   64,       -64,     65,
+                         -255,  256,  -256,  257,      -2047,   2048,
+                         -2048, 2049, 0,     -1000000, 1000000, 0};
+  QVector<QPointF> points;
+  quint64 x = bitsOf(1.0);
+  quint64 delta = 1 << 24;
+  points.append(QPointF(doubleOf(x), 0.0));
+  for (int round = 0; round < 100; ++round) {
+    for (qint64 dod : dods) {
+      delta += quint64(dod);
+      x += delta;
+      points.append(QPointF(doubleOf(x), points.size()));
+    }
+  }
+  roundTrip(points, "delta-of-delta bucket boundaries round-trip");
+}
+
+static void removeOldest() {
+  QVector<QPointF> points;
+  const int blocks = 6;
+  for (int i = 0; i < blocks * CompressedSeries::BlockSize + 100; ++i) {
+    points.append(QPointF(i * 0.5, i % 97));
+  }
+  CompressedSeries series;
+  series.append(points.constData(), points.size());
+
+  // Any positive byte count frees at least one block
+  QVector<QPointF> evicted;
+  const qint64 removed = series.removeOldest(1, &evicted);
+  check(removed == CompressedSeries::BlockSize &&
+            evicted.size() == CompressedSeries::BlockSize,
+        "removeOldest drops whole blocks");
+
+  const qint64 more = series.removeOldest(series.memoryUsage(), &evicted);
+  check(more == (blocks - 1) * CompressedSeries::BlockSize,
+        "removeOldest keeps the tail");
+  check(evicted.size() == blocks * CompressedSeries::BlockSize,
+        "evicted points are appended");
+
+  bool ok = true;
+  for (int i = 0; i < evicted.size(); ++i) {
+    ok = ok && samePoint(evicted[i], points[i]);
+  }
+  check(ok, "evicted points are the oldest, in order");
+
+  ok = series.count() == 100;
+  for (int i = 0; ok && i < series.count(); ++i) {
+    ok = samePoint(series.pointAt(i), points[evicted.size() + i]);
+  }
+  check(ok, "points after eviction are unchanged");
+
+  double minY = 0.0, maxY = 0.0;
+  check(series.yRange(0, series.count(), minY, maxY) && minY == 0.0 &&
+            maxY == 96.0,
+        "extent follows eviction");
+}
+
+int main() {
+  evenlySpaced();
+  irregular();
+  specialValues();
+  deltaOfDeltaBuckets();
+  removeOldest();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "CompressedSeries round-trip checks passed";
+  return 0;
+}
@@ -0,0 +1,208 @@
+#include "density_raster.h"
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+static const int MaxDensityThreads = 8;
+static const int SourceChunkPoints = 4096;
+
+// Bins one slice of the input into its own histogram on a pool thread
+class DensityBinTask : public QRunnable {
+public:
+  DensityBinTask(const std::function<void(qint64, qint64, quint32 *)> &bin,
+                 qint64 begin, qint64 end, quint32 *bins, QSemaphore *done)
+      : m_bin(bin), m_begin(begin), m_end(end), m_bins(bins), m_done(done) {
+    setAutoDelete(false);
+  }
+
+  void run() override {
+    m_bin(m_begin, m_end, m_bins);
+    m_done->release();
+  }
+
+private:
+  const std::function<void(qint64, qint64, quint32 *)> &m_bin;
+  qint64 m_begin;
+  qint64 m_end;
+  quint32 *m_bins;
+  QSemaphore *m_done;
+};
+
+DensityRaster::DensityRaster() : m_width(0), m_height(0) {}
+
+void DensityRaster::reset(const QSize &size) {
+  m_width = qMax(size.width(), 0);
+  m_height = qMax(size.height(), 0);
+  m_bins.fill(0, m_width * m_height);
+}
+
+QSize DensityRaster::size() const { return QSize(m_width, m_height); }
+
+void DensityRaster::accumulate(const QPointF *points, int count,
+                               const QPointF &scale, const QPointF &offset) {
+  if (count <= 0 || m_bins.isEmpty()) {
+    return;
+  }
+
+  const int w = m_width;
+  const int h = m_height;
+  binParallel(count, [=](qint64 begin, qint64 end, quint32 *bins) {
+    for (qint64 i = begin; i < end; ++i) {
+      const double x = offset.x() + points[i].x() * scale.x();
+      const double y = offset.y() + points[i].y() * scale.y();
+      // Written so that NaN coordinates fail the test
+      if (x >= 0.0 && x < w && y >= 0.0 && y < h) {
+        ++bins[int(y) * w + int(x)];
+      }
+    }
+  });
+}
+
+void DensityRaster::accumulate(const SeriesDataSource &source, qint64 first,
+                               qint64 last, const QPointF &scale,
+                               const QPointF &offset) {
+  first = qMax<qint64>(first, 0);
+  last = qMin(last, source.count());
+  if (last <= first || m_bins.isEmpty()) {
+    return;
+  }
+
+  const int w = m_width;
+  const int h = m_height;
+  const SeriesDataSource *src = &source;
+  binParallel(last - first, [=](qint64 begin, qint64 end, quint32 *bins) {
+    // Bulk reads let block-encoded sources decode whole blocks at once
+    QPointF chunk[SourceChunkPoints];
+    for (qint64 i = first + begin; i < first + end; i += SourceChunkPoints) {
+      const int n = int(src->readPoints(
+          i, qMin<qint64>(SourceChunkPoints, first + end - i), chunk));
+      for (int k = 0; k < n; ++k) {
+        const double x = offset.x() + chunk[k].x() * scale.x();
+        const double y = offset.y() + chunk[k].y() * scale.y();
+        if (x >= 0.0 && x < w && y >= 0.0 && y < h) {
+          ++bins[int(y) * w + int(x)];
+        }
+      }
+    }
+  });
+}
+
+void DensityRaster::binParallel(qint64 count, const BinFunction &bin) {
+  // Workers come from the global pool, so painting starts no threads
+  QThreadPool *pool = QThreadPool::globalInstance();
+  int threads = 1;
+  if (count >= ParallelThreshold) {
+    threads = qBound(1, pool->maxThreadCount(), MaxDensityThreads);
+    threads = int(qMin<qint64>(threads, count / (ParallelThreshold / 4)));
+  }
+  if (threads <= 1) {
+    bin(0, count, m_bins.data());
+    return;
+  }
+
+  // The calling thread takes the first slice straight into m_bins
+  const int binCount = m_bins.size();
+  m_threadBins.resize(threads - 1);
+  QSemaphore done;
+  std::vector<std::unique_ptr<DensityBinTask>> tasks;
+  for (int t = 1; t < threads; ++t) {
+    QVector<quint32> &local = m_threadBins[t - 1];
+    local.fill(0, binCount);
+    tasks.emplace_back(new DensityBinTask(bin, count * t / threads,
+                                          count * (t + 1) / threads,
+                                          local.data(), &done));
+    pool->start(tasks.back().get());
+  }
+  bin(0, count / threads, m_bins.data());
+
+  // Slices still queued behind other pool work run here instead
+  for (auto &task : tasks) {
+    if (pool->tryTake(task.get())) {
+      task->run();
+    }
+  }
+  done.acquire(threads - 1);
+
+  quint32 *bins = m_bins.data();
+  for (int t = 1; t < threads; ++t) {
+    const quint32 *local = m_threadBins[t - 1].constData();
+    for (int i = 0; i < binCount; ++i) {
+      bins[i] += local[i];
+    }
+  }
+}
+
+void DensityRaster::buildColorTable(const QColor &color) {
+  m_tableColor = color;
+  m_colorTable.resize(256);
+  m_colorTable[0] = 0;
+  for (int i = 1; i < 256; ++i) {
+    const double t = i / 255.0;
+    // Faint at one hit, full colour at the peak, the densest cells
+    // lightened so they stand out
+    const double alpha = 0.25 + 0.75 * t;
+    const double white = qMax(0.0, (t - 0.7) / 0.3) * 0.6;
+    const double r = color.redF() + (1.0 - color.redF()) * white;
+    const double g = color.greenF() + (1.0 - color.greenF()) * white;
+    const double b = color.blueF() + (1.0 - color.blueF()) * white;
+    // Premultiplied for Format_ARGB32_Premultiplied
+    m_colorTable[i] = qRgba(int(r * alpha * 255.0), int(g * alpha * 255.0),
+                            int(b * alpha * 255.0), int(alpha * 255.0));
+  }
+}
+
+const QImage &DensityRaster::image(const QColor &color) {
+  if (m_colorTable.isEmpty() || color != m_tableColor) {
+    buildColorTable(color);
+  }
+  if (m_image.width() != m_width || m_image.height() != m_height) {
+    m_image = QImage(m_width, m_height, QImage::Format_ARGB32_Premultiplied);
+  }
+  if (m_bins.isEmpty()) {
+    return m_image;
+  }
+
+  quint32 maxCount = 0;
+  for (quint32 count : m_bins) {
+    maxCount = qMax(maxCount, count);
+  }
+
+  // Colour index of small counts, the common case, without a log per pixel
+  const double norm = maxCount > 1 ? 254.0 / std::log(double(maxCount)) : 0.0;
+  int smallIndex[256];
+  for (int c = 1; c < 256; ++c) {
+    smallIndex[c] =
+        maxCount > 1 ? qMin(255, 1 + int(std::log(double(c)) * norm)) : 255;
+  }
+
+  const QRgb *table = m_colorTable.constData();
+  const quint32 *bins = m_bins.constData();
+  for (int y = 0; y < m_height; ++y) {
+    QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(y));
+    const quint32 *row = bins + y * m_width;
+    for (int x = 0; x < m_width; ++x) {
+      const quint32 c = row[x];
+      if (c == 0) {
+        line[x] = 0;
+      } else if (c < 256) {
+        line[x] = table[smallIndex[c]];
+      } else {
+        line[x] = table[qMin(255, 1 + int(std::log(double(c)) * norm))];
+      }
+    }
+  }
+  return m_image;
+}
+
+qint64 DensityRaster::memoryUsage() const {
+  qint64 bytes = qint64(m_bins.capacity()) * qint64(sizeof(quint32)) +
+                 qint64(m_colorTable.capacity()) * qint64(sizeof(QRgb)) +
+                 m_image.sizeInBytes();
+  for (const QVector<quint32> &bins : m_threadBins) {
+    bytes += qint64(bins.capacity()) * qint64(sizeof(quint32));
+  }
+  return bytes;
+}
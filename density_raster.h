@@ -0,0 +1,56 @@
+#ifndef DENSITY_RASTER_H
+#define DENSITY_RASTER_H
+
+#include "series_data_source.h"
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+#include <functional>
+
+// Pixel-resolution 2D histogram of a series, drawn as a colour-mapped
+// image. Binning is O(N) with one increment per point and is split across
+// pool threads for large inputs, each filling its own histogram that is
+// summed afterwards; drawing is O(pixels) regardless of the point count.
+class DensityRaster {
+public:
+    // Below this many points a frame is binned on the calling thread
+    static const int ParallelThreshold = 200000;
+
+    DensityRaster();
+
+    // Clears the histogram and sizes it to the plot area
+    void reset(const QSize &size);
+    QSize size() const;
+
+    // Bins points mapped by pixel = offset + point * scale (per component,
+    // relative to the plot's top-left corner); points outside are dropped
+    void accumulate(const QPointF *points, int count, const QPointF &scale,
+                    const QPointF &offset);
+    void accumulate(const SeriesDataSource &source, qint64 first, qint64 last,
+                    const QPointF &scale, const QPointF &offset);
+
+    // Counts on a log scale, from transparent to the series colour
+    const QImage &image(const QColor &color);
+
+    // Histograms, per-thread scratch and the rendered image, in bytes
+    qint64 memoryUsage() const;
+
+private:
+    typedef std::function<void(qint64, qint64, quint32 *)> BinFunction;
+    void binParallel(qint64 count, const BinFunction &bin);
+    void buildColorTable(const QColor &color);
+
+    int m_width;
+    int m_height;
+    QVector<quint32> m_bins;
+    // Per-thread histograms, kept to avoid reallocating every frame
+    QVector<QVector<quint32>> m_threadBins;
+
+    QColor m_tableColor;
+    QVector<QRgb> m_colorTable;
+    QImage m_image;
+};
+
+#endif // DENSITY_RASTER_H
@@ -0,0 +1,322 @@
+#include "derived_series.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+#include <QtMath>
+#include <cmath>
+
+// Keeps the newest samples and transforms them whenever new ones arrive;
+// bursts that come faster than the FFT are coalesced into one transform
+class SpectrumThread : public QThread {
+public:
+  SpectrumThread(DerivedSeries *owner, int length)
+      : m_owner(owner), m_length(length), m_generation(0), m_restart(true),
+        m_stop(false) {}
+
+  void configure(int generation) {
+    QMutexLocker locker(&m_mutex);
+    m_generation = generation;
+    m_pending.resize(0);
+    m_restart = true;
+  }
+
+  void feed(const QPointF *points, int count) {
+    QMutexLocker locker(&m_mutex);
+    // Only the newest m_length samples can reach the next transform
+    if (count >= m_length) {
+      m_pending.resize(0);
+      points += count - m_length;
+      count = m_length;
+    } else if (m_pending.size() + count > m_length) {
+      m_pending.remove(0, m_pending.size() + count - m_length);
+    }
+    for (int i = 0; i < count; ++i) {
+      m_pending.append(points[i]);
+    }
+    m_wake.wakeOne();
+  }
+
+  void stop() {
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_wake.wakeOne();
+  }
+
+protected:
+  void run() override {
+    QVector<QPointF> batch;
+    int generation = 0;
+    for (;;) {
+      {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stop && m_pending.isEmpty()) {
+          m_wake.wait(&m_mutex);
+        }
+        if (m_stop) {
+          return;
+        }
+        batch.swap(m_pending);
+        m_pending.resize(0);
+        if (m_restart) {
+          m_restart = false;
+          m_samples.resize(0);
+        }
+        generation = m_generation;
+      }
+
+      m_samples += batch;
+      if (m_samples.size() > m_length) {
+        m_samples.remove(0, m_samples.size() - m_length);
+      }
+      if (m_samples.size() < m_length) {
+        continue;
+      }
+
+      QVector<QPointF> spectrum;
+      if (transform(spectrum)) {
+        DerivedSeries *owner = m_owner;
+        QMetaObject::invokeMethod(
+            owner,
+            [owner, spectrum, generation]() {
+              owner->deliverSpectrum(spectrum, generation);
+            },
+            Qt::QueuedConnection);
+      }
+    }
+  }
+
+private:
+  void prepare() {
+    const int n = m_length;
+    m_hann.resize(n);
+    m_hannSum = 0.0;
+    for (int i = 0; i < n; ++i) {
+      m_hann[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (n - 1));
+      m_hannSum += m_hann.at(i);
+    }
+    m_cos.resize(n / 2);
+    m_sin.resize(n / 2);
+    for (int i = 0; i < n / 2; ++i) {
+      m_cos[i] = std::cos(2.0 * M_PI * i / n);
+      m_sin[i] = std::sin(2.0 * M_PI * i / n);
+    }
+    int bits = 0;
+    while ((1 << bits) < n) {
+      ++bits;
+    }
+    m_reversed.resize(n);
+    for (int i = 0; i < n; ++i) {
+      int r = 0;
+      for (int b = 0; b < bits; ++b) {
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      }
+      m_reversed[i] = r;
+    }
+  }
+
+  // Amplitude spectrum of m_samples, x in cycles per x unit
+  bool transform(QVector<QPointF> &spectrum) {
+    const int n = m_length;
+    const double span = m_samples.last().x() - m_samples.first().x();
+    if (!(span > 0.0)) {
+      return false;
+    }
+    if (m_hann.size() != n) {
+      prepare();
+    }
+
+    m_re.resize(n);
+    m_im.fill(0.0, n);
+    for (int i = 0; i < n; ++i) {
+      m_re[m_reversed.at(i)] = m_samples.at(i).y() * m_hann.at(i);
+    }
+
+    // Iterative radix-2 decimation in time
+    double *re = m_re.data();
+    double *im = m_im.data();
+    for (int size = 2; size <= n; size *= 2) {
+      const int half = size / 2;
+      const int step = n / size;
+      for (int start = 0; start < n; start += size) {
+        for (int k = 0; k < half; ++k) {
+          const double wr = m_cos.at(k * step);
+          const double wi = -m_sin.at(k * step);
+          const int a = start + k;
+          const int b = a + half;
+          const double tr = re[b] * wr - im[b] * wi;
+          const double ti = re[b] * wi + im[b] * wr;
+          re[b] = re[a] - tr;
+          im[b] = im[a] - ti;
+          re[a] += tr;
+          im[a] += ti;
+        }
+      }
+    }
+
+    // Scaled so a full-scale sine reads its amplitude
+    const double rate = (n - 1) / span;
+    const double scale = 2.0 / m_hannSum;
+    spectrum.resize(n / 2 + 1);
+    for (int k = 0; k <= n / 2; ++k) {
+      double amplitude = std::sqrt(re[k] * re[k] + im[k] * im[k]) * scale;
+      if (k == 0 || k == n / 2) {
+        amplitude *= 0.5;
+      }
+      spectrum[k] = QPointF(k * rate / n, amplitude);
+    }
+    return true;
+  }
+
+  DerivedSeries *m_owner;
+  const int m_length;
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  QVector<QPointF> m_pending;
+  int m_generation;
+  bool m_restart;
+  bool m_stop;
+
+  // Touched only by the worker
+  QVector<QPointF> m_samples;
+  QVector<double> m_hann;
+  double m_hannSum;
+  QVector<double> m_cos;
+  QVector<double> m_sin;
+  QVector<int> m_reversed;
+  QVector<double> m_re;
+  QVector<double> m_im;
+};
+
+DerivedSeries::DerivedSeries(const QString &sourceName,
+                             DerivedOperation operation, int length,
+                             QObject *parent)
+    : QObject(parent), m_sourceName(sourceName), m_operation(operation),
+      m_length(qMax(length, 1)), m_fedSamples(0), m_windowHead(0),
+      m_windowCount(0), m_windowSum(0.0), m_sinceResum(0),
+      m_hasPrevious(false), m_thread(nullptr), m_generation(0) {
+  if (m_operation == MovingAverage) {
+    m_window.resize(m_length);
+  } else if (m_operation == Spectrum) {
+    int size = 8;
+    while (size < m_length && size < (1 << 24)) {
+      size *= 2;
+    }
+    m_length = size;
+    m_thread = new SpectrumThread(this, m_length);
+    m_thread->start();
+  }
+}
+
+DerivedSeries::~DerivedSeries() {
+  if (m_thread != nullptr) {
+    m_thread->stop();
+    m_thread->wait();
+    delete m_thread;
+  }
+}
+
+QString DerivedSeries::sourceName() const { return m_sourceName; }
+
+DerivedOperation DerivedSeries::operation() const { return m_operation; }
+
+int DerivedSeries::length() const { return m_length; }
+
+qint64 DerivedSeries::fedSamples() const { return m_fedSamples; }
+
+void DerivedSeries::setFedSamples(qint64 samples) { m_fedSamples = samples; }
+
+void DerivedSeries::process(const QPointF *points, int count,
+                            QVector<QPointF> &output) {
+  if (count <= 0) {
+    return;
+  }
+
+  if (m_operation == Spectrum) {
+    // Only what follows the last step back in x belongs to the new run
+    int first = 0;
+    for (int i = count - 1; i > 0; --i) {
+      if (points[i].x() < points[i - 1].x()) {
+        first = i;
+        break;
+      }
+    }
+    if (first > 0 || (m_hasPrevious && points[0].x() < m_previous.x())) {
+      reset();
+    }
+    m_thread->feed(points + first, count - first);
+    m_previous = points[count - 1];
+    m_hasPrevious = true;
+    return;
+  }
+
+  output.reserve(output.size() + count);
+  for (int i = 0; i < count; ++i) {
+    const QPointF &point = points[i];
+    if (m_hasPrevious && point.x() < m_previous.x()) {
+      reset();
+    }
+
+    if (m_operation == MovingAverage) {
+      if (m_windowCount == m_length) {
+        m_windowSum -= m_window.at(m_windowHead);
+      } else {
+        ++m_windowCount;
+      }
+      m_window[m_windowHead] = point.y();
+      m_windowSum += point.y();
+      m_windowHead = (m_windowHead + 1) % m_length;
+      if (++m_sinceResum >= m_length) {
+        m_windowSum = 0.0;
+        for (int j = 0; j < m_windowCount; ++j) {
+          m_windowSum += m_window.at(j);
+        }
+        m_sinceResum = 0;
+      }
+      output.append(QPointF(point.x(), m_windowSum / m_windowCount));
+    } else if (m_hasPrevious && point.x() > m_previous.x()) {
+      output.append(QPointF(point.x(), (point.y() - m_previous.y()) /
+                                           (point.x() - m_previous.x())));
+    }
+
+    m_previous = point;
+    m_hasPrevious = true;
+  }
+}
+
+void DerivedSeries::reset() {
+  m_windowHead = m_windowCount = m_sinceResum = 0;
+  m_windowSum = 0.0;
+  m_hasPrevious = false;
+  if (m_thread != nullptr) {
+    m_thread->configure(++m_generation);
+  }
+}
+
+QVector<QPointF> DerivedSeries::takeSpectrum() {
+  QVector<QPointF> spectrum;
+  spectrum.swap(m_spectrum);
+  return spectrum;
+}
+
+qint64 DerivedSeries::memoryUsage() const {
+  qint64 bytes = qint64(m_window.capacity()) * qint64(sizeof(double)) +
+                 qint64(m_spectrum.capacity()) * qint64(sizeof(QPointF));
+  if (m_thread != nullptr) {
+    // Worker: sample window, Hann and twiddle tables, FFT buffers
+    bytes += qint64(m_length) * qint64(sizeof(QPointF) + 5 * sizeof(double) +
+                                       sizeof(int));
+  }
+  return bytes;
+}
+
+void DerivedSeries::deliverSpectrum(const QVector<QPointF> &spectrum,
+                                    int generation) {
+  // Spectra of data from before a restart are stale
+  if (generation != m_generation) {
+    return;
+  }
+  m_spectrum = spectrum;
+  emit spectrumReady();
+}
@@ -0,0 +1,82 @@
+#ifndef DERIVED_SERIES_H
+#define DERIVED_SERIES_H
+
+#include <QObject>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+class SpectrumThread;
+
+enum DerivedOperation {
+    MovingAverage,  // mean of the last 'length' samples
+    Derivative,     // dy/dx between consecutive samples
+    Spectrum        // FFT amplitude of the newest 'length' samples
+};
+
+// A series computed from another one as its data arrives. Only samples
+// appended since the last update are processed: the moving average and
+// the derivative in O(1) per sample on the caller's thread, producing
+// points to append; the spectrum queues them for a worker thread, which
+// recomputes a Hann-windowed FFT over the newest samples and signals
+// spectrumReady() with a replacement for the whole series.
+class DerivedSeries : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 'length' is the moving-average window or the FFT size (rounded up
+    // to a power of two); the derivative ignores it
+    DerivedSeries(const QString &sourceName, DerivedOperation operation,
+                  int length, QObject *parent = nullptr);
+    ~DerivedSeries();
+
+    QString sourceName() const;
+    DerivedOperation operation() const;
+    int length() const;
+
+    // Source samples already processed, counted like
+    // DataSeries::samplesAppended
+    qint64 fedSamples() const;
+    void setFedSamples(qint64 samples);
+
+    // Takes new source samples in ascending x; a step back in x restarts
+    // the computation. Filter output is appended to 'output'.
+    void process(const QPointF *points, int count, QVector<QPointF> &output);
+    void reset();
+
+    // The spectrum announced by the last spectrumReady()
+    QVector<QPointF> takeSpectrum();
+
+    qint64 memoryUsage() const;
+
+signals:
+    void spectrumReady();
+
+private:
+    friend class SpectrumThread;
+    void deliverSpectrum(const QVector<QPointF> &spectrum, int generation);
+
+    QString m_sourceName;
+    DerivedOperation m_operation;
+    int m_length;
+    qint64 m_fedSamples;
+
+    // Moving average: ring of the last m_length values and their sum,
+    // recomputed once per window so rounding errors cannot accumulate
+    QVector<double> m_window;
+    int m_windowHead;
+    int m_windowCount;
+    double m_windowSum;
+    int m_sinceResum;
+
+    bool m_hasPrevious;
+    QPointF m_previous;
+
+    SpectrumThread *m_thread;
+    int m_generation;
+    QVector<QPointF> m_spectrum;
+};
+
+#endif // DERIVED_SERIES_H
@@ -0,0 +1,113 @@
+#include "log_column.h"
+#include <cmath>
+#include <limits>
+
+LogColumn::LogColumn(Coordinate coordinate)
+    : m_coordinate(coordinate), m_enabled(false), m_syncedSamples(0),
+      m_rangeValid(false), m_min(0.0), m_max(0.0) {}
+
+bool LogColumn::isEnabled() const { return m_enabled; }
+
+void LogColumn::setEnabled(bool enabled) {
+  if (enabled == m_enabled) {
+    return;
+  }
+  m_enabled = enabled;
+  // Released rather than kept stale; the next sync rebuilds it
+  m_values = RingBuffer<double>();
+  m_syncedSamples = 0;
+  m_rangeValid = false;
+}
+
+void LogColumn::sync(const RingBuffer<QPointF> &points,
+                     qint64 samplesAppended) {
+  if (!m_enabled) {
+    return;
+  }
+
+  // Same bookkeeping as the range statistics: the newest samples are new,
+  // anything no longer held was evicted from the front
+  const int count = points.size();
+  qint64 added = samplesAppended - m_syncedSamples;
+  const qint64 evicted = m_values.size() + added - count;
+  if (m_values.capacity() != points.capacity() || added < 0 ||
+      added > count || evicted < 0) {
+    m_values = RingBuffer<double>();
+    m_values.setCapacity(points.capacity());
+    m_rangeValid = false;
+    added = count;
+  } else if (evicted > 0) {
+    for (int i = 0; i < evicted && m_rangeValid; ++i) {
+      const double value = m_values.at(i);
+      if (std::isfinite(value) && (value <= m_min || value >= m_max)) {
+        m_rangeValid = false;
+      }
+    }
+    m_values.removeFirst(int(evicted));
+  }
+  if (m_values.isEmpty()) {
+    m_rangeValid = true;
+    m_min = std::numeric_limits<double>::infinity();
+    m_max = -std::numeric_limits<double>::infinity();
+  }
+
+  // Gathered into contiguous blocks so the logarithm runs over plain arrays
+  double in[512];
+  double out[512];
+  for (int index = count - int(added); index < count;) {
+    const int n = qMin(512, count - index);
+    if (m_coordinate == X) {
+      for (int i = 0; i < n; ++i) {
+        in[i] = points.at(index + i).x();
+      }
+    } else {
+      for (int i = 0; i < n; ++i) {
+        in[i] = points.at(index + i).y();
+      }
+    }
+    transform(in, out, n);
+    if (m_rangeValid) {
+      for (int i = 0; i < n; ++i) {
+        if (std::isfinite(out[i])) {
+          m_min = qMin(m_min, out[i]);
+          m_max = qMax(m_max, out[i]);
+        }
+      }
+    }
+    m_values.append(out, n);
+    index += n;
+  }
+  m_syncedSamples = samplesAppended;
+}
+
+int LogColumn::size() const { return m_values.size(); }
+
+double LogColumn::at(int i) const { return m_values.at(i); }
+
+bool LogColumn::range(double &min, double &max) {
+  if (!m_rangeValid) {
+    m_min = std::numeric_limits<double>::infinity();
+    m_max = -std::numeric_limits<double>::infinity();
+    for (const double value : m_values) {
+      if (std::isfinite(value)) {
+        m_min = qMin(m_min, value);
+        m_max = qMax(m_max, value);
+      }
+    }
+    m_rangeValid = true;
+  }
+  if (!(m_min <= m_max)) {
+    return false;
+  }
+  min = m_min;
+  max = m_max;
+  return true;
+}
+
+qint64 LogColumn::memoryUsage() const { return m_values.memoryUsage(); }
+
+void LogColumn::transform(const double *in, double *out, int count) {
+  for (int i = 0; i < count; ++i) {
+    out[i] = std::log10(in[i]);
+  }
+}
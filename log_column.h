@@ -0,0 +1,50 @@
+#ifndef LOG_COLUMN_H
+#define LOG_COLUMN_H
+
+#include "ring_buffer.h"
+#include <QPointF>
+#include <QtGlobal>
+
+// log10 of one coordinate of a series' points, for logarithmic axes.
+// Computed once per sample as points arrive and evicted in step with them,
+// so drawing and autoscaling a log axis read cached values instead of
+// taking a logarithm per point per frame. Values <= 0 become -inf or NaN,
+// which fail every visibility test and leave gaps. The range of the finite
+// values is kept up to date for autoscale; it is rescanned (without any
+// logarithm) only when an evicted value was one of its ends.
+class LogColumn {
+public:
+    enum Coordinate { X, Y };
+
+    explicit LogColumn(Coordinate coordinate = Y);
+
+    // A disabled column holds nothing
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    // Catches up with 'points' after samples were appended or evicted;
+    // 'samplesAppended' counts like DataSeries::samplesAppended. Rebuilds
+    // when the counts do not add up (replaced data).
+    void sync(const RingBuffer<QPointF> &points, qint64 samplesAppended);
+
+    int size() const;
+    double at(int i) const;
+    // Range of the finite values; false if there are none
+    bool range(double &min, double &max);
+
+    qint64 memoryUsage() const;
+
+    // out[i] = log10(in[i]), a plain loop the compiler can vectorize
+    static void transform(const double *in, double *out, int count);
+
+private:
+    Coordinate m_coordinate;
+    bool m_enabled;
+    RingBuffer<double> m_values;
+    qint64 m_syncedSamples;
+    bool m_rangeValid;
+    double m_min;
+    double m_max;
+};
+
+#endif // LOG_COLUMN_H
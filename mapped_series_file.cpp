@@ -0,0 +1,419 @@
+#include "mapped_series_file.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const quint32 kOverviewMagic = 0x564f5958; // "XYOV"
+static const quint32 kOverviewVersion = 1;
+
+struct OverviewHeader {
+  quint32 magic;
+  quint32 version;
+  quint32 blockSize;
+  quint32 fanout;
+  qint64 sourceSize;
+  qint64 sourceModified; // ms since epoch
+  qint64 sampleCount;
+};
+
+static QVector<qint64> overviewLevelSizes(qint64 sampleCount) {
+  QVector<qint64> sizes;
+  qint64 blocks = (sampleCount + MappedSeriesFile::OverviewBlockSize - 1) /
+                  MappedSeriesFile::OverviewBlockSize;
+  while (blocks > 0) {
+    sizes.append(blocks);
+    if (blocks == 1) {
+      break;
+    }
+    blocks = (blocks + MappedSeriesFile::OverviewFanout - 1) /
+             MappedSeriesFile::OverviewFanout;
+  }
+  return sizes;
+}
+
+static qint64 sampleCountFor(qint64 fileSize, MappedSeriesFile::Layout layout) {
+  qint64 bytesPerSample = layout == MappedSeriesFile::XYColumns
+                              ? 2 * qint64(sizeof(double))
+                              : qint64(sizeof(double));
+  return fileSize / bytesPerSample;
+}
+
+// Mapped overview levels: levels[k] points at min/max pairs of level k
+struct MappedOverview {
+  QFile file;
+  QVector<const double *> levels;
+  QVector<qint64> levelSizes;
+};
+
+static bool writeOverview(const QString &path,
+                          MappedSeriesFile::Layout layout,
+                          const QAtomicInt *cancelled);
+static MappedOverview *mapOverview(const QString &path, qint64 count);
+
+// Builds and maps a missing overview off the GUI thread, then publishes it
+// through the file's atomic pointer; rendering scans raw samples meanwhile
+class OverviewBuildThread : public QThread {
+public:
+  OverviewBuildThread(const QString &path, MappedSeriesFile::Layout layout,
+                      qint64 count, QAtomicPointer<MappedOverview> *target)
+      : m_path(path), m_layout(layout), m_count(count), m_target(target),
+        m_cancelled(0) {}
+
+  void cancel() { m_cancelled.storeRelease(1); }
+
+protected:
+  void run() override {
+    MappedOverview *overview = nullptr;
+    if (writeOverview(m_path, m_layout, &m_cancelled)) {
+      overview = mapOverview(m_path, m_count);
+    }
+    if (overview) {
+      m_target->storeRelease(overview);
+    } else if (m_cancelled.loadAcquire() == 0) {
+      qWarning() << "MappedSeriesFile: no overview for" << m_path
+                 << "- zoomed-out rendering will scan raw samples";
+    }
+  }
+
+private:
+  QString m_path;
+  MappedSeriesFile::Layout m_layout;
+  qint64 m_count;
+  QAtomicPointer<MappedOverview> *m_target;
+  QAtomicInt m_cancelled;
+};
+
+MappedSeriesFile::MappedSeriesFile()
+    : m_layout(YOnly), m_x0(0.0), m_dx(1.0), m_count(0), m_x(nullptr),
+      m_y(nullptr), m_overview(nullptr), m_overviewThread(nullptr) {}
+
+MappedSeriesFile::~MappedSeriesFile() { close(); }
+
+bool MappedSeriesFile::open(const QString &path, Layout layout, double x0,
+                            double dx) {
+  close();
+
+  if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+    qWarning() << "MappedSeriesFile: only little-endian hosts are supported";
+    return false;
+  }
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    qWarning() << "MappedSeriesFile: cannot open" << path
+               << m_file.errorString();
+    return false;
+  }
+
+  qint64 count = sampleCountFor(m_file.size(), layout);
+  if (count <= 0) {
+    qWarning() << "MappedSeriesFile:" << path << "contains no samples";
+    m_file.close();
+    return false;
+  }
+
+  const uchar *data = m_file.map(0, m_file.size());
+  if (!data) {
+    qWarning() << "MappedSeriesFile: cannot map" << path
+               << m_file.errorString();
+    m_file.close();
+    return false;
+  }
+
+  m_layout = layout;
+  m_x0 = x0;
+  m_dx = dx > 0.0 ? dx : 1.0;
+  m_count = count;
+  const double *values = reinterpret_cast<const double *>(data);
+  if (layout == XYColumns) {
+    m_x = values;
+    m_y = values + count;
+  } else {
+    m_x = nullptr;
+    m_y = values;
+  }
+
+  // A missing or stale overview is rebuilt in the background rather than
+  // holding up open() for a full pass over the file
+  m_overview.storeRelease(mapOverview(path, count));
+  if (!m_overview.loadAcquire()) {
+    m_overviewThread =
+        new OverviewBuildThread(path, layout, count, &m_overview);
+    m_overviewThread->start();
+  }
+  return true;
+}
+
+void MappedSeriesFile::close() {
+  if (m_overviewThread) {
+    m_overviewThread->cancel();
+    m_overviewThread->wait();
+    delete m_overviewThread;
+    m_overviewThread = nullptr;
+  }
+  delete m_overview.fetchAndStoreAcquire(nullptr);
+  m_file.close();
+  m_count = 0;
+  m_x = nullptr;
+  m_y = nullptr;
+}
+
+bool MappedSeriesFile::isOpen() const { return m_count > 0; }
+
+bool MappedSeriesFile::hasOverview() const {
+  return m_overview.loadAcquire() != nullptr;
+}
+
+QString MappedSeriesFile::fileName() const { return m_file.fileName(); }
+
+QString MappedSeriesFile::overviewPath(const QString &path) {
+  return path + ".ovr";
+}
+
+bool MappedSeriesFile::buildOverview(const QString &path, Layout layout) {
+  return writeOverview(path, layout, nullptr);
+}
+
+static bool writeOverview(const QString &path,
+                          MappedSeriesFile::Layout layout,
+                          const QAtomicInt *cancelled) {
+  const qint64 OverviewBlockSize = MappedSeriesFile::OverviewBlockSize;
+  const qint64 OverviewFanout = MappedSeriesFile::OverviewFanout;
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qWarning() << "MappedSeriesFile: cannot open" << path << file.errorString();
+    return false;
+  }
+
+  const qint64 count = sampleCountFor(file.size(), layout);
+  if (count <= 0) {
+    return false;
+  }
+
+  const uchar *data = file.map(0, file.size());
+  if (!data) {
+    qWarning() << "MappedSeriesFile: cannot map" << path << file.errorString();
+    return false;
+  }
+  const double *y = reinterpret_cast<const double *>(data);
+  if (layout == MappedSeriesFile::XYColumns) {
+    y += count;
+  }
+
+  QVector<qint64> levelSizes = overviewLevelSizes(count);
+
+  // Level 0 straight from the samples, every other level from the one below
+  QVector<QVector<double>> levels(levelSizes.size());
+  levels[0].resize(int(levelSizes[0] * 2));
+  for (qint64 block = 0; block < levelSizes[0]; ++block) {
+    if (cancelled && block % 1024 == 0 && cancelled->loadAcquire() != 0) {
+      return false;
+    }
+    qint64 begin = block * OverviewBlockSize;
+    qint64 end = qMin(begin + OverviewBlockSize, count);
+    double minY = y[begin];
+    double maxY = y[begin];
+    for (qint64 i = begin + 1; i < end; ++i) {
+      minY = qMin(minY, y[i]);
+      maxY = qMax(maxY, y[i]);
+    }
+    levels[0][int(block * 2)] = minY;
+    levels[0][int(block * 2 + 1)] = maxY;
+  }
+
+  for (int level = 1; level < levelSizes.size(); ++level) {
+    const QVector<double> &below = levels[level - 1];
+    const qint64 belowSize = levelSizes[level - 1];
+    QVector<double> &current = levels[level];
+    current.resize(int(levelSizes[level] * 2));
+    for (qint64 block = 0; block < levelSizes[level]; ++block) {
+      qint64 begin = block * OverviewFanout;
+      qint64 end = qMin(begin + OverviewFanout, belowSize);
+      double minY = below[int(begin * 2)];
+      double maxY = below[int(begin * 2 + 1)];
+      for (qint64 i = begin + 1; i < end; ++i) {
+        minY = qMin(minY, below[int(i * 2)]);
+        maxY = qMax(maxY, below[int(i * 2 + 1)]);
+      }
+      current[int(block * 2)] = minY;
+      current[int(block * 2 + 1)] = maxY;
+    }
+  }
+
+  QFile overview(MappedSeriesFile::overviewPath(path));
+  if (!overview.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << "MappedSeriesFile: cannot write" << overview.fileName()
+               << overview.errorString();
+    return false;
+  }
+
+  OverviewHeader header;
+  header.magic = kOverviewMagic;
+  header.version = kOverviewVersion;
+  header.blockSize = quint32(OverviewBlockSize);
+  header.fanout = quint32(OverviewFanout);
+  header.sourceSize = file.size();
+  header.sourceModified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+  header.sampleCount = count;
+
+  bool ok = overview.write(reinterpret_cast<const char *>(&header),
+                           sizeof(header)) == qint64(sizeof(header));
+  for (int level = 0; ok && level < levels.size(); ++level) {
+    qint64 bytes = qint64(levels[level].size()) * qint64(sizeof(double));
+    ok = overview.write(reinterpret_cast<const char *>(levels[level].constData()),
+                        bytes) == bytes;
+  }
+  if (!ok) {
+    qWarning() << "MappedSeriesFile: failed writing" << overview.fileName();
+    overview.close();
+    QFile::remove(overview.fileName());
+  }
+  return ok;
+}
+
+// Maps the overview of 'path' if it matches the data file, else null
+static MappedOverview *mapOverview(const QString &path, qint64 count) {
+  QScopedPointer<MappedOverview> overview(new MappedOverview);
+  QFile &file = overview->file;
+  file.setFileName(MappedSeriesFile::overviewPath(path));
+  if (!file.open(QIODevice::ReadOnly)) {
+    return nullptr;
+  }
+
+  QVector<qint64> levelSizes = overviewLevelSizes(count);
+  qint64 expectedSize = qint64(sizeof(OverviewHeader));
+  for (qint64 size : levelSizes) {
+    expectedSize += size * 2 * qint64(sizeof(double));
+  }
+  if (file.size() != expectedSize) {
+    return nullptr;
+  }
+
+  const uchar *data = file.map(0, expectedSize);
+  if (!data) {
+    return nullptr;
+  }
+
+  const QFileInfo source(path);
+  const OverviewHeader *header = reinterpret_cast<const OverviewHeader *>(data);
+  if (header->magic != kOverviewMagic || header->version != kOverviewVersion ||
+      header->blockSize != quint32(MappedSeriesFile::OverviewBlockSize) ||
+      header->fanout != quint32(MappedSeriesFile::OverviewFanout) ||
+      header->sourceSize != source.size() ||
+      header->sourceModified != source.lastModified().toMSecsSinceEpoch() ||
+      header->sampleCount != count) {
+    return nullptr;
+  }
+
+  const double *level =
+      reinterpret_cast<const double *>(data + sizeof(OverviewHeader));
+  for (qint64 size : levelSizes) {
+    overview->levels.append(level);
+    overview->levelSizes.append(size);
+    level += size * 2;
+  }
+  return overview.take();
+}
+
+double MappedSeriesFile::xAt(qint64 index) const {
+  return m_x ? m_x[index] : m_x0 + double(index) * m_dx;
+}
+
+qint64 MappedSeriesFile::count() const { return m_count; }
+
+QPointF MappedSeriesFile::pointAt(qint64 index) const {
+  return QPointF(xAt(index), m_y[index]);
+}
+
+qint64 MappedSeriesFile::lowerBound(double x) const {
+  if (m_count <= 0) {
+    return 0;
+  }
+  if (m_x) {
+    return std::lower_bound(m_x, m_x + m_count, x) - m_x;
+  }
+  double index = std::ceil((x - m_x0) / m_dx);
+  if (index <= 0.0) {
+    return 0;
+  }
+  if (index >= double(m_count)) {
+    return m_count;
+  }
+  return qint64(index);
+}
+
+bool MappedSeriesFile::yRange(qint64 first, qint64 last, double &minY,
+                              double &maxY) const {
+  first = qMax<qint64>(first, 0);
+  last = qMin(last, m_count);
+  if (first >= last) {
+    return false;
+  }
+
+  const MappedOverview *overview = m_overview.loadAcquire();
+  if (!overview) {
+    return SeriesDataSource::yRange(first, last, minY, maxY);
+  }
+  const QVector<const double *> &levels = overview->levels;
+
+  minY = std::numeric_limits<double>::infinity();
+  maxY = -std::numeric_limits<double>::infinity();
+
+  // Raw samples up to the first and from the last block boundary
+  qint64 lo = first;
+  qint64 hi = last;
+  for (; lo < hi && lo % OverviewBlockSize != 0; ++lo) {
+    minY = qMin(minY, m_y[lo]);
+    maxY = qMax(maxY, m_y[lo]);
+  }
+  for (; hi > lo && hi % OverviewBlockSize != 0; --hi) {
+    minY = qMin(minY, m_y[hi - 1]);
+    maxY = qMax(maxY, m_y[hi - 1]);
+  }
+
+  // Whole blocks: climb the overview, taking unaligned blocks at each level
+  lo /= OverviewBlockSize;
+  hi /= OverviewBlockSize;
+  for (int level = 0; lo < hi; ++level) {
+    const double *blocks = levels[level];
+    bool topLevel = level + 1 == levels.size();
+    for (; lo < hi && (topLevel || lo % OverviewFanout != 0); ++lo) {
+      minY = qMin(minY, blocks[lo * 2]);
+      maxY = qMax(maxY, blocks[lo * 2 + 1]);
+    }
+    for (; hi > lo && hi % OverviewFanout != 0; --hi) {
+      minY = qMin(minY, blocks[(hi - 1) * 2]);
+      maxY = qMax(maxY, blocks[(hi - 1) * 2 + 1]);
+    }
+    lo /= OverviewFanout;
+    hi /= OverviewFanout;
+  }
+  return true;
+}
+
+bool MappedSeriesFile::xRange(double &minX, double &maxX) const {
+  if (m_count <= 0) {
+    return false;
+  }
+  minX = xAt(0);
+  maxX = xAt(m_count - 1);
+  return true;
+}
+
+qint64 MappedSeriesFile::indexMemoryUsage() const {
+  const MappedOverview *overview = m_overview.loadAcquire();
+  if (!overview) {
+    return 0;
+  }
+  qint64 bytes = 0;
+  for (qint64 size : overview->levelSizes) {
+    bytes += size * 2 * qint64(sizeof(double));
+  }
+  return bytes;
+}
@@ -0,0 +1,74 @@
+#ifndef MAPPED_SERIES_FILE_H
+#define MAPPED_SERIES_FILE_H
+
+#include "series_data_source.h"
+#include <QAtomicPointer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Memory-mapped binary recording, rendered zero-copy by XYChartWidget.
+//
+// File layouts (native little-endian doubles, no header):
+//   XYColumns - N x values followed by N y values, x sorted ascending
+//   YOnly     - N y values, x is implicit: x0 + i * dx
+//
+// A min/max overview is kept next to the file ("<file>.ovr"). It holds
+// min/max pairs for blocks of OverviewBlockSize samples, then for groups
+// of OverviewFanout blocks, and so on up to a single block, so yRange()
+// over any span touches at most a few thousand values. The overview is
+// built ahead of time with buildOverview(), or by open() on a background
+// thread when it is missing or stale (the data file's size or modification
+// time changed). Until that build finishes yRange() scans raw samples.
+struct MappedOverview;
+class OverviewBuildThread;
+
+class MappedSeriesFile : public SeriesDataSource {
+public:
+    enum Layout { XYColumns, YOnly };
+
+    static const int OverviewBlockSize = 1024;
+    static const int OverviewFanout = 16;
+
+    MappedSeriesFile();
+    ~MappedSeriesFile();
+
+    bool open(const QString &path, Layout layout, double x0 = 0.0,
+              double dx = 1.0);
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+    // False while the overview is still being built (or could not be)
+    bool hasOverview() const;
+
+    static QString overviewPath(const QString &path);
+    static bool buildOverview(const QString &path, Layout layout);
+
+    qint64 count() const override;
+    QPointF pointAt(qint64 index) const override;
+    qint64 lowerBound(double x) const override;
+    bool yRange(qint64 first, qint64 last, double &minY,
+                double &maxY) const override;
+    bool xRange(double &minX, double &maxX) const override;
+    // Size of the mapped overview levels
+    qint64 indexMemoryUsage() const override;
+
+private:
+    Q_DISABLE_COPY(MappedSeriesFile)
+
+    double xAt(qint64 index) const;
+
+    QFile m_file;
+    Layout m_layout;
+    double m_x0;
+    double m_dx;
+    qint64 m_count;
+    const double *m_x;
+    const double *m_y;
+
+    // Published by the build thread once mapped; null until then
+    QAtomicPointer<MappedOverview> m_overview;
+    OverviewBuildThread *m_overviewThread;
+};
+
+#endif // MAPPED_SERIES_FILE_H
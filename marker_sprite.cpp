@@ -0,0 +1,155 @@
+#include "marker_sprite.h"
+#include <QPolygonF>
+#include <QtMath>
+
+MarkerSprite::MarkerSprite()
+    : m_shape(NoMarker), m_size(0), m_devicePixelRatio(1.0) {}
+
+void MarkerSprite::setStyle(MarkerShape shape, int size, const QColor &color,
+                            qreal devicePixelRatio) {
+  size = qMax(size, 1);
+  devicePixelRatio = qMax<qreal>(devicePixelRatio, 1.0);
+  if (shape == m_shape && size == m_size && color == m_color &&
+      qFuzzyCompare(devicePixelRatio, m_devicePixelRatio) &&
+      (shape == NoMarker || !m_pixmap.isNull())) {
+    return;
+  }
+
+  m_shape = shape;
+  m_size = size;
+  m_color = color;
+  m_devicePixelRatio = devicePixelRatio;
+  m_pixmap = QPixmap();
+  if (shape == NoMarker) {
+    return;
+  }
+
+  // One pixel of padding on each side for the antialiased edge
+  const int side = size + 2;
+  m_pixmap = QPixmap(qCeil(side * devicePixelRatio),
+                     qCeil(side * devicePixelRatio));
+  m_pixmap.setDevicePixelRatio(devicePixelRatio);
+  m_pixmap.fill(Qt::transparent);
+
+  QPainter painter(&m_pixmap);
+  paint(painter, shape, QRectF(1.0, 1.0, size, size), color);
+}
+
+MarkerShape MarkerSprite::shape() const { return m_shape; }
+
+int MarkerSprite::size() const { return m_size; }
+
+qint64 MarkerSprite::memoryUsage() const {
+  return qint64(m_pixmap.width()) * m_pixmap.height() * m_pixmap.depth() / 8 +
+         qint64(m_occupied.capacity()) * qint64(sizeof(quint32)) +
+         qint64(m_fragments.capacity()) *
+             qint64(sizeof(QPainter::PixmapFragment));
+}
+
+int MarkerSprite::draw(QPainter &painter, const QPointF *points, int count,
+                       const QRect &clip) {
+  if (m_shape == NoMarker || m_pixmap.isNull() || count <= 0 ||
+      clip.isEmpty()) {
+    return 0;
+  }
+
+  // One bit per plot pixel: a pixel gets at most one marker
+  const int w = clip.width();
+  const int h = clip.height();
+  m_occupied.fill(0, int((qint64(w) * h + 31) / 32));
+  quint32 *occupied = m_occupied.data();
+  m_fragments.resize(0);
+
+  const QRectF source(0.0, 0.0, m_pixmap.width(), m_pixmap.height());
+  const qreal scale = 1.0 / m_devicePixelRatio;
+  const double left = clip.left();
+  const double top = clip.top();
+
+  for (int i = 0; i < count; ++i) {
+    // Written so that NaN coordinates fail the test
+    const double x = points[i].x() - left;
+    const double y = points[i].y() - top;
+    if (!(x >= 0.0 && x < w && y >= 0.0 && y < h)) {
+      continue;
+    }
+
+    const int px = int(x);
+    const int py = int(y);
+    const int bit = py * w + px;
+    const quint32 mask = 1u << (bit & 31);
+    if (occupied[bit >> 5] & mask) {
+      continue;
+    }
+    occupied[bit >> 5] |= mask;
+
+    m_fragments.append(QPainter::PixmapFragment::create(
+        QPointF(left + px + 0.5, top + py + 0.5), source, scale, scale));
+  }
+
+  if (!m_fragments.isEmpty()) {
+    painter.drawPixmapFragments(m_fragments.constData(), m_fragments.size(),
+                                m_pixmap);
+  }
+  return m_fragments.size();
+}
+
+void MarkerSprite::paint(QPainter &painter, MarkerShape shape,
+                         const QRectF &rect, const QColor &color) {
+  if (shape == NoMarker) {
+    return;
+  }
+
+  const QPointF c = rect.center();
+  const qreal r = qMin(rect.width(), rect.height()) / 2.0;
+
+  painter.save();
+  painter.setRenderHint(QPainter::Antialiasing, true);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(color);
+
+  switch (shape) {
+  case CircleMarker:
+    painter.drawEllipse(c, r, r);
+    break;
+  case SquareMarker:
+    painter.drawRect(QRectF(c.x() - r * 0.85, c.y() - r * 0.85, r * 1.7,
+                            r * 1.7));
+    break;
+  case DiamondMarker: {
+    QPolygonF diamond;
+    diamond << QPointF(c.x(), c.y() - r) << QPointF(c.x() + r, c.y())
+            << QPointF(c.x(), c.y() + r) << QPointF(c.x() - r, c.y());
+    painter.drawPolygon(diamond);
+    break;
+  }
+  case TriangleMarker: {
+    QPolygonF triangle;
+    triangle << QPointF(c.x(), c.y() - r)
+             << QPointF(c.x() + r * 0.866, c.y() + r * 0.5)
+             << QPointF(c.x() - r * 0.866, c.y() + r * 0.5);
+    painter.drawPolygon(triangle);
+    break;
+  }
+  case CrossMarker:
+  case PlusMarker: {
+    QPen pen(color);
+    pen.setWidthF(qMax<qreal>(1.5, r / 3.0));
+    painter.setPen(pen);
+    if (shape == CrossMarker) {
+      const qreal d = r * 0.75;
+      painter.drawLine(QPointF(c.x() - d, c.y() - d),
+                       QPointF(c.x() + d, c.y() + d));
+      painter.drawLine(QPointF(c.x() - d, c.y() + d),
+                       QPointF(c.x() + d, c.y() - d));
+    } else {
+      painter.drawLine(QPointF(c.x() - r, c.y()), QPointF(c.x() + r, c.y()));
+      painter.drawLine(QPointF(c.x(), c.y() - r), QPointF(c.x(), c.y() + r));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  painter.restore();
+}
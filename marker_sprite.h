@@ -0,0 +1,60 @@
+#ifndef MARKER_SPRITE_H
+#define MARKER_SPRITE_H
+
+#include <QColor>
+#include <QPainter>
+#include <QPixmap>
+#include <QPointF>
+#include <QRect>
+#include <QVector>
+
+enum MarkerShape {
+    NoMarker,
+    CircleMarker,
+    SquareMarker,
+    DiamondMarker,
+    TriangleMarker,
+    CrossMarker,
+    PlusMarker
+};
+
+// A series' point marker, rendered once into a small pixmap and blitted at
+// every point with a single drawPixmapFragments() call. Points that round
+// to a pixel already holding a marker are skipped, so the cost of a frame
+// is bounded by the plot area rather than by the number of samples.
+class MarkerSprite {
+public:
+    MarkerSprite();
+
+    // Re-renders the pixmap only when something actually changed
+    void setStyle(MarkerShape shape, int size, const QColor &color,
+                  qreal devicePixelRatio);
+
+    MarkerShape shape() const;
+    int size() const;
+
+    // Draws the marker at each point inside 'clip' and returns the number
+    // of markers actually blitted
+    int draw(QPainter &painter, const QPointF *points, int count,
+             const QRect &clip);
+
+    // Paints a single marker centred in 'rect' (legend, previews)
+    static void paint(QPainter &painter, MarkerShape shape, const QRectF &rect,
+                      const QColor &color);
+
+    // Pixmap plus per-frame scratch, in bytes
+    qint64 memoryUsage() const;
+
+private:
+    MarkerShape m_shape;
+    int m_size;
+    QColor m_color;
+    qreal m_devicePixelRatio;
+    QPixmap m_pixmap;
+
+    // Scratch storage reused from frame to frame
+    QVector<quint32> m_occupied;
+    QVector<QPainter::PixmapFragment> m_fragments;
+};
+
+#endif // MARKER_SPRITE_H
@@ -0,0 +1,219 @@
+#include "persistence_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+PersistenceBuffer::PersistenceBuffer()
+    : m_width(0), m_height(0), m_drawnSamples(0) {}
+
+bool PersistenceBuffer::prepare(const QSize &size, const QPointF &scale,
+                                const QPointF &offset) {
+  const int width = qMax(size.width(), 0);
+  const int height = qMax(size.height(), 0);
+  if (width == m_width && height == m_height && !m_intensity.isEmpty()) {
+    const double rx = scale.x() / m_scale.x();
+    const double ry = scale.y() / m_scale.y();
+    if (std::fabs(rx - 1.0) * width < 0.5 &&
+        std::fabs(ry - 1.0) * height < 0.5) {
+      // Moves nothing by more than half a pixel besides a pan: shift by
+      // whole pixels and keep the rest of the mapping, so that slow
+      // drifts still add up to a shift
+      const int dx = qRound(offset.x() - m_offset.x());
+      const int dy = qRound(offset.y() - m_offset.y());
+      if (dx != 0 || dy != 0) {
+        resample(m_scale, m_offset + QPointF(dx, dy));
+      }
+      return false;
+    }
+    if (rx >= 0.5 && rx <= 2.0 && ry >= 0.5 && ry <= 2.0) {
+      resample(scale, offset);
+      return false;
+    }
+  }
+
+  m_width = width;
+  m_height = height;
+  m_scale = scale;
+  m_offset = offset;
+  m_intensity.fill(0.0f, width * height);
+  m_drawnSamples = 0;
+  m_clock.restart();
+  return true;
+}
+
+void PersistenceBuffer::resample(const QPointF &scale, const QPointF &offset) {
+  // Source column and row of each new pixel centre, -1 outside
+  const double rx = m_scale.x() / scale.x();
+  const double ry = m_scale.y() / scale.y();
+  m_columns.resize(m_width);
+  for (int x = 0; x < m_width; ++x) {
+    const double u = std::floor(m_offset.x() + (x + 0.5 - offset.x()) * rx);
+    m_columns[x] = u >= 0.0 && u < m_width ? int(u) : -1;
+  }
+  m_rows.resize(m_height);
+  for (int y = 0; y < m_height; ++y) {
+    const double v = std::floor(m_offset.y() + (y + 0.5 - offset.y()) * ry);
+    m_rows[y] = v >= 0.0 && v < m_height ? int(v) : -1;
+  }
+
+  m_resampled.resize(m_intensity.size());
+  const float *source = m_intensity.constData();
+  float *target = m_resampled.data();
+  const int *columns = m_columns.constData();
+  for (int y = 0; y < m_height; ++y) {
+    float *line = target + y * m_width;
+    if (m_rows.at(y) < 0) {
+      std::fill(line, line + m_width, 0.0f);
+      continue;
+    }
+    const float *row = source + m_rows.at(y) * m_width;
+    for (int x = 0; x < m_width; ++x) {
+      line[x] = columns[x] >= 0 ? row[columns[x]] : 0.0f;
+    }
+  }
+  m_intensity.swap(m_resampled);
+  m_scale = scale;
+  m_offset = offset;
+}
+
+float PersistenceBuffer::decay(int halfLifeMs) {
+  if (!m_clock.isValid()) {
+    m_clock.start();
+  }
+  const qint64 elapsed = m_clock.restart();
+  const float factor =
+      halfLifeMs > 0 ? float(std::pow(0.5, double(elapsed) / halfLifeMs))
+                     : 0.0f;
+
+  // Plain loop over contiguous floats so the compiler can vectorize it
+  float *intensity = m_intensity.data();
+  const int n = m_intensity.size();
+  float peak = 0.0f;
+  for (int i = 0; i < n; ++i) {
+    const float v = intensity[i] * factor;
+    intensity[i] = v;
+    peak = v > peak ? v : peak;
+  }
+  return peak;
+}
+
+void PersistenceBuffer::addTrace(const QPointF *points, int count) {
+  if (count <= 0 || m_intensity.isEmpty()) {
+    return;
+  }
+
+  QPointF previous(m_offset.x() + points[0].x() * m_scale.x(),
+                   m_offset.y() + points[0].y() * m_scale.y());
+  for (int i = 1; i < count; ++i) {
+    const QPointF current(m_offset.x() + points[i].x() * m_scale.x(),
+                          m_offset.y() + points[i].y() * m_scale.y());
+    if (points[i].x() >= points[i - 1].x()) {
+      addSegment(previous, current);
+    }
+    previous = current;
+  }
+}
+
+void PersistenceBuffer::addSegment(QPointF a, QPointF b) {
+  // Clip to the buffer (Liang-Barsky) so far off-screen segments cost
+  // nothing
+  const double dx = b.x() - a.x();
+  const double dy = b.y() - a.y();
+  // Values <= 0 on a log axis arrive as inf/NaN: a gap, not a segment
+  if (!std::isfinite(dx) || !std::isfinite(dy)) {
+    return;
+  }
+  const double p[4] = {-dx, dx, -dy, dy};
+  const double q[4] = {a.x(), m_width - a.x(), a.y(), m_height - a.y()};
+  double t0 = 0.0;
+  double t1 = 1.0;
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == 0.0) {
+      if (q[i] < 0.0) {
+        return;
+      }
+    } else {
+      const double t = q[i] / p[i];
+      if (p[i] < 0.0) {
+        t0 = qMax(t0, t);
+      } else {
+        t1 = qMin(t1, t);
+      }
+    }
+  }
+  if (!(t0 <= t1)) {
+    return;
+  }
+  b = QPointF(a.x() + t1 * dx, a.y() + t1 * dy);
+  a = QPointF(a.x() + t0 * dx, a.y() + t0 * dy);
+
+  // One hit per pixel step; the end point belongs to the next segment
+  const int steps =
+      qMax(1, int(std::ceil(qMax(std::fabs(b.x() - a.x()),
+                                 std::fabs(b.y() - a.y())))));
+  const double sx = (b.x() - a.x()) / steps;
+  const double sy = (b.y() - a.y()) / steps;
+  float *intensity = m_intensity.data();
+  double x = a.x();
+  double y = a.y();
+  for (int s = 0; s < steps; ++s, x += sx, y += sy) {
+    const int px = int(x);
+    const int py = int(y);
+    if (px >= 0 && px < m_width && py >= 0 && py < m_height) {
+      intensity[py * m_width + px] += 1.0f;
+    }
+  }
+}
+
+void PersistenceBuffer::buildColorTable(const QColor &color) {
+  m_tableColor = color;
+  m_colorTable.resize(256);
+  m_colorTable[0] = 0;
+  for (int i = 1; i < 256; ++i) {
+    const double t = i / 255.0;
+    // Glows in the series colour, burning towards white where traces pile up
+    const double alpha = qMin(1.0, 1.5 * t);
+    const double white = qMax(0.0, (t - 0.6) / 0.4) * 0.7;
+    const double r = color.redF() + (1.0 - color.redF()) * white;
+    const double g = color.greenF() + (1.0 - color.greenF()) * white;
+    const double b = color.blueF() + (1.0 - color.blueF()) * white;
+    m_colorTable[i] = qRgba(int(r * alpha * 255.0), int(g * alpha * 255.0),
+                            int(b * alpha * 255.0), int(alpha * 255.0));
+  }
+}
+
+const QImage &PersistenceBuffer::image(const QColor &color) {
+  if (m_colorTable.isEmpty() || color != m_tableColor) {
+    buildColorTable(color);
+  }
+  if (m_image.width() != m_width || m_image.height() != m_height) {
+    m_image = QImage(m_width, m_height, QImage::Format_ARGB32_Premultiplied);
+  }
+
+  // v / (v + 1): one fresh trace lands mid-scale, overlaps saturate softly
+  const QRgb *table = m_colorTable.constData();
+  const float *intensity = m_intensity.constData();
+  for (int y = 0; y < m_height; ++y) {
+    QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(y));
+    const float *row = intensity + y * m_width;
+    for (int x = 0; x < m_width; ++x) {
+      const float v = row[x];
+      line[x] = table[int(255.0f * v / (v + 1.0f))];
+    }
+  }
+  return m_image;
+}
+
+qint64 PersistenceBuffer::drawnSamples() const { return m_drawnSamples; }
+
+void PersistenceBuffer::setDrawnSamples(qint64 samples) {
+  m_drawnSamples = samples;
+}
+
+qint64 PersistenceBuffer::memoryUsage() const {
+  return qint64(m_intensity.capacity() + m_resampled.capacity()) *
+             qint64(sizeof(float)) +
+         qint64(m_columns.capacity() + m_rows.capacity()) *
+             qint64(sizeof(int)) +
+         qint64(m_colorTable.capacity()) * qint64(sizeof(QRgb)) +
+         m_image.sizeInBytes();
+}
@@ -0,0 +1,67 @@
+#ifndef PERSISTENCE_BUFFER_H
+#define PERSISTENCE_BUFFER_H
+
+#include <QColor>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+
+// Oscilloscope-style phosphor: a float intensity per plot pixel that new
+// traces are added into and that fades exponentially with wall-clock time.
+// Memory and per-frame cost depend on the plot size only, however many
+// sweeps have been overlaid.
+class PersistenceBuffer {
+public:
+    PersistenceBuffer();
+
+    // Sizes the buffer and sets the data-to-pixel mapping (pixel = offset +
+    // point * scale, relative to the plot's top-left). A new size or a
+    // scale change beyond a factor of two clears the buffer and returns
+    // true. Smaller changes, such as autoscale following the data, move
+    // the accumulated image to the new mapping instead; pans go by whole
+    // pixels, so traces may sit up to half a pixel off the axes.
+    bool prepare(const QSize &size, const QPointF &scale,
+                 const QPointF &offset);
+
+    // Fades by 0.5^(elapsed / halfLifeMs) since the previous call and
+    // returns the brightest remaining intensity
+    float decay(int halfLifeMs);
+
+    // Adds a trace through the points; x going backwards starts a new sweep
+    void addTrace(const QPointF *points, int count);
+
+    const QImage &image(const QColor &color);
+
+    // Intensity buffer and rendered image, in bytes
+    qint64 memoryUsage() const;
+
+    // Appended-sample count of the series when it was last rasterized
+    qint64 drawnSamples() const;
+    void setDrawnSamples(qint64 samples);
+
+private:
+    void addSegment(QPointF a, QPointF b);
+    // Nearest-pixel remap of the intensities to a new mapping
+    void resample(const QPointF &scale, const QPointF &offset);
+    void buildColorTable(const QColor &color);
+
+    int m_width;
+    int m_height;
+    QPointF m_scale;
+    QPointF m_offset;
+    QVector<float> m_intensity;
+    // Scratch for resample(), kept to avoid reallocating every frame
+    QVector<float> m_resampled;
+    QVector<int> m_columns;
+    QVector<int> m_rows;
+    QElapsedTimer m_clock;
+    qint64 m_drawnSamples;
+
+    QColor m_tableColor;
+    QVector<QRgb> m_colorTable;
+    QImage m_image;
+};
+
+#endif // PERSISTENCE_BUFFER_H
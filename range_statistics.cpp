@@ -0,0 +1,157 @@
+#include "range_statistics.h"
+#include <cmath>
+
+double RangeSummary::mean() const { return count > 0 ? sum / count : 0.0; }
+
+double RangeSummary::rms() const {
+  return count > 0 ? std::sqrt(sumSquares / count) : 0.0;
+}
+
+void RangeSummary::add(double y) {
+  minY = count > 0 ? qMin(minY, y) : y;
+  maxY = count > 0 ? qMax(maxY, y) : y;
+  sum += y;
+  sumSquares += y * y;
+  ++count;
+}
+
+void RangeSummary::merge(const RangeSummary &other) {
+  if (other.count == 0) {
+    return;
+  }
+  minY = count > 0 ? qMin(minY, other.minY) : other.minY;
+  maxY = count > 0 ? qMax(maxY, other.maxY) : other.maxY;
+  sum += other.sum;
+  sumSquares += other.sumSquares;
+  count += other.count;
+}
+
+RangeStatistics::RangeStatistics()
+    : m_leaves(0), m_first(0), m_end(0), m_appendedSamples(0) {}
+
+void RangeStatistics::append(const QPointF *points, int count) {
+  while (count > 0) {
+    const qint64 block = m_end / BlockSize;
+    const int offset = int(m_end % BlockSize);
+    if (offset == 0) {
+      reserveBlock(block);
+    }
+
+    int node = m_leaves + int(block % m_leaves);
+    if (offset == 0) {
+      m_tree[node] = RangeSummary();
+    }
+    const int n = qMin(count, BlockSize - offset);
+    RangeSummary &leaf = m_tree[node];
+    for (int i = 0; i < n; ++i) {
+      leaf.add(points[i].y());
+    }
+    for (node /= 2; node > 0; node /= 2) {
+      m_tree[node] = m_tree.at(2 * node);
+      m_tree[node].merge(m_tree.at(2 * node + 1));
+    }
+
+    m_end += n;
+    points += n;
+    count -= n;
+  }
+}
+
+void RangeStatistics::reserveBlock(qint64 block) {
+  const qint64 liveBlocks = block - m_first / BlockSize + 1;
+  if (liveBlocks <= m_leaves) {
+    return;
+  }
+
+  // Double the leaf count and re-home the live blocks; amortized O(1)
+  int leaves = qMax(m_leaves, 1);
+  while (leaves < liveBlocks) {
+    leaves *= 2;
+  }
+  QVector<RangeSummary> tree(2 * leaves);
+  for (qint64 b = m_first / BlockSize; b < block && m_leaves > 0; ++b) {
+    tree[leaves + int(b % leaves)] = m_tree.at(m_leaves + int(b % m_leaves));
+  }
+  for (int node = leaves - 1; node > 0; --node) {
+    tree[node] = tree.at(2 * node);
+    tree[node].merge(tree.at(2 * node + 1));
+  }
+  m_tree.swap(tree);
+  m_leaves = leaves;
+}
+
+void RangeStatistics::removeFirst(qint64 count) {
+  m_first = qMin(m_first + qMax<qint64>(count, 0), m_end);
+}
+
+void RangeStatistics::clear() {
+  m_tree.clear();
+  m_leaves = 0;
+  m_first = m_end = 0;
+  m_appendedSamples = 0;
+}
+
+qint64 RangeStatistics::count() const { return m_end - m_first; }
+
+RangeSummary RangeStatistics::queryLeaves(int first, int last) const {
+  // Bottom-up over [first, last) leaf positions
+  RangeSummary result;
+  for (first += m_leaves, last += m_leaves; first < last;
+       first /= 2, last /= 2) {
+    if (first & 1) {
+      result.merge(m_tree.at(first++));
+    }
+    if (last & 1) {
+      result.merge(m_tree.at(--last));
+    }
+  }
+  return result;
+}
+
+RangeSummary RangeStatistics::query(qint64 first, qint64 last,
+                                    const YReader &readY) const {
+  RangeSummary result;
+  const qint64 begin = m_first + qMax<qint64>(first, 0);
+  const qint64 end = m_first + qMin(last, count());
+  if (begin >= end) {
+    return result;
+  }
+
+  // Only blocks fully inside the range come from the tree
+  const qint64 firstBlock = (begin + BlockSize - 1) / BlockSize;
+  const qint64 endBlock = end / BlockSize;
+  if (firstBlock >= endBlock) {
+    for (qint64 i = begin; i < end; ++i) {
+      result.add(readY(i - m_first));
+    }
+    return result;
+  }
+
+  for (qint64 i = begin; i < firstBlock * BlockSize; ++i) {
+    result.add(readY(i - m_first));
+  }
+  for (qint64 i = endBlock * BlockSize; i < end; ++i) {
+    result.add(readY(i - m_first));
+  }
+
+  // The live blocks may wrap around the end of the leaf ring
+  const int leaf = int(firstBlock % m_leaves);
+  const int blocks = int(endBlock - firstBlock);
+  if (leaf + blocks <= m_leaves) {
+    result.merge(queryLeaves(leaf, leaf + blocks));
+  } else {
+    result.merge(queryLeaves(leaf, m_leaves));
+    result.merge(queryLeaves(0, leaf + blocks - m_leaves));
+  }
+  return result;
+}
+
+qint64 RangeStatistics::memoryUsage() const {
+  return qint64(m_tree.capacity()) * qint64(sizeof(RangeSummary));
+}
+
+qint64 RangeStatistics::appendedSamples() const { return m_appendedSamples; }
+
+void RangeStatistics::setAppendedSamples(qint64 samples) {
+  m_appendedSamples = samples;
+}
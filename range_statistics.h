@@ -0,0 +1,70 @@
+#ifndef RANGE_STATISTICS_H
+#define RANGE_STATISTICS_H
+
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+// Count, sum, sum of squares and extremes of a run of y values
+struct RangeSummary {
+    qint64 count;
+    double sum;
+    double sumSquares;
+    double minY, maxY;
+
+    RangeSummary() : count(0), sum(0.0), sumSquares(0.0), minY(0.0),
+                     maxY(0.0) {}
+    double mean() const;
+    double rms() const;
+
+    void add(double y);
+    void merge(const RangeSummary &other);
+};
+
+// Segment tree over blocks of BlockSize consecutive samples, answering
+// min/max/mean/RMS of any index range in O(log N + BlockSize).
+//
+// Appends update one leaf and its ancestors. Evicting the oldest samples
+// only moves the start index: leaves are addressed by block number modulo
+// the leaf count, so a sliding window reuses the same tree, and blocks
+// straddling either end of a query are read from the samples themselves.
+class RangeStatistics {
+public:
+    static const int BlockSize = 256;
+
+    // y of the sample at an index counted from the oldest live sample
+    typedef std::function<double(qint64)> YReader;
+
+    RangeStatistics();
+
+    void append(const QPointF *points, int count);
+    void removeFirst(qint64 count);
+    void clear();
+
+    // Live samples
+    qint64 count() const;
+
+    // Summary of samples [first, last)
+    RangeSummary query(qint64 first, qint64 last, const YReader &readY) const;
+
+    qint64 memoryUsage() const;
+
+    // Appended-sample count of the series when it was last synchronized
+    qint64 appendedSamples() const;
+    void setAppendedSamples(qint64 samples);
+
+private:
+    void reserveBlock(qint64 block);
+    RangeSummary queryLeaves(int first, int last) const;
+
+    // Nodes 1..m_leaves-1 are internal, m_leaves..2*m_leaves-1 are leaves
+    QVector<RangeSummary> m_tree;
+    int m_leaves;
+    // Absolute indices of the oldest live sample and one past the newest
+    qint64 m_first;
+    qint64 m_end;
+    qint64 m_appendedSamples;
+};
+
+#endif // RANGE_STATISTICS_H
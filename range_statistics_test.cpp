@@ -0,0 +1,141 @@
+// Checks RangeStatistics over a sliding window: as the oldest samples are
+// evicted the live blocks wrap around the leaf ring many times, and every
+// query must still match a direct scan of the samples. Also checks that a
+// steady window reuses its tree and that growing a wrapped window re-homes
+// the live blocks. Exits non-zero on the first failure.
+#include "range_statistics.h"
+#include <QDebug>
+#include <QPointF>
+#include <QVector>
+#include <utility>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+// Every sample ever appended; the window is [m_removed, size())
+class Window {
+public:
+  Window() : m_removed(0), m_state(99) {}
+
+  void append(RangeStatistics &statistics, int count) {
+    QVector<QPointF> points(count);
+    for (int i = 0; i < count; ++i) {
+      m_state = m_state * 1103515245u + 12345u;
+      // Integers, so sums are exact and compare with ==
+      const double y = double(int((m_state >> 16) % 2001) - 1000);
+      points[i] = QPointF(m_all.size(), y);
+      m_all.append(y);
+    }
+    statistics.append(points.constData(), count);
+  }
+
+  void removeFirst(RangeStatistics &statistics, qint64 count) {
+    statistics.removeFirst(count);
+    m_removed += count;
+  }
+
+  qint64 size() const { return m_all.size() - m_removed; }
+  quint32 random() {
+    m_state = m_state * 1103515245u + 12345u;
+    return m_state >> 8;
+  }
+
+  // Queries [first, last) and compares with a scan
+  bool matches(const RangeStatistics &statistics, qint64 first,
+               qint64 last) const {
+    const QVector<double> &all = m_all;
+    const qint64 removed = m_removed;
+    const RangeSummary summary =
+        statistics.query(first, last, [&all, removed](qint64 i) {
+          return all[int(removed + i)];
+        });
+
+    RangeSummary expected;
+    for (qint64 i = first; i < last; ++i) {
+      expected.add(m_all[int(m_removed + i)]);
+    }
+    return summary.count == expected.count && summary.sum == expected.sum &&
+           summary.sumSquares == expected.sumSquares &&
+           (expected.count == 0 || (summary.minY == expected.minY &&
+                                    summary.maxY == expected.maxY));
+  }
+
+  bool matchesRandomRanges(const RangeStatistics &statistics, int queries) {
+    bool ok = statistics.count() == size();
+    for (int q = 0; ok && q < queries; ++q) {
+      qint64 first = random() % (size() + 1);
+      qint64 last = random() % (size() + 1);
+      if (first > last) {
+        std::swap(first, last);
+      }
+      ok = matches(statistics, first, last);
+    }
+    return ok && matches(statistics, 0, size());
+  }
+
+private:
+  QVector<double> m_all;
+  qint64 m_removed;
+  quint32 m_state;
+};
+
+static void slidingWindow() {
+  const int window = 10 * RangeStatistics::BlockSize + 37;
+  RangeStatistics statistics;
+  Window samples;
+  samples.append(statistics, window);
+
+  // Evict as much as is appended, in uneven steps, for many laps of the ring
+  bool ok = true;
+  qint64 memory = -1;
+  for (int step = 0; step < 400; ++step) {
+    const int count =
+        int(samples.random() % (3 * RangeStatistics::BlockSize)) + 1;
+    samples.append(statistics, count);
+    samples.removeFirst(statistics, samples.size() - window);
+    ok = ok && samples.matchesRandomRanges(statistics, 8);
+    if (step == 50) {
+      memory = statistics.memoryUsage();
+    }
+  }
+  check(ok, "queries match a scan while the window wraps");
+  check(statistics.memoryUsage() == memory, "a steady window reuses its tree");
+}
+
+static void growWhileWrapped() {
+  RangeStatistics statistics;
+  Window samples;
+  samples.append(statistics, 4 * RangeStatistics::BlockSize);
+  for (int step = 0; step < 25; ++step) {
+    samples.append(statistics, RangeStatistics::BlockSize / 2 + 11);
+    samples.removeFirst(statistics, RangeStatistics::BlockSize / 2 + 11);
+  }
+  check(samples.matchesRandomRanges(statistics, 50), "wrapped before growth");
+
+  // More live blocks than leaves: the tree doubles with the ring wrapped
+  samples.append(statistics, 9 * RangeStatistics::BlockSize + 5);
+  check(samples.matchesRandomRanges(statistics, 200), "wrapped after growth");
+
+  samples.removeFirst(statistics, samples.size());
+  check(statistics.count() == 0 && samples.matches(statistics, 0, 0),
+        "empty after evicting everything");
+  samples.append(statistics, 3 * RangeStatistics::BlockSize + 1);
+  check(samples.matchesRandomRanges(statistics, 50), "refill after emptying");
+}
+
+int main() {
+  slidingWindow();
+  growWhileWrapped();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "RangeStatistics checks passed";
+  return 0;
+}
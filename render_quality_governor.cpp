@@ -0,0 +1,50 @@
+#include "render_quality_governor.h"
+
+// Frames well under budget before quality steps back up
+static const int UpgradeFrames = 30;
+
+RenderQualityGovernor::RenderQualityGovernor()
+    : m_budget(0), m_quality(FullQuality), m_average(0.0), m_overBudget(0),
+      m_underBudget(0) {}
+
+void RenderQualityGovernor::setBudget(qint64 nsecs) {
+  m_budget = qMax<qint64>(nsecs, 0);
+  idle();
+}
+
+qint64 RenderQualityGovernor::budget() const { return m_budget; }
+
+RenderQuality RenderQualityGovernor::quality() const { return m_quality; }
+
+void RenderQualityGovernor::frameFinished(qint64 nsecs) {
+  if (m_budget <= 0) {
+    return;
+  }
+
+  // Each level is measured afresh, so the average restarts on a change
+  m_average = m_average > 0.0 ? 0.7 * m_average + 0.3 * nsecs : double(nsecs);
+
+  if (m_average > m_budget) {
+    m_underBudget = 0;
+    if (++m_overBudget >= 2 && m_quality != MinimalQuality) {
+      m_quality = RenderQuality(m_quality + 1);
+      m_overBudget = 0;
+      m_average = 0.0;
+    }
+  } else if (m_average < m_budget / 2) {
+    m_overBudget = 0;
+    if (++m_underBudget >= UpgradeFrames && m_quality != FullQuality) {
+      m_quality = RenderQuality(m_quality - 1);
+      m_underBudget = 0;
+      m_average = 0.0;
+    }
+  } else {
+    m_overBudget = m_underBudget = 0;
+  }
+}
+
+void RenderQualityGovernor::idle() {
+  m_quality = FullQuality;
+  m_average = 0.0;
+  m_overBudget = m_underBudget = 0;
+}
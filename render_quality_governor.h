@@ -0,0 +1,39 @@
+#ifndef RENDER_QUALITY_GOVERNOR_H
+#define RENDER_QUALITY_GOVERNOR_H
+
+#include <QtGlobal>
+
+enum RenderQuality {
+    FullQuality,     // antialiased lines at their set width, markers
+    ReducedQuality,  // no antialiasing, 1 px cosmetic pens, decimated lines
+    MinimalQuality   // also no markers and half-resolution decimation
+};
+
+// Picks the render quality from measured frame times. A smoothed frame
+// time over budget for two frames in a row steps quality down at once;
+// it steps back up only after many frames at under half the budget, so
+// the level does not oscillate around the budget. idle() restores full
+// quality for the frame drawn once nothing is changing any more.
+class RenderQualityGovernor {
+public:
+    RenderQualityGovernor();
+
+    // 0 disables the governor: always full quality
+    void setBudget(qint64 nsecs);
+    qint64 budget() const;
+
+    RenderQuality quality() const;
+
+    // Paint time of a frame drawn at quality()
+    void frameFinished(qint64 nsecs);
+    void idle();
+
+private:
+    qint64 m_budget;
+    RenderQuality m_quality;
+    double m_average;
+    int m_overBudget;
+    int m_underBudget;
+};
+
+#endif // RENDER_QUALITY_GOVERNOR_H
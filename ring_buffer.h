@@ -0,0 +1,261 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <QVector>
+#include <iterator>
+#include <utility>
+
+// Series sample storage.
+//
+// Unbounded (capacity 0) it is a plain QVector, so data handed in with
+// assign() stays implicitly shared with the caller. Bounded, the buffer is
+// allocated once at exactly capacity() elements and used as a ring: appends
+// overwrite the oldest samples, and evicting n samples only moves the head,
+// so a sliding window never reallocates or shifts memory.
+template <typename T>
+class RingBuffer
+{
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        const_iterator(const RingBuffer *buffer, int index)
+            : m_buffer(buffer), m_index(index) {}
+        const T &operator*() const { return m_buffer->at(m_index); }
+        const T *operator->() const { return &m_buffer->at(m_index); }
+        const_iterator &operator++() { ++m_index; return *this; }
+        bool operator==(const const_iterator &o) const { return m_index == o.m_index; }
+        bool operator!=(const const_iterator &o) const { return m_index != o.m_index; }
+
+    private:
+        const RingBuffer *m_buffer;
+        int m_index;
+    };
+
+    RingBuffer() : m_head(0), m_size(0), m_capacity(0) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int capacity() const { return m_capacity; }
+    bool isBounded() const { return m_capacity > 0; }
+    bool isFull() const { return m_capacity > 0 && m_size == m_capacity; }
+    // Storage exists already, from reserve() or a bounded window
+    bool isAllocated() const { return m_data.capacity() > 0; }
+
+    // Bytes allocated for samples (shared with the caller while assigned)
+    qint64 memoryUsage() const { return qint64(m_data.capacity()) * qint64(sizeof(T)); }
+
+    // Start of the storage; the oldest sample is at run(0) when bounded
+    const T *constData() const { return m_data.constData(); }
+
+    const T &at(int i) const { return m_data.at(physical(i)); }
+    const T &operator[](int i) const { return at(i); }
+    const T &first() const { return at(0); }
+    const T &last() const { return at(m_size - 1); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
+
+    // Contents as at most two contiguous runs, oldest first. Returns the
+    // start of run 0 or 1 and its length (0 when the run is empty).
+    const T *run(int index, int &length) const
+    {
+        const int firstLength =
+            m_capacity > 0 ? qMin(m_size, m_capacity - m_head) : m_size;
+        if (index == 0) {
+            length = firstLength;
+            return m_data.constData() + m_head;
+        }
+        length = m_size - firstLength;
+        return m_data.constData();
+    }
+
+    // 0 makes the buffer unbounded. Keeps the newest samples and allocates
+    // the new storage exactly once.
+    void setCapacity(int capacity)
+    {
+        capacity = qMax(capacity, 0);
+        if (capacity == m_capacity) {
+            return;
+        }
+
+        const int kept = capacity > 0 ? qMin(m_size, capacity) : m_size;
+        QVector<T> data;
+        if (capacity > 0) {
+            data.resize(capacity);
+        } else {
+            data.resize(kept);
+        }
+        copyNewest(kept, data.data());
+
+        m_data.swap(data);
+        m_head = 0;
+        m_size = kept;
+        m_capacity = capacity;
+    }
+
+    // Only meaningful while unbounded; a bounded buffer is already sized
+    void reserve(int count)
+    {
+        if (m_capacity == 0) {
+            m_data.reserve(count);
+        }
+    }
+
+    // Number of oldest samples the next append of 'count' samples evicts
+    int overflow(int count) const
+    {
+        return m_capacity > 0 ? qMax(0, m_size + count - m_capacity) : 0;
+    }
+
+    void append(const T &value)
+    {
+        if (m_capacity == 0) {
+            m_data.append(value);
+            ++m_size;
+            return;
+        }
+
+        m_data[physical(m_size % m_capacity)] = value;
+        if (m_size < m_capacity) {
+            ++m_size;
+        } else {
+            m_head = m_head + 1 == m_capacity ? 0 : m_head + 1;
+        }
+    }
+
+    void append(const T *values, int count)
+    {
+        if (count <= 0) {
+            return;
+        }
+        if (m_capacity == 0) {
+            for (int i = 0; i < count; ++i) {
+                m_data.append(values[i]);
+            }
+            m_size += count;
+            return;
+        }
+
+        // Only the newest 'capacity' incoming samples can survive
+        if (count >= m_capacity) {
+            values += count - m_capacity;
+            count = m_capacity;
+            m_head = 0;
+            m_size = 0;
+        }
+
+        const int evicted = overflow(count);
+        T *data = m_data.data();
+        int slot = physical(m_size % m_capacity);
+        for (int i = 0; i < count; ++i) {
+            data[slot] = values[i];
+            slot = slot + 1 == m_capacity ? 0 : slot + 1;
+        }
+        m_size += count - evicted;
+        m_head = (m_head + evicted) % m_capacity;
+    }
+
+    void append(const QVector<T> &values)
+    {
+        // Share rather than copy into an empty, unreserved vector
+        if (m_capacity == 0 && m_size == 0 && m_data.capacity() == 0) {
+            assign(values);
+            return;
+        }
+        append(values.constData(), values.size());
+    }
+
+    // Drops the n oldest samples in O(1) when bounded
+    void removeFirst(int n = 1)
+    {
+        n = qMin(n, m_size);
+        if (n <= 0) {
+            return;
+        }
+        if (m_capacity == 0) {
+            m_data.remove(0, n);
+        } else {
+            m_head = (m_head + n) % m_capacity;
+        }
+        m_size -= n;
+    }
+
+    // Keeps the allocation of a bounded buffer
+    void clear()
+    {
+        if (m_capacity == 0) {
+            m_data.clear();
+        }
+        m_head = 0;
+        m_size = 0;
+    }
+
+    // Replaces the contents. Unbounded, the vector is shared, not copied.
+    void assign(const QVector<T> &values)
+    {
+        if (m_capacity == 0) {
+            m_data = values;
+            m_head = 0;
+            m_size = values.size();
+            return;
+        }
+        clear();
+        append(values.constData(), values.size());
+    }
+
+    // Replaces the contents by adopting the caller's buffer
+    void assign(QVector<T> &&values)
+    {
+        m_data = std::move(values);
+        m_head = 0;
+        m_size = m_data.size();
+        if (m_capacity == 0) {
+            return;
+        }
+
+        if (m_size > m_capacity) {
+            m_data.remove(0, m_size - m_capacity);
+            m_size = m_capacity;
+        }
+        m_data.resize(m_capacity);
+    }
+
+    // Oldest-first copy (shared, not copied, while unbounded)
+    QVector<T> toVector() const
+    {
+        if (m_capacity == 0) {
+            return m_data;
+        }
+        QVector<T> result(m_size);
+        copyNewest(m_size, result.data());
+        return result;
+    }
+
+private:
+    int physical(int i) const
+    {
+        int p = m_head + i;
+        return (m_capacity > 0 && p >= m_capacity) ? p - m_capacity : p;
+    }
+
+    void copyNewest(int count, T *out) const
+    {
+        for (int i = 0; i < count; ++i) {
+            out[i] = at(m_size - count + i);
+        }
+    }
+
+    QVector<T> m_data;
+    int m_head;
+    int m_size;
+    int m_capacity;
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,140 @@
+// Checks that RingBuffer keeps its storage where the chart relies on it:
+// a bounded window appends and evicts in place, and resizing a populated
+// window (setMaxPointsPerSeries) allocates the new storage exactly once.
+// Exits non-zero on the first failure.
+#include "ring_buffer.h"
+#include <QDebug>
+#include <QPointF>
+#include <QVector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+static QVector<QPointF> ramp(int first, int count) {
+  QVector<QPointF> points(count);
+  for (int i = 0; i < count; ++i) {
+    points[i] = QPointF(first + i, -(first + i));
+  }
+  return points;
+}
+
+static bool holdsRamp(const RingBuffer<QPointF> &buffer, int first) {
+  for (int i = 0; i < buffer.size(); ++i) {
+    if (buffer.at(i) != QPointF(first + i, -(first + i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void boundedWindow() {
+  const int capacity = 1000;
+  RingBuffer<QPointF> buffer;
+  buffer.setCapacity(capacity);
+  const QPointF *data = buffer.constData();
+  const qint64 bytes = buffer.memoryUsage();
+  check(bytes == qint64(capacity) * qint64(sizeof(QPointF)),
+        "bounded window is allocated at exactly its capacity");
+
+  // Single appends, past several wraps
+  int next = 0;
+  for (; next < 5 * capacity + 17; ++next) {
+    buffer.append(QPointF(next, -next));
+  }
+  check(buffer.size() == capacity, "single appends fill the window");
+  check(holdsRamp(buffer, next - capacity), "single appends keep the newest");
+
+  // Blocks smaller than, straddling and larger than the window
+  const int blocks[] = {1, 7, 333, capacity - 1, capacity, capacity + 1,
+                        3 * capacity + 5};
+  for (int count : blocks) {
+    const QVector<QPointF> block = ramp(next, count);
+    buffer.append(block.constData(), block.size());
+    next += count;
+    check(holdsRamp(buffer, next - capacity), "block appends keep the newest");
+    buffer.append(ramp(next, count));
+    next += count;
+    check(holdsRamp(buffer, next - capacity), "vector appends keep the newest");
+  }
+
+  // Eviction and refill
+  buffer.removeFirst(capacity / 3);
+  check(holdsRamp(buffer, next - capacity + capacity / 3),
+        "removeFirst drops the oldest");
+  buffer.append(ramp(next, capacity / 2));
+  next += capacity / 2;
+  check(holdsRamp(buffer, next - buffer.size()), "refill after eviction");
+  buffer.clear();
+  buffer.append(ramp(next, capacity / 2));
+  check(holdsRamp(buffer, next), "refill after clear");
+
+  check(buffer.constData() == data, "append/evict keeps the storage");
+  check(buffer.memoryUsage() == bytes, "append/evict keeps the capacity");
+}
+
+static void resizeWindow() {
+  // Unbounded series with more points than the new window, as when
+  // setMaxPointsPerSeries() is called on an existing series
+  RingBuffer<QPointF> buffer;
+  buffer.append(ramp(0, 5000));
+  const int capacity = 1200;
+  buffer.setCapacity(capacity);
+  const QPointF *data = buffer.constData();
+  check(buffer.memoryUsage() == qint64(capacity) * qint64(sizeof(QPointF)),
+        "resize allocates exactly the new capacity");
+  check(buffer.size() == capacity && holdsRamp(buffer, 5000 - capacity),
+        "resize keeps the newest points");
+
+  // Nothing may reallocate lazily afterwards
+  buffer.setCapacity(capacity);
+  buffer.append(ramp(5000, 3 * capacity));
+  buffer.removeFirst(10);
+  check(holdsRamp(buffer, 5000 + 2 * capacity + 10), "appends after resize");
+  check(buffer.constData() == data, "resize allocates only once");
+
+  // Shrinking a full window, then growing it again
+  buffer.setCapacity(capacity / 2);
+  data = buffer.constData();
+  buffer.append(ramp(0, capacity));
+  check(buffer.constData() == data, "shrunk window appends in place");
+  buffer.setCapacity(2 * capacity);
+  data = buffer.constData();
+  check(buffer.size() == capacity / 2 && holdsRamp(buffer, capacity / 2),
+        "grown window keeps its points");
+  buffer.append(ramp(capacity, 3 * capacity));
+  check(buffer.constData() == data, "grown window appends in place");
+  check(holdsRamp(buffer, 2 * capacity), "grown window keeps the newest");
+}
+
+static void reservedSeries() {
+  // reserveSeries(): appends below the reservation fill it in place
+  RingBuffer<QPointF> buffer;
+  buffer.reserve(4096);
+  const QPointF *data = buffer.constData();
+  const qint64 bytes = buffer.memoryUsage();
+  for (int first = 0; first < 4096; first += 512) {
+    buffer.append(ramp(first, 512));
+  }
+  check(holdsRamp(buffer, 0) && buffer.size() == 4096,
+        "reserved series holds the points");
+  check(buffer.constData() == data && buffer.memoryUsage() == bytes,
+        "reserved series fills its storage in place");
+}
+
+int main() {
+  boundedWindow();
+  resizeWindow();
+  reservedSeries();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "RingBuffer storage checks passed";
+  return 0;
+}
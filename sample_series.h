@@ -0,0 +1,317 @@
+#ifndef SAMPLE_SERIES_H
+#define SAMPLE_SERIES_H
+
+#include "series_data_source.h"
+#include <QVector>
+#include <QtGlobal>
+#include <cmath>
+
+// Sample types SampleSeries is instantiated for
+enum SampleFormat {
+    Int16Samples,
+    Int32Samples,
+    FloatSamples
+};
+
+// Regularly sampled acquisition data kept as raw ADC values and displayed
+// as y = raw * gain + offset at x = x0 + index * dx. Conversion happens only
+// when points are read, so a qint16 channel costs 2 bytes per sample
+// instead of the 16 of a QPointF.
+class SampleSource : public SeriesDataSource
+{
+public:
+    SampleSource(double x0, double dx)
+        : m_x0(x0), m_dx(dx > 0.0 ? dx : 1.0), m_gain(1.0), m_offset(0.0),
+          m_first(0), m_capacity(0) {}
+
+    virtual SampleFormat format() const = 0;
+    // Bytes per stored sample
+    virtual int sampleSize() const = 0;
+
+    void setScale(double gain, double offset)
+    {
+        m_gain = gain;
+        m_offset = offset;
+    }
+    double gain() const { return m_gain; }
+    double offset() const { return m_offset; }
+    double x0() const { return m_x0; }
+    double dx() const { return m_dx; }
+
+    // Keeps at least the newest 'samples' (0 = unbounded, the default).
+    // Storage is dropped a whole block at a time, so up to one block more
+    // is retained; dropped samples are converted into 'evicted' if given.
+    virtual void setCapacity(qint64 samples,
+                             QVector<QPointF> *evicted = nullptr) = 0;
+    qint64 capacity() const { return m_capacity; }
+
+    virtual void clear() = 0;
+
+    qint64 lowerBound(double x) const override
+    {
+        const double position = std::ceil((x - m_x0) / m_dx) - double(m_first);
+        return qint64(qBound(0.0, position, double(count())));
+    }
+
+    bool xRange(double &minX, double &maxX) const override
+    {
+        if (count() == 0) {
+            return false;
+        }
+        minX = xAt(0);
+        maxX = xAt(count() - 1);
+        return true;
+    }
+
+protected:
+    double xAt(qint64 index) const { return m_x0 + double(m_first + index) * m_dx; }
+
+    double m_x0;
+    double m_dx;
+    double m_gain;
+    double m_offset;
+    // Absolute index of the oldest retained sample, so x keeps advancing
+    // after old blocks are dropped
+    qint64 m_first;
+    qint64 m_capacity;
+};
+
+template <typename T> struct SampleFormatOf;
+template <> struct SampleFormatOf<qint16> { static const SampleFormat value = Int16Samples; };
+template <> struct SampleFormatOf<qint32> { static const SampleFormat value = Int32Samples; };
+template <> struct SampleFormatOf<float> { static const SampleFormat value = FloatSamples; };
+
+// Samples are stored in fixed blocks, each with the raw min/max of its
+// contents, so yRange() over a wide span reads block headers and only the
+// partial blocks at either end are scanned. The scan, the conversion in
+// readPoints(), min/max decimation in spanRanges() and the block
+// bookkeeping are compiled per sample type.
+template <typename T>
+class SampleSeries : public SampleSource
+{
+public:
+    static const int BlockSize = 4096;
+
+    explicit SampleSeries(double x0 = 0.0, double dx = 1.0)
+        : SampleSource(x0, dx), m_count(0), m_rawValid(false), m_minRaw(0),
+          m_maxRaw(0) {}
+
+    SampleFormat format() const override { return SampleFormatOf<T>::value; }
+    int sampleSize() const override { return int(sizeof(T)); }
+
+    void append(const T *samples, int count, QVector<QPointF> *evicted = nullptr)
+    {
+        while (count > 0) {
+            if (m_blocks.isEmpty() || m_blocks.last().samples.size() == BlockSize) {
+                m_blocks.append(Block());
+                m_blocks.last().samples.reserve(BlockSize);
+            }
+            Block &block = m_blocks.last();
+            const int n = qMin(count, BlockSize - block.samples.size());
+            T minRaw, maxRaw;
+            scan(samples, n, minRaw, maxRaw);
+            if (block.samples.isEmpty()) {
+                block.minRaw = minRaw;
+                block.maxRaw = maxRaw;
+            } else {
+                block.minRaw = qMin(block.minRaw, minRaw);
+                block.maxRaw = qMax(block.maxRaw, maxRaw);
+            }
+            if (m_rawValid) {
+                m_minRaw = qMin(m_minRaw, minRaw);
+                m_maxRaw = qMax(m_maxRaw, maxRaw);
+            } else if (m_count == 0) {
+                m_minRaw = minRaw;
+                m_maxRaw = maxRaw;
+                m_rawValid = true;
+            }
+            for (int i = 0; i < n; ++i) {
+                block.samples.append(samples[i]);
+            }
+            m_count += n;
+            samples += n;
+            count -= n;
+            dropOldest(evicted);
+        }
+    }
+
+    void setCapacity(qint64 samples, QVector<QPointF> *evicted = nullptr) override
+    {
+        m_capacity = qMax<qint64>(samples, 0);
+        dropOldest(evicted);
+    }
+
+    void clear() override
+    {
+        m_first = 0;
+        m_blocks.clear();
+        m_count = 0;
+        m_rawValid = false;
+    }
+
+    qint64 count() const override { return m_count; }
+
+    QPointF pointAt(qint64 index) const override
+    {
+        return QPointF(xAt(index), double(rawAt(index)) * m_gain + m_offset);
+    }
+
+    bool yRange(qint64 first, qint64 last, double &minY, double &maxY) const override
+    {
+        first = qMax<qint64>(first, 0);
+        last = qMin(last, m_count);
+        if (first >= last) {
+            return false;
+        }
+
+        T minRaw, maxRaw;
+        if (first == 0 && last == m_count) {
+            if (!m_rawValid) {
+                rawRange(0, m_count, m_minRaw, m_maxRaw);
+                m_rawValid = true;
+            }
+            minRaw = m_minRaw;
+            maxRaw = m_maxRaw;
+        } else {
+            rawRange(first, last, minRaw, maxRaw);
+        }
+
+        // A negative gain swaps the ends
+        const double a = double(minRaw) * m_gain + m_offset;
+        const double b = double(maxRaw) * m_gain + m_offset;
+        minY = qMin(a, b);
+        maxY = qMax(a, b);
+        return true;
+    }
+
+    // Min/max of raw values per span, converted once per span rather than
+    // once per sample
+    void spanRanges(const qint64 *bounds, int spans, SpanRange *out) const override
+    {
+        for (int i = 0; i < spans; ++i) {
+            const qint64 first = qMax<qint64>(bounds[i], 0);
+            const qint64 last = qMin(bounds[i + 1], m_count);
+            if (first >= last) {
+                continue;
+            }
+            T minRaw, maxRaw;
+            rawRange(first, last, minRaw, maxRaw);
+            const double a = double(minRaw) * m_gain + m_offset;
+            const double b = double(maxRaw) * m_gain + m_offset;
+            out[i].minY = qMin(a, b);
+            out[i].maxY = qMax(a, b);
+            out[i].firstY = double(rawAt(first)) * m_gain + m_offset;
+            out[i].lastY = double(rawAt(last - 1)) * m_gain + m_offset;
+        }
+    }
+
+    qint64 readPoints(qint64 first, qint64 count, QPointF *out) const override
+    {
+        first = qMax<qint64>(first, 0);
+        const qint64 last = qMin(first + count, m_count);
+        for (qint64 index = first; index < last;) {
+            const T *samples = m_blocks.at(int(index / BlockSize)).samples.constData();
+            const int offset = int(index % BlockSize);
+            const int n = int(qMin<qint64>(BlockSize - offset, last - index));
+            const double x = xAt(index);
+            for (int i = 0; i < n; ++i) {
+                out[i] = QPointF(x + i * m_dx, double(samples[offset + i]) * m_gain + m_offset);
+            }
+            out += n;
+            index += n;
+        }
+        return qMax<qint64>(last - first, 0);
+    }
+
+    qint64 memoryUsage() const override
+    {
+        // Every block is reserved at exactly BlockSize samples
+        return qint64(m_blocks.size()) * BlockSize * qint64(sizeof(T));
+    }
+
+    qint64 indexMemoryUsage() const override
+    {
+        return qint64(m_blocks.capacity()) * qint64(sizeof(Block));
+    }
+
+private:
+    struct Block {
+        QVector<T> samples;
+        T minRaw, maxRaw;
+
+        Block() : minRaw(0), maxRaw(0) {}
+    };
+
+    T rawAt(qint64 index) const
+    {
+        return m_blocks.at(int(index / BlockSize)).samples.at(int(index % BlockSize));
+    }
+
+    // Plain loop over one sample type, which the compiler vectorizes
+    static void scan(const T *samples, int count, T &minRaw, T &maxRaw)
+    {
+        minRaw = maxRaw = samples[0];
+        for (int i = 1; i < count; ++i) {
+            minRaw = samples[i] < minRaw ? samples[i] : minRaw;
+            maxRaw = samples[i] > maxRaw ? samples[i] : maxRaw;
+        }
+    }
+
+    void rawRange(qint64 first, qint64 last, T &minRaw, T &maxRaw) const
+    {
+        bool found = false;
+        for (qint64 index = first; index < last;) {
+            const Block &block = m_blocks.at(int(index / BlockSize));
+            const int offset = int(index % BlockSize);
+            const int n = int(qMin<qint64>(block.samples.size() - offset, last - index));
+            T lo, hi;
+            if (offset == 0 && n == block.samples.size()) {
+                lo = block.minRaw;
+                hi = block.maxRaw;
+            } else {
+                scan(block.samples.constData() + offset, n, lo, hi);
+            }
+            minRaw = found ? qMin(minRaw, lo) : lo;
+            maxRaw = found ? qMax(maxRaw, hi) : hi;
+            found = true;
+            index += n;
+        }
+    }
+
+    // Whole blocks go once the rest still covers the capacity
+    void dropOldest(QVector<QPointF> *evicted)
+    {
+        if (m_capacity <= 0) {
+            return;
+        }
+        int blocks = 0;
+        while (blocks + 1 < m_blocks.size() &&
+               m_count - qint64(blocks + 1) * BlockSize >= m_capacity) {
+            ++blocks;
+        }
+        if (blocks == 0) {
+            return;
+        }
+
+        const qint64 dropped = qint64(blocks) * BlockSize;
+        if (evicted) {
+            const int offset = evicted->size();
+            evicted->resize(offset + int(dropped));
+            readPoints(0, dropped, evicted->data() + offset);
+        }
+        m_blocks.remove(0, blocks);
+        m_first += dropped;
+        m_count -= dropped;
+        // The extent may have left with the dropped blocks
+        m_rawValid = false;
+    }
+
+    QVector<Block> m_blocks;
+    qint64 m_count;
+
+    // Raw extent of all retained samples
+    mutable bool m_rawValid;
+    mutable T m_minRaw, m_maxRaw;
+};
+
+#endif // SAMPLE_SERIES_H
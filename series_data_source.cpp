@@ -0,0 +1,137 @@
+#include "series_data_source.h"
+#include <cmath>
+
+qint64 SeriesDataSource::lowerBound(double x) const {
+  qint64 first = 0;
+  qint64 len = count();
+
+  while (len > 0) {
+    qint64 half = len / 2;
+    if (pointAt(first + half).x() < x) {
+      first += half + 1;
+      len -= half + 1;
+    } else {
+      len = half;
+    }
+  }
+  return first;
+}
+
+bool SeriesDataSource::yRange(qint64 first, qint64 last, double &minY,
+                              double &maxY) const {
+  first = qMax<qint64>(first, 0);
+  last = qMin(last, count());
+  if (first >= last) {
+    return false;
+  }
+
+  minY = maxY = pointAt(first).y();
+  for (qint64 i = first + 1; i < last; ++i) {
+    double y = pointAt(i).y();
+    minY = qMin(minY, y);
+    maxY = qMax(maxY, y);
+  }
+  return true;
+}
+
+void SeriesDataSource::spanRanges(const qint64 *bounds, int spans,
+                                  SpanRange *out) const {
+  for (int i = 0; i < spans; ++i) {
+    const qint64 first = bounds[i];
+    const qint64 last = bounds[i + 1];
+    if (first >= last) {
+      continue;
+    }
+    yRange(first, last, out[i].minY, out[i].maxY);
+    out[i].firstY = pointAt(first).y();
+    out[i].lastY = pointAt(last - 1).y();
+  }
+}
+
+bool SeriesDataSource::xRange(double &minX, double &maxX) const {
+  qint64 n = count();
+  if (n <= 0) {
+    return false;
+  }
+  minX = pointAt(0).x();
+  maxX = pointAt(n - 1).x();
+  return true;
+}
+
+qint64 SeriesDataSource::readPoints(qint64 first, qint64 count,
+                                    QPointF *out) const {
+  first = qMax<qint64>(first, 0);
+  const qint64 last = qMin(first + count, this->count());
+  for (qint64 i = first; i < last; ++i) {
+    *out++ = pointAt(i);
+  }
+  return qMax<qint64>(last - first, 0);
+}
+
+BufferDataSource::BufferDataSource(const QPointF *points, qint64 count,
+                                   const std::function<void()> &release)
+    : m_points(points), m_x(nullptr), m_y(nullptr), m_count(count),
+      m_x0(0.0), m_dx(1.0), m_release(release), m_extentValid(false),
+      m_minY(0.0), m_maxY(0.0) {}
+
+BufferDataSource::BufferDataSource(const double *x, const double *y,
+                                   qint64 count,
+                                   const std::function<void()> &release)
+    : m_points(nullptr), m_x(x), m_y(y), m_count(count), m_x0(0.0),
+      m_dx(1.0), m_release(release), m_extentValid(false), m_minY(0.0),
+      m_maxY(0.0) {}
+
+BufferDataSource::BufferDataSource(const double *y, qint64 count, double x0,
+                                   double dx,
+                                   const std::function<void()> &release)
+    : m_points(nullptr), m_x(nullptr), m_y(y), m_count(count), m_x0(x0),
+      m_dx(dx > 0.0 ? dx : 1.0), m_release(release), m_extentValid(false),
+      m_minY(0.0), m_maxY(0.0) {}
+
+BufferDataSource::~BufferDataSource() {
+  if (m_release) {
+    m_release();
+  }
+}
+
+qint64 BufferDataSource::count() const { return m_count; }
+
+QPointF BufferDataSource::pointAt(qint64 index) const {
+  if (m_points) {
+    return m_points[index];
+  }
+  double x = m_x ? m_x[index] : m_x0 + double(index) * m_dx;
+  return QPointF(x, m_y[index]);
+}
+
+qint64 BufferDataSource::lowerBound(double x) const {
+  if (m_points || m_x) {
+    return SeriesDataSource::lowerBound(x);
+  }
+
+  double index = std::ceil((x - m_x0) / m_dx);
+  if (index <= 0.0) {
+    return 0;
+  }
+  if (index >= double(m_count)) {
+    return m_count;
+  }
+  return qint64(index);
+}
+
+bool BufferDataSource::yRange(qint64 first, qint64 last, double &minY,
+                              double &maxY) const {
+  if (first > 0 || last < m_count) {
+    return SeriesDataSource::yRange(first, last, minY, maxY);
+  }
+
+  if (!m_extentValid) {
+    if (!SeriesDataSource::yRange(0, m_count, m_minY, m_maxY)) {
+      return false;
+    }
+    m_extentValid = true;
+  }
+  minY = m_minY;
+  maxY = m_maxY;
+  return true;
+}
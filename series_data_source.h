@@ -0,0 +1,94 @@
+#ifndef SERIES_DATA_SOURCE_H
+#define SERIES_DATA_SOURCE_H
+
+#include <QPointF>
+#include <QtGlobal>
+#include <functional>
+
+// Y summary of a span of samples, one per plot column when decimating
+struct SpanRange {
+    double minY;
+    double maxY;
+    double firstY;
+    double lastY;
+};
+
+// Read-only sample storage that XYChartWidget renders directly, without
+// copying it into DataSeries::points. Samples must be sorted by x, and
+// pointAt() must be safe to call from several threads at once.
+class SeriesDataSource {
+public:
+    virtual ~SeriesDataSource() {}
+
+    virtual qint64 count() const = 0;
+    virtual QPointF pointAt(qint64 index) const = 0;
+
+    // Index of the first sample whose x is >= x (count() if none)
+    virtual qint64 lowerBound(double x) const;
+
+    // Y extent of samples [first, last); false if the range is empty.
+    // Implementations with a precomputed overview should override this.
+    virtual bool yRange(qint64 first, qint64 last, double &minY,
+                        double &maxY) const;
+
+    // Summaries of the spans [bounds[i], bounds[i + 1]) for i < spans,
+    // with ascending bounds inside [0, count()]; empty spans are skipped.
+    // The default reads each span through yRange() and pointAt().
+    virtual void spanRanges(const qint64 *bounds, int spans,
+                            SpanRange *out) const;
+
+    // X extent of all samples; false if the source is empty
+    virtual bool xRange(double &minX, double &maxX) const;
+
+    // Copies samples [first, first + count) to 'out' and returns how many
+    // were copied. Sources that decode in blocks should override this.
+    virtual qint64 readPoints(qint64 first, qint64 count, QPointF *out) const;
+
+    // Bytes the source keeps in memory for samples and for its search index
+    // (block headers, overview levels). Caller-owned buffers and sample
+    // files mapped from disk, which the OS pages on demand, count as 0.
+    virtual qint64 memoryUsage() const { return 0; }
+    virtual qint64 indexMemoryUsage() const { return 0; }
+};
+
+// Caller-owned memory displayed in place: interleaved points, separate
+// x/y arrays, or y values with implicit x = x0 + index * dx. The buffer
+// must stay valid and unchanged until 'release' is called, which happens
+// when the last chart reference to the source goes away.
+class BufferDataSource : public SeriesDataSource {
+public:
+    BufferDataSource(const QPointF *points, qint64 count,
+                     const std::function<void()> &release =
+                         std::function<void()>());
+    BufferDataSource(const double *x, const double *y, qint64 count,
+                     const std::function<void()> &release =
+                         std::function<void()>());
+    BufferDataSource(const double *y, qint64 count, double x0, double dx,
+                     const std::function<void()> &release =
+                         std::function<void()>());
+    ~BufferDataSource();
+
+    qint64 count() const override;
+    QPointF pointAt(qint64 index) const override;
+    qint64 lowerBound(double x) const override;
+    bool yRange(qint64 first, qint64 last, double &minY,
+                double &maxY) const override;
+
+private:
+    Q_DISABLE_COPY(BufferDataSource)
+
+    const QPointF *m_points;
+    const double *m_x;
+    const double *m_y;
+    qint64 m_count;
+    double m_x0;
+    double m_dx;
+    std::function<void()> m_release;
+
+    // The buffer is immutable, so the full extent is computed only once
+    mutable bool m_extentValid;
+    mutable double m_minY;
+    mutable double m_maxY;
+};
+
+#endif // SERIES_DATA_SOURCE_H
@@ -0,0 +1,411 @@
+#include "series_file_loader.h"
+#include "xy_chart_widget.h"
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QSemaphore>
+#include <QThread>
+#include <QTimer>
+#include <cstring>
+#include <utility>
+
+// Reads the file in ChunkBytes pieces and posts every parsed chunk back to
+// the loader's thread. Columns are one QVector<QPointF> per series. Each
+// post takes one of MaxChunksInFlight slots, given back by releaseChunks()
+// once the loader handed the points to the chart.
+class SeriesParseThread : public QThread {
+public:
+  enum Format { Csv, Binary };
+
+  SeriesParseThread(SeriesFileLoader *loader, const QString &path,
+                    Format format, int seriesCount)
+      : m_loader(loader), m_path(path), m_format(format),
+        m_seriesCount(seriesCount), m_delimiter(','), m_skipLines(0),
+        m_implicitX(false), m_x0(0.0), m_dx(1.0),
+        m_slots(SeriesFileLoader::MaxChunksInFlight), m_cancelled(0) {}
+
+  void setCsvOptions(char delimiter, int skipLines) {
+    m_delimiter = delimiter;
+    m_skipLines = skipLines;
+  }
+
+  void setBinaryOptions(bool implicitX, double x0, double dx) {
+    m_implicitX = implicitX;
+    m_x0 = x0;
+    m_dx = dx;
+  }
+
+  void cancel() { m_cancelled.storeRelease(1); }
+
+  void releaseChunks(int count) { m_slots.release(count); }
+
+protected:
+  void run() override {
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+      finish(false, QString("Cannot open %1: %2")
+                        .arg(m_path)
+                        .arg(file.errorString()));
+      return;
+    }
+
+    bool ok = m_format == Csv ? parseCsv(file) : parseBinary(file);
+    if (cancelled()) {
+      finish(false, QString("Loading %1 cancelled").arg(m_path));
+    } else {
+      finish(ok, ok ? QString() : QString("Failed reading %1").arg(m_path));
+    }
+  }
+
+private:
+  bool cancelled() const { return m_cancelled.loadAcquire() != 0; }
+
+  QVector<QVector<QPointF>> emptyColumns(int expectedPoints) const {
+    QVector<QVector<QPointF>> columns(m_seriesCount);
+    for (auto &column : columns) {
+      column.reserve(expectedPoints);
+    }
+    return columns;
+  }
+
+  void post(const QVector<QVector<QPointF>> &columns, qint64 bytesRead,
+            qint64 totalBytes) {
+    // Backpressure: wait while the GUI thread is behind
+    while (!m_slots.tryAcquire(1, 50)) {
+      if (cancelled()) {
+        return;
+      }
+    }
+    SeriesFileLoader *loader = m_loader;
+    QMetaObject::invokeMethod(
+        loader,
+        [loader, columns, bytesRead, totalBytes]() {
+          loader->appendChunk(columns, bytesRead, totalBytes);
+        },
+        Qt::QueuedConnection);
+  }
+
+  void finish(bool ok, const QString &message) {
+    SeriesFileLoader *loader = m_loader;
+    QMetaObject::invokeMethod(
+        loader, [loader, ok, message]() { loader->finishLoad(ok, message); },
+        Qt::QueuedConnection);
+  }
+
+  void parseCsvLine(const char *begin, const char *end,
+                    QVector<QVector<QPointF>> &columns) {
+    if (m_skipLines > 0) {
+      --m_skipLines;
+      return;
+    }
+    if (end > begin && end[-1] == '\r') {
+      --end;
+    }
+    if (begin == end) {
+      return;
+    }
+
+    // Field 0 is x, fields 1..N are the series values
+    double x = 0.0;
+    int field = 0;
+    const char *fieldBegin = begin;
+    for (const char *p = begin; field <= m_seriesCount; ++p) {
+      if (p != end && *p != m_delimiter) {
+        continue;
+      }
+
+      bool ok = false;
+      double value =
+          QByteArray::fromRawData(fieldBegin, int(p - fieldBegin)).toDouble(&ok);
+      if (field == 0) {
+        if (!ok) {
+          return; // Header or malformed line
+        }
+        x = value;
+      } else if (ok) {
+        columns[field - 1].append(QPointF(x, value));
+      }
+
+      ++field;
+      fieldBegin = p + 1;
+      if (p == end) {
+        break;
+      }
+    }
+  }
+
+  bool parseCsv(QFile &file) {
+    const qint64 totalBytes = file.size();
+    qint64 bytesRead = 0;
+    QByteArray buffer;
+    QByteArray carry;
+    int expectedPoints = 0;
+
+    while (!cancelled()) {
+      buffer = file.read(SeriesFileLoader::ChunkBytes);
+      if (buffer.isEmpty()) {
+        break;
+      }
+      bytesRead += buffer.size();
+
+      // Complete lines only; the tail waits for the next chunk
+      int lastNewline = buffer.lastIndexOf('\n');
+      if (lastNewline < 0) {
+        carry.append(buffer);
+        continue;
+      }
+      carry.append(buffer.constData(), lastNewline + 1);
+
+      QVector<QVector<QPointF>> columns = emptyColumns(expectedPoints);
+      const char *p = carry.constData();
+      const char *end = p + carry.size();
+      while (p < end) {
+        const char *lineEnd =
+            static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        parseCsvLine(p, lineEnd, columns);
+        p = lineEnd + 1;
+      }
+      carry = buffer.mid(lastNewline + 1);
+
+      expectedPoints = columns.isEmpty() ? 0 : columns[0].size();
+      post(columns, bytesRead, totalBytes);
+    }
+
+    if (!cancelled() && !carry.isEmpty()) {
+      QVector<QVector<QPointF>> columns = emptyColumns(1);
+      parseCsvLine(carry.constData(), carry.constData() + carry.size(),
+                   columns);
+      post(columns, bytesRead, totalBytes);
+    }
+    return true;
+  }
+
+  bool parseBinary(QFile &file) {
+    const int valuesPerRecord = m_seriesCount + (m_implicitX ? 0 : 1);
+    const int recordBytes = valuesPerRecord * int(sizeof(double));
+    const int recordsPerChunk =
+        qMax(1, SeriesFileLoader::ChunkBytes / recordBytes);
+    const qint64 totalBytes = file.size();
+    qint64 bytesRead = 0;
+    qint64 recordIndex = 0;
+
+    // A record split across reads is carried to the front of the buffer
+    QByteArray buffer(recordsPerChunk * recordBytes, Qt::Uninitialized);
+    int carried = 0;
+    while (!cancelled()) {
+      qint64 n = file.read(buffer.data() + carried, buffer.size() - carried);
+      if (n < 0) {
+        return false;
+      }
+      if (n == 0) {
+        break;
+      }
+      bytesRead += n;
+      const qint64 available = carried + n;
+      const int records = int(available / recordBytes);
+
+      QVector<QVector<QPointF>> columns = emptyColumns(records);
+      const char *record = buffer.constData();
+      double values[64];
+      QVector<double> wideValues;
+      double *row = values;
+      if (valuesPerRecord > 64) {
+        wideValues.resize(valuesPerRecord);
+        row = wideValues.data();
+      }
+
+      for (int r = 0; r < records; ++r, ++recordIndex) {
+        std::memcpy(row, record, size_t(recordBytes));
+        record += recordBytes;
+
+        double x = m_implicitX ? m_x0 + double(recordIndex) * m_dx : row[0];
+        const double *y = m_implicitX ? row : row + 1;
+        for (int s = 0; s < m_seriesCount; ++s) {
+          columns[s].append(QPointF(x, y[s]));
+        }
+      }
+
+      carried = int(available - qint64(records) * recordBytes);
+      std::memmove(buffer.data(), record, size_t(carried));
+      if (records > 0) {
+        post(columns, bytesRead, totalBytes);
+      }
+    }
+
+    if (!cancelled() && carried > 0) {
+      qWarning() << "SeriesFileLoader: ignoring" << carried
+                 << "trailing bytes of an incomplete record in" << m_path;
+    }
+    return true;
+  }
+
+  SeriesFileLoader *m_loader;
+  QString m_path;
+  Format m_format;
+  int m_seriesCount;
+  char m_delimiter;
+  int m_skipLines;
+  bool m_implicitX;
+  double m_x0;
+  double m_dx;
+  QSemaphore m_slots;
+  QAtomicInt m_cancelled;
+};
+
+SeriesFileLoader::SeriesFileLoader(XYChartWidget *chart, QObject *parent)
+    : QObject(parent), m_chart(chart), m_thread(nullptr),
+      m_flushTimer(new QTimer(this)), m_pendingChunks(0), m_reserved(false),
+      m_elapsedMs(0),
+      m_pointsLoaded(0), m_bytesLoaded(0) {
+  m_flushTimer->setSingleShot(true);
+  m_flushTimer->setInterval(FlushIntervalMs);
+  connect(m_flushTimer, &QTimer::timeout, this,
+          &SeriesFileLoader::flushPending);
+}
+
+SeriesFileLoader::~SeriesFileLoader() { stopThread(); }
+
+bool SeriesFileLoader::loadCsv(const QString &path,
+                               const QStringList &seriesNames, char delimiter,
+                               int skipLines) {
+  SeriesParseThread *thread = new SeriesParseThread(
+      this, path, SeriesParseThread::Csv, seriesNames.size());
+  thread->setCsvOptions(delimiter, skipLines);
+  return start(thread, seriesNames);
+}
+
+bool SeriesFileLoader::loadBinary(const QString &path,
+                                  const QStringList &seriesNames,
+                                  bool implicitX, double x0, double dx) {
+  SeriesParseThread *thread = new SeriesParseThread(
+      this, path, SeriesParseThread::Binary, seriesNames.size());
+  thread->setBinaryOptions(implicitX, x0, dx);
+  return start(thread, seriesNames);
+}
+
+bool SeriesFileLoader::start(SeriesParseThread *thread,
+                             const QStringList &seriesNames) {
+  if (isLoading() || m_chart.isNull() || seriesNames.isEmpty()) {
+    qWarning() << "SeriesFileLoader: cannot start loading";
+    delete thread;
+    return false;
+  }
+
+  m_seriesNames = seriesNames;
+  m_pending = QVector<QVector<QPointF>>(seriesNames.size());
+  m_pendingChunks = 0;
+  m_reserved = false;
+  m_pointsLoaded = 0;
+  m_bytesLoaded = 0;
+  m_elapsedMs = 0;
+  m_elapsed.start();
+
+  m_thread = thread;
+  m_thread->start();
+  return true;
+}
+
+void SeriesFileLoader::cancel() {
+  if (m_thread) {
+    m_thread->cancel();
+  }
+}
+
+bool SeriesFileLoader::isLoading() const { return m_thread != nullptr; }
+
+qint64 SeriesFileLoader::pointsLoaded() const { return m_pointsLoaded; }
+
+qint64 SeriesFileLoader::bytesLoaded() const { return m_bytesLoaded; }
+
+qint64 SeriesFileLoader::elapsedMs() const {
+  return isLoading() ? m_elapsed.elapsed() : m_elapsedMs;
+}
+
+double SeriesFileLoader::pointsPerSecond() const {
+  qint64 ms = elapsedMs();
+  return ms > 0 ? m_pointsLoaded * 1000.0 / ms : 0.0;
+}
+
+void SeriesFileLoader::appendChunk(const QVector<QVector<QPointF>> &columns,
+                                   qint64 bytesRead, qint64 totalBytes) {
+  if (!m_thread) {
+    return;
+  }
+
+  int chunkPoints = 0;
+  for (int i = 0; i < columns.size() && i < m_pending.size(); ++i) {
+    m_pending[i] += columns[i];
+    chunkPoints += columns[i].size();
+  }
+  m_pointsLoaded += chunkPoints;
+  m_bytesLoaded = bytesRead;
+  ++m_pendingChunks;
+
+  // Size the series once from the first chunk's bytes-per-point ratio. The
+  // chart caps it at a bounded series window; a memory budget caps it at
+  // the series' share, and MaxReservedPoints caps it otherwise.
+  if (!m_reserved && chunkPoints > 0 && bytesRead > 0 && !m_chart.isNull()) {
+    double limit = MaxReservedPoints;
+    qint64 budget = m_chart->memoryBudget();
+    const qint64 globalBudget = XYChartWidget::globalMemoryBudget();
+    if (globalBudget > 0 && (budget <= 0 || globalBudget < budget)) {
+      budget = globalBudget;
+    }
+    if (budget > 0) {
+      limit = qMin(limit, double(budget) / sizeof(QPointF) /
+                              m_seriesNames.size());
+    }
+    for (int i = 0; i < m_seriesNames.size(); ++i) {
+      double estimate = double(columns[i].size()) * totalBytes / bytesRead;
+      int capacity = int(qMin(estimate * 1.05, limit));
+      m_chart->reserveSeries(m_seriesNames[i], capacity);
+    }
+    m_reserved = true;
+  }
+
+  emit progress(bytesRead, totalBytes);
+
+  // The parser is blocked once every slot is pending: hand them over now
+  if (m_pendingChunks >= MaxChunksInFlight) {
+    m_flushTimer->stop();
+    flushPending();
+  } else if (!m_flushTimer->isActive()) {
+    m_flushTimer->start();
+  }
+}
+
+void SeriesFileLoader::flushPending() {
+  for (int i = 0; i < m_pending.size() && !m_chart.isNull(); ++i) {
+    if (!m_pending[i].isEmpty()) {
+      m_chart->addPoints(m_seriesNames[i], std::move(m_pending[i]));
+      m_pending[i] = QVector<QPointF>();
+    }
+  }
+  if (m_thread && m_pendingChunks > 0) {
+    m_thread->releaseChunks(m_pendingChunks);
+  }
+  m_pendingChunks = 0;
+}
+
+void SeriesFileLoader::finishLoad(bool ok, const QString &message) {
+  m_flushTimer->stop();
+  flushPending();
+  stopThread();
+  m_elapsedMs = m_elapsed.elapsed();
+
+  if (!ok) {
+    emit error(message);
+  }
+  emit finished(ok);
+}
+
+void SeriesFileLoader::stopThread() {
+  if (!m_thread) {
+    return;
+  }
+  m_thread->cancel();
+  m_thread->wait();
+  delete m_thread;
+  m_thread = nullptr;
+}
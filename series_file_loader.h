@@ -0,0 +1,88 @@
+#ifndef SERIES_FILE_LOADER_H
+#define SERIES_FILE_LOADER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+class QTimer;
+class XYChartWidget;
+class SeriesParseThread;
+
+// Loads CSV or raw binary recordings into an XYChartWidget.
+//
+// The file is read and parsed on a background thread in fixed-size chunks.
+// Parsed points are queued back to the GUI thread and handed to the chart
+// at most every FlushIntervalMs, so the plot fills in progressively while
+// the UI stays responsive. At most MaxChunksInFlight parsed chunks wait for
+// the GUI thread; the parser blocks until the chart has taken them. Series
+// storage is reserved from an estimate of the final point count, capped by
+// the series window, the memory budget and MaxReservedPoints, so appends
+// do not keep reallocating.
+class SeriesFileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int ChunkBytes = 4 * 1024 * 1024;
+    static const int FlushIntervalMs = 100;
+    static const int MaxChunksInFlight = 4;
+    static const int MaxReservedPoints = 64 * 1024 * 1024;
+
+    explicit SeriesFileLoader(XYChartWidget *chart, QObject *parent = nullptr);
+    ~SeriesFileLoader();
+
+    // CSV: x in the first column, then one column per entry of seriesNames.
+    // The first skipLines lines (headers) are ignored.
+    bool loadCsv(const QString &path, const QStringList &seriesNames,
+                 char delimiter = ',', int skipLines = 1);
+
+    // Binary: records of little-endian doubles {x, y1..yN}, or {y1..yN}
+    // with x = x0 + index * dx when implicitX is set.
+    bool loadBinary(const QString &path, const QStringList &seriesNames,
+                    bool implicitX = false, double x0 = 0.0, double dx = 1.0);
+
+    // Stop parsing; points already parsed are kept
+    void cancel();
+    bool isLoading() const;
+
+    // Throughput of the current or last load
+    qint64 pointsLoaded() const;
+    qint64 bytesLoaded() const;
+    qint64 elapsedMs() const;
+    double pointsPerSecond() const;
+
+signals:
+    void progress(qint64 bytesRead, qint64 totalBytes);
+    void finished(bool ok);
+    void error(const QString &message);
+
+private:
+    friend class SeriesParseThread;
+
+    bool start(SeriesParseThread *thread, const QStringList &seriesNames);
+    void appendChunk(const QVector<QVector<QPointF>> &columns,
+                     qint64 bytesRead, qint64 totalBytes);
+    void flushPending();
+    void finishLoad(bool ok, const QString &message);
+    void stopThread();
+
+    QPointer<XYChartWidget> m_chart;
+    SeriesParseThread *m_thread;
+    QTimer *m_flushTimer;
+    QStringList m_seriesNames;
+    QVector<QVector<QPointF>> m_pending;
+    // Chunks merged into m_pending, returned to the parser on flush
+    int m_pendingChunks;
+    bool m_reserved;
+
+    QElapsedTimer m_elapsed;
+    qint64 m_elapsedMs;
+    qint64 m_pointsLoaded;
+    qint64 m_bytesLoaded;
+};
+
+#endif // SERIES_FILE_LOADER_H
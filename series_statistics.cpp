@@ -0,0 +1,106 @@
+#include "series_statistics.h"
+#include <cmath>
+
+SeriesStatistics::SeriesStatistics()
+    : m_valid(false), m_first(0), m_end(0), m_last(0.0), m_removed(0),
+      m_mean(0.0), m_deviations(0.0) {}
+
+bool SeriesStatistics::isValid() const {
+  // Rebuilding after as many evictions as samples held keeps the rounding
+  // of the reverse updates bounded at O(1) amortized per sample
+  return m_valid && (m_removed == 0 || m_removed < count());
+}
+
+void SeriesStatistics::invalidate() {
+  clear();
+  m_valid = false;
+}
+
+void SeriesStatistics::clear() {
+  m_valid = true;
+  m_first = m_end = m_removed = 0;
+  m_last = m_mean = m_deviations = 0.0;
+  // Swap rather than clear() so the memory is actually released
+  std::deque<Entry>().swap(m_minQueue);
+  std::deque<Entry>().swap(m_maxQueue);
+}
+
+void SeriesStatistics::append(double y) {
+  const double d = y - m_mean;
+  m_mean += d / double(m_end - m_first + 1);
+  m_deviations += d * (y - m_mean);
+  m_last = y;
+
+  // Entries the new value dominates can never be an extreme again
+  while (!m_minQueue.empty() && m_minQueue.back().value >= y) {
+    m_minQueue.pop_back();
+  }
+  while (!m_maxQueue.empty() && m_maxQueue.back().value <= y) {
+    m_maxQueue.pop_back();
+  }
+  const Entry entry = {m_end, y};
+  m_minQueue.push_back(entry);
+  m_maxQueue.push_back(entry);
+  ++m_end;
+}
+
+void SeriesStatistics::append(const QPointF *points, int count) {
+  for (int i = 0; i < count; ++i) {
+    append(points[i].y());
+  }
+}
+
+void SeriesStatistics::removeFirst(double y) {
+  if (m_first == m_end) {
+    return;
+  }
+  ++m_removed;
+  // Welford's update run backwards; an emptied window starts afresh
+  const qint64 n = m_end - m_first - 1;
+  if (n == 0) {
+    m_mean = m_deviations = 0.0;
+  } else {
+    const double d = y - m_mean;
+    m_mean -= d / double(n);
+    m_deviations = qMax(0.0, m_deviations - d * (y - m_mean));
+  }
+
+  if (m_minQueue.front().index == m_first) {
+    m_minQueue.pop_front();
+  }
+  if (m_maxQueue.front().index == m_first) {
+    m_maxQueue.pop_front();
+  }
+  ++m_first;
+}
+
+qint64 SeriesStatistics::count() const { return m_end - m_first; }
+
+double SeriesStatistics::last() const { return m_last; }
+
+double SeriesStatistics::min() const {
+  return m_minQueue.empty() ? 0.0 : m_minQueue.front().value;
+}
+
+double SeriesStatistics::max() const {
+  return m_maxQueue.empty() ? 0.0 : m_maxQueue.front().value;
+}
+
+double SeriesStatistics::mean() const {
+  const qint64 n = count();
+  return n > 0 ? m_mean : 0.0;
+}
+
+double SeriesStatistics::standardDeviation() const {
+  const qint64 n = count();
+  if (n < 2) {
+    return 0.0;
+  }
+  const double variance = m_deviations / double(n - 1);
+  return variance > 0.0 ? std::sqrt(variance) : 0.0;
+}
+
+qint64 SeriesStatistics::memoryUsage() const {
+  return qint64(m_minQueue.size() + m_maxQueue.size()) *
+         qint64(sizeof(Entry));
+}
@@ -0,0 +1,63 @@
+#ifndef SERIES_STATISTICS_H
+#define SERIES_STATISTICS_H
+
+#include <QPointF>
+#include <QtGlobal>
+#include <deque>
+
+// Live statistics of the y values a series currently holds, updated in
+// O(1) amortized per sample as samples are appended and as the oldest ones
+// are evicted. Mean and variance are Welford's running mean and sum of
+// squared deviations, updated on eviction too, so they follow the level of
+// the current window rather than drifting away from that of its first
+// sample. Evicting undoes an earlier update only up to rounding, so once a
+// whole window's worth has been evicted the statistics report themselves
+// invalid and are rebuilt from the samples held. Min and max come from
+// monotonic queues of (index, value) whose fronts are the extremes of the
+// current window.
+class SeriesStatistics {
+public:
+    SeriesStatistics();
+
+    // Invalid statistics are not maintained and must be rebuilt (by
+    // clear() and appending everything) before use. They also turn invalid
+    // after count() evictions since the last clear().
+    bool isValid() const;
+    void invalidate();
+    void clear();
+
+    void append(double y);
+    void append(const QPointF *points, int count);
+    // Evicts the oldest sample, whose value must be passed back in
+    void removeFirst(double y);
+
+    qint64 count() const;
+    double last() const;
+    double min() const;
+    double max() const;
+    double mean() const;
+    double standardDeviation() const;
+
+    qint64 memoryUsage() const;
+
+private:
+    struct Entry {
+        qint64 index;
+        double value;
+    };
+
+    bool m_valid;
+    // Absolute indices of the oldest live sample and one past the newest
+    qint64 m_first;
+    qint64 m_end;
+    double m_last;
+    // Evictions since clear(), for the periodic rebuild
+    qint64 m_removed;
+    double m_mean;
+    // Sum of squared deviations from m_mean
+    double m_deviations;
+    std::deque<Entry> m_minQueue;
+    std::deque<Entry> m_maxQueue;
+};
+
+#endif // SERIES_STATISTICS_H
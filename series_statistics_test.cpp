@@ -0,0 +1,152 @@
+// Checks SeriesStatistics over a sliding window: the reverse Welford
+// updates on eviction must track the mean and standard deviation of the
+// current window, even after its level jumps by many orders of magnitude,
+// the monotonic queues must give its exact min and max, and the statistics
+// must turn invalid after a window's worth of evictions and come back
+// exact once rebuilt. Exits non-zero on the first failure.
+#include "series_statistics.h"
+#include <QDebug>
+#include <cmath>
+#include <deque>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+static bool nearlyEqual(double value, double expected, double tolerance) {
+  return std::fabs(value - expected) <=
+         tolerance * (1.0 + std::fabs(expected));
+}
+
+// Compares against a two-pass computation over the window
+static bool matches(const SeriesStatistics &statistics,
+                    const std::deque<double> &window) {
+  double sum = 0.0;
+  double lo = window.front();
+  double hi = window.front();
+  for (double y : window) {
+    sum += y;
+    lo = qMin(lo, y);
+    hi = qMax(hi, y);
+  }
+  const double mean = sum / double(window.size());
+  double deviations = 0.0;
+  for (double y : window) {
+    deviations += (y - mean) * (y - mean);
+  }
+  const double deviation =
+      window.size() > 1 ? std::sqrt(deviations / double(window.size() - 1))
+                        : 0.0;
+
+  return statistics.count() == qint64(window.size()) &&
+         statistics.last() == window.back() && statistics.min() == lo &&
+         statistics.max() == hi &&
+         nearlyEqual(statistics.mean(), mean, 1e-12) &&
+         nearlyEqual(statistics.standardDeviation(), deviation, 1e-6);
+}
+
+static void rebuild(SeriesStatistics &statistics,
+                    const std::deque<double> &window) {
+  statistics.clear();
+  for (double y : window) {
+    statistics.append(y);
+  }
+}
+
+static void slidingWindow() {
+  const int size = 1000;
+  SeriesStatistics statistics;
+  statistics.clear();
+  std::deque<double> window;
+  quint32 state = 7;
+  bool ok = true;
+  bool invalidated = false;
+  bool rebuiltExact = true;
+
+  for (int i = 0; i < 60000; ++i) {
+    // The level jumps between -3 and 1e7 every 7000 samples
+    state = state * 1664525u + 1013904223u;
+    const double level = (i / 7000) % 2 ? 1e7 : -3.0;
+    const double y = level + std::sin(i * 0.01) + (state >> 16) * 1e-5;
+    statistics.append(y);
+    window.push_back(y);
+    if (int(window.size()) > size) {
+      statistics.removeFirst(window.front());
+      window.pop_front();
+    }
+
+    if (!statistics.isValid()) {
+      invalidated = true;
+      rebuild(statistics, window);
+      rebuiltExact = rebuiltExact && matches(statistics, window);
+    }
+    if (i % 997 == 0) {
+      ok = ok && matches(statistics, window);
+    }
+  }
+  check(ok, "reverse Welford tracks the window across level jumps");
+  check(invalidated, "statistics turn invalid after a window of evictions");
+  check(rebuiltExact, "rebuilt statistics match the window");
+  check(matches(statistics, window), "final window matches");
+}
+
+static void invalidation() {
+  SeriesStatistics statistics;
+  check(!statistics.isValid(), "new statistics are not maintained");
+  statistics.clear();
+  check(statistics.isValid(), "clear() starts maintaining");
+
+  std::deque<double> window;
+  for (int i = 0; i < 10; ++i) {
+    statistics.append(i);
+    window.push_back(i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    statistics.removeFirst(window.front());
+    window.pop_front();
+  }
+  check(statistics.isValid() && matches(statistics, window),
+        "fewer evictions than samples keep the statistics valid");
+  for (int i = 0; i < 2; ++i) {
+    statistics.removeFirst(window.front());
+    window.pop_front();
+  }
+  check(!statistics.isValid(), "as many evictions as samples invalidate");
+
+  rebuild(statistics, window);
+  check(statistics.isValid() && matches(statistics, window),
+        "rebuild restores valid statistics");
+
+  while (!window.empty()) {
+    statistics.removeFirst(window.front());
+    window.pop_front();
+  }
+  check(statistics.count() == 0 && statistics.mean() == 0.0 &&
+            statistics.standardDeviation() == 0.0,
+        "an emptied window reports zeros");
+  statistics.clear();
+  statistics.append(42.0);
+  check(statistics.mean() == 42.0 && statistics.standardDeviation() == 0.0 &&
+            statistics.min() == 42.0 && statistics.max() == 42.0,
+        "a single sample");
+
+  statistics.invalidate();
+  check(!statistics.isValid() && statistics.memoryUsage() == 0,
+        "invalidate() stops maintaining and frees the queues");
+}
+
+int main() {
+  slidingWindow();
+  invalidation();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "SeriesStatistics checks passed";
+  return 0;
+}
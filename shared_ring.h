@@ -0,0 +1,44 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <QAtomicInteger>
+#include <QtGlobal>
+
+// Layout of a sample ring in shared memory, written by one producer
+// process (SharedRingWriter) and read in place by any number of charts
+// (SharedRingSource). All fields are native-endian.
+//
+//   offset  size            field
+//   0       4               magic, SharedRingMagic ("XYSR")
+//   4       4               version, SharedRingVersion
+//   8       8               capacity: sample slots, a power of two
+//   16      8               written: samples ever published
+//   24      8               claimed: samples ever started
+//   32      32              reserved, zero
+//   64      16 * capacity   samples: x then y as doubles; sample i lives
+//                           in slot i & (capacity - 1)
+//
+// There are no locks. Before overwriting slots the producer advances
+// 'claimed' past the new samples, followed by a release fence; it then
+// fills the slots and stores 'written' with release ordering. Readers
+// load 'written' with acquire ordering, so every sample below it is
+// complete. Sample i stays valid while 'claimed' <= i + capacity; readers
+// check 'claimed' after copying (behind an acquire fence), so a slot
+// overwritten while it was being read is never shown as valid data.
+// Samples must be published in ascending x.
+struct SharedRingHeader {
+    quint32 magic;
+    quint32 version;
+    qint64 capacity;
+    QAtomicInteger<qint64> written;
+    QAtomicInteger<qint64> claimed;
+    char reserved[32];
+};
+
+static const quint32 SharedRingMagic = 0x52535958; // "XYSR"
+static const quint32 SharedRingVersion = 1;
+static const int SharedRingHeaderSize = 64;
+
+Q_STATIC_ASSERT(sizeof(SharedRingHeader) == SharedRingHeaderSize);
+
+#endif // SHARED_RING_H
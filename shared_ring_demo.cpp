@@ -0,0 +1,66 @@
+// Local harness for shared-memory ingestion: run one process as the
+// writer and one or more as viewers.
+//
+//   shared_ring_demo writer [key]   publishes a 100 kHz test signal
+//   shared_ring_demo viewer [key]   charts it with attachSharedRing()
+#include "shared_ring_writer.h"
+#include "xy_chart_widget.h"
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include <QtMath>
+
+static const double SampleRate = 100000.0;
+
+int main(int argc, char *argv[]) {
+  QApplication app(argc, argv);
+  const QStringList args = app.arguments();
+  const QString mode = args.value(1, "viewer");
+  const QString key = args.value(2, "xychart-demo-ring");
+
+  if (mode == "writer") {
+    // Ten seconds of samples; viewers show the newest five
+    SharedRingWriter writer;
+    if (!writer.create(key, qint64(SampleRate) * 10)) {
+      return 1;
+    }
+    qDebug() << "Writing to shared ring" << key << "- capacity"
+             << writer.capacity();
+
+    QElapsedTimer clock;
+    clock.start();
+    QVector<QPointF> batch;
+    QTimer timer;
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, [&]() {
+      // Catch up to the wall clock, as an acquisition card would
+      const qint64 due = clock.nsecsElapsed() * qint64(SampleRate) / 1000000000;
+      batch.resize(0);
+      for (qint64 i = writer.written(); i < due; ++i) {
+        const double t = i / SampleRate;
+        const double y = qSin(2.0 * M_PI * 5.0 * t) +
+                         0.3 * qSin(2.0 * M_PI * 130.0 * t) +
+                         0.05 * ((i * 7919) % 101 - 50) / 50.0;
+        batch.append(QPointF(t, y));
+      }
+      writer.append(batch.constData(), batch.size());
+    });
+    timer.start(5);
+    return app.exec();
+  }
+
+  XYChartWidget chart;
+  chart.setWindowTitle("Shared ring viewer - " + key);
+  chart.setTitle("Shared-memory ring: " + key);
+  chart.setXLabel("Time (s)");
+  chart.setYLabel("Value");
+  chart.resize(1000, 500);
+  if (!chart.attachSharedRing("ring", key)) {
+    qWarning() << "Start the writer first: shared_ring_demo writer" << key;
+    return 1;
+  }
+  chart.show();
+  return app.exec();
+}
@@ -0,0 +1,229 @@
+#include "shared_ring_source.h"
+#include <QDebug>
+#include <atomic>
+#include <limits>
+
+SharedRingSource::SharedRingSource()
+    : m_header(nullptr), m_samples(nullptr), m_mask(0), m_window(0),
+      m_first(0), m_published(0), m_summarized(0) {}
+
+SharedRingSource::~SharedRingSource() { detach(); }
+
+bool SharedRingSource::attach(const QString &key) {
+  detach();
+
+  m_memory.setKey(key);
+  if (!m_memory.attach(QSharedMemory::ReadOnly)) {
+    qWarning() << "Cannot attach shared ring" << key << ":"
+               << m_memory.errorString();
+    return false;
+  }
+
+  // The producer initializes the header under the segment lock
+  m_memory.lock();
+  const SharedRingHeader *header =
+      static_cast<const SharedRingHeader *>(m_memory.constData());
+  const qint64 size = m_memory.size();
+  const qint64 capacity =
+      size >= SharedRingHeaderSize ? header->capacity : qint64(0);
+  const bool valid = size >= SharedRingHeaderSize &&
+                     header->magic == SharedRingMagic &&
+                     header->version == SharedRingVersion && capacity >= 2 &&
+                     (capacity & (capacity - 1)) == 0 &&
+                     capacity <= (size - SharedRingHeaderSize) /
+                                     qint64(2 * sizeof(double));
+  m_memory.unlock();
+  if (!valid) {
+    qWarning() << "Shared memory" << key << "does not hold a sample ring";
+    m_memory.detach();
+    return false;
+  }
+
+  m_header = header;
+  m_samples = reinterpret_cast<const double *>(
+      static_cast<const char *>(m_memory.constData()) + SharedRingHeaderSize);
+  m_mask = capacity - 1;
+  m_window = capacity / 2;
+  // A window spans at most m_window / BlockSize + 1 blocks, plus the
+  // block being filled
+  const int blocks = int(m_window / BlockSize) + 2;
+  m_blockMin.fill(0.0, blocks);
+  m_blockMax.fill(0.0, blocks);
+  poll();
+  return true;
+}
+
+void SharedRingSource::detach() {
+  if (m_memory.isAttached()) {
+    m_memory.detach();
+  }
+  m_header = nullptr;
+  m_samples = nullptr;
+  m_mask = 0;
+  m_window = 0;
+  m_first = m_published = m_summarized = 0;
+  m_blockMin.clear();
+  m_blockMax.clear();
+}
+
+bool SharedRingSource::isAttached() const { return m_header != nullptr; }
+
+QString SharedRingSource::key() const { return m_memory.key(); }
+
+qint64 SharedRingSource::ringCapacity() const {
+  return m_header != nullptr ? m_mask + 1 : 0;
+}
+
+qint64 SharedRingSource::poll(QVector<QPointF> *evicted) {
+  if (m_header == nullptr) {
+    return 0;
+  }
+  const qint64 written = m_header->written.loadAcquire();
+  if (written <= m_published) {
+    return 0;
+  }
+  const qint64 added = written - m_published;
+  const qint64 first = qMax(m_first, written - m_window);
+  if (evicted != nullptr && first > m_first) {
+    // Still the old window here, so relative indices read the old samples
+    const qint64 leaving = qMin(first, m_published) - m_first;
+    const int offset = evicted->size();
+    evicted->resize(offset + int(leaving));
+    readPoints(0, leaving, evicted->data() + offset);
+  }
+  m_published = written;
+  m_first = first;
+
+  // Summarize only the new samples. After a gap longer than the window
+  // the block they start in is summarized afresh; its earlier samples are
+  // out of the window and never part of a whole-block query.
+  qint64 index = m_summarized;
+  bool fresh = false;
+  if (index < m_first) {
+    index = m_first;
+    fresh = true;
+  }
+  const int blocks = m_blockMin.size();
+  while (index < written) {
+    const qint64 block = index / BlockSize;
+    const qint64 end = qMin(written, (block + 1) * BlockSize);
+    const int slot = int(block % blocks);
+    double minY = std::numeric_limits<double>::infinity();
+    double maxY = -std::numeric_limits<double>::infinity();
+    if (!fresh && index % BlockSize != 0) {
+      minY = m_blockMin.at(slot);
+      maxY = m_blockMax.at(slot);
+    }
+    for (; index < end; ++index) {
+      const double y = m_samples[2 * (index & m_mask) + 1];
+      if (y < minY) {
+        minY = y;
+      }
+      if (y > maxY) {
+        maxY = y;
+      }
+    }
+    m_blockMin[slot] = minY;
+    m_blockMax[slot] = maxY;
+    fresh = false;
+  }
+  m_summarized = written;
+  return added;
+}
+
+qint64 SharedRingSource::overwrittenBelow() const {
+  // Slot reads before this point must not move past the check
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return m_header->claimed.load() - (m_mask + 1);
+}
+
+qint64 SharedRingSource::count() const { return m_published - m_first; }
+
+QPointF SharedRingSource::pointAt(qint64 index) const {
+  const qint64 i = m_first + index;
+  const double *slot = m_samples + 2 * (i & m_mask);
+  const QPointF point(slot[0], slot[1]);
+  if (i < overwrittenBelow()) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    return QPointF(nan, nan);
+  }
+  return point;
+}
+
+bool SharedRingSource::yRange(qint64 first, qint64 last, double &minY,
+                              double &maxY) const {
+  first = qMax<qint64>(first, 0);
+  last = qMin(last, count());
+
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+  const int blocks = m_blockMin.size();
+  while (first < last) {
+    lo = std::numeric_limits<double>::infinity();
+    hi = -std::numeric_limits<double>::infinity();
+    qint64 index = m_first + first;
+    const qint64 end = m_first + last;
+    while (index < end) {
+      const qint64 block = index / BlockSize;
+      const qint64 blockEnd = (block + 1) * BlockSize;
+      if (index % BlockSize == 0 && blockEnd <= end) {
+        const int slot = int(block % blocks);
+        lo = qMin(lo, m_blockMin.at(slot));
+        hi = qMax(hi, m_blockMax.at(slot));
+        index = blockEnd;
+        continue;
+      }
+      const qint64 stop = qMin(end, blockEnd);
+      for (; index < stop; ++index) {
+        const double y = m_samples[2 * (index & m_mask) + 1];
+        if (y < lo) {
+          lo = y;
+        }
+        if (y > hi) {
+          hi = y;
+        }
+      }
+    }
+    // As in readPoints(): samples the producer got to meanwhile read back
+    // as NaN, so they are left out and the rest is scanned again
+    const qint64 lost = overwrittenBelow() - m_first;
+    if (lost <= first) {
+      break;
+    }
+    first = lost;
+  }
+  if (first >= last || !(lo <= hi)) {
+    return false;
+  }
+  minY = lo;
+  maxY = hi;
+  return true;
+}
+
+qint64 SharedRingSource::readPoints(qint64 first, qint64 count,
+                                    QPointF *out) const {
+  first = qMax<qint64>(first, 0);
+  const qint64 last = qMin(first + count, this->count());
+  if (first >= last) {
+    return 0;
+  }
+  for (qint64 i = first; i < last; ++i) {
+    const double *slot = m_samples + 2 * ((m_first + i) & m_mask);
+    out[i - first] = QPointF(slot[0], slot[1]);
+  }
+  // One check for the whole copy: anything the producer got to meanwhile
+  // is blanked rather than shown
+  const qint64 lost = qMin(overwrittenBelow() - m_first, last);
+  if (lost > first) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (qint64 i = first; i < lost; ++i) {
+      out[i - first] = QPointF(nan, nan);
+    }
+  }
+  return last - first;
+}
+
+qint64 SharedRingSource::indexMemoryUsage() const {
+  return qint64(m_blockMin.capacity() + m_blockMax.capacity()) *
+         qint64(sizeof(double));
+}
@@ -0,0 +1,66 @@
+#ifndef SHARED_RING_SOURCE_H
+#define SHARED_RING_SOURCE_H
+
+#include "series_data_source.h"
+#include "shared_ring.h"
+#include <QSharedMemory>
+#include <QString>
+#include <QVector>
+
+// Samples read in place from a ring another process writes (layout in
+// shared_ring.h), so data reaches the chart without a copy per sample.
+// The source shows what the last poll() saw, limited to the newest half
+// of the ring: the producer may run up to half a ring ahead between
+// polls before shown samples are overwritten. Overwritten samples read
+// back as NaN. Y min/max of each block of BlockSize samples is recorded
+// as poll() picks samples up, so yRange() reads only partial blocks.
+class SharedRingSource : public SeriesDataSource {
+public:
+    static const int BlockSize = 1024;
+
+    SharedRingSource();
+    ~SharedRingSource();
+
+    bool attach(const QString &key);
+    void detach();
+    bool isAttached() const;
+    QString key() const;
+    qint64 ringCapacity() const;
+
+    // Takes in samples published since the last call and returns how
+    // many; count() changes only here. Call from one thread. Samples that
+    // leave the window are appended to 'evicted' when given, oldest
+    // first; those the producer overwrote before they could be read come
+    // back as NaN.
+    qint64 poll(QVector<QPointF> *evicted = nullptr);
+
+    qint64 count() const override;
+    QPointF pointAt(qint64 index) const override;
+    bool yRange(qint64 first, qint64 last, double &minY,
+                double &maxY) const override;
+    qint64 readPoints(qint64 first, qint64 count, QPointF *out) const override;
+    // Block summaries; the ring itself belongs to the producer
+    qint64 indexMemoryUsage() const override;
+
+private:
+    Q_DISABLE_COPY(SharedRingSource)
+
+    // Samples below this have been overwritten, or are being
+    qint64 overwrittenBelow() const;
+
+    QSharedMemory m_memory;
+    const SharedRingHeader *m_header;
+    const double *m_samples;
+    qint64 m_mask;
+    qint64 m_window;
+    // Absolute index of sample 0 and 'written' as of the last poll()
+    qint64 m_first;
+    qint64 m_published;
+
+    // Y min/max per block of absolute indices, block b in b % size()
+    QVector<double> m_blockMin;
+    QVector<double> m_blockMax;
+    qint64 m_summarized;
+};
+
+#endif // SHARED_RING_SOURCE_H
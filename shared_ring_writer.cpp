@@ -0,0 +1,104 @@
+#include "shared_ring_writer.h"
+#include <QDebug>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+SharedRingWriter::SharedRingWriter()
+    : m_header(nullptr), m_samples(nullptr), m_mask(0), m_written(0) {}
+
+SharedRingWriter::~SharedRingWriter() { close(); }
+
+bool SharedRingWriter::create(const QString &key, qint64 capacity) {
+  close();
+
+  qint64 slotCount = 2;
+  while (slotCount < capacity) {
+    slotCount *= 2;
+  }
+  const qint64 bytes =
+      SharedRingHeaderSize + slotCount * qint64(2 * sizeof(double));
+  if (bytes > std::numeric_limits<int>::max()) {
+    qWarning() << "Shared ring" << key << "is too large:" << slotCount
+               << "samples";
+    return false;
+  }
+
+  m_memory.setKey(key);
+  if (!m_memory.create(int(bytes))) {
+    // On Unix a segment outlives a producer that crashed; attaching and
+    // detaching as its last user removes it
+    if (m_memory.error() == QSharedMemory::AlreadyExists &&
+        m_memory.attach()) {
+      m_memory.detach();
+    }
+    if (!m_memory.create(int(bytes))) {
+      qWarning() << "Cannot create shared ring" << key << ":"
+                 << m_memory.errorString();
+      return false;
+    }
+  }
+
+  // Readers validate the header under the same lock; one that attaches
+  // before it is written sees no magic and gives up
+  m_memory.lock();
+  m_header = static_cast<SharedRingHeader *>(m_memory.data());
+  std::memset(m_memory.data(), 0, size_t(SharedRingHeaderSize));
+  m_header->magic = SharedRingMagic;
+  m_header->version = SharedRingVersion;
+  m_header->capacity = slotCount;
+  m_memory.unlock();
+
+  m_samples = reinterpret_cast<double *>(static_cast<char *>(m_memory.data()) +
+                                         SharedRingHeaderSize);
+  m_mask = slotCount - 1;
+  m_written = 0;
+  return true;
+}
+
+void SharedRingWriter::close() {
+  if (m_memory.isAttached()) {
+    m_memory.detach();
+  }
+  m_header = nullptr;
+  m_samples = nullptr;
+  m_mask = 0;
+  m_written = 0;
+}
+
+bool SharedRingWriter::isOpen() const { return m_header != nullptr; }
+
+QString SharedRingWriter::key() const { return m_memory.key(); }
+
+qint64 SharedRingWriter::capacity() const {
+  return m_header != nullptr ? m_mask + 1 : 0;
+}
+
+qint64 SharedRingWriter::written() const { return m_written; }
+
+void SharedRingWriter::append(double x, double y) {
+  const QPointF point(x, y);
+  append(&point, 1);
+}
+
+void SharedRingWriter::append(const QPointF *points, int count) {
+  if (m_header == nullptr || count <= 0) {
+    return;
+  }
+
+  const qint64 end = m_written + count;
+  // Readers learn which slots are about to change before any of them do
+  m_header->claimed.store(end);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  // Of a batch larger than the ring only the newest samples survive
+  const qint64 skipped = qMax<qint64>(0, count - (m_mask + 1));
+  for (qint64 i = skipped; i < count; ++i) {
+    double *slot = m_samples + 2 * ((m_written + i) & m_mask);
+    slot[0] = points[i].x();
+    slot[1] = points[i].y();
+  }
+
+  m_written = end;
+  m_header->written.storeRelease(end);
+}
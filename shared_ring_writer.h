@@ -0,0 +1,42 @@
+#ifndef SHARED_RING_WRITER_H
+#define SHARED_RING_WRITER_H
+
+#include "shared_ring.h"
+#include <QPointF>
+#include <QSharedMemory>
+#include <QString>
+
+// Producer side of a shared-memory sample ring (layout in shared_ring.h),
+// for acquisition processes feeding charts that attach with
+// XYChartWidget::attachSharedRing(). Only needs QtCore. One writer per
+// ring; appending never blocks on readers.
+class SharedRingWriter {
+public:
+    SharedRingWriter();
+    ~SharedRingWriter();
+
+    // Creates the ring with room for 'capacity' samples, rounded up to a
+    // power of two. A segment left behind by a producer that crashed is
+    // reclaimed. Readers can attach until close().
+    bool create(const QString &key, qint64 capacity);
+    void close();
+    bool isOpen() const;
+    QString key() const;
+    qint64 capacity() const;
+    qint64 written() const;
+
+    // Samples in ascending x; readers see each call's samples at once
+    void append(double x, double y);
+    void append(const QPointF *points, int count);
+
+private:
+    Q_DISABLE_COPY(SharedRingWriter)
+
+    QSharedMemory m_memory;
+    SharedRingHeader *m_header;
+    double *m_samples;
+    qint64 m_mask;
+    qint64 m_written;
+};
+
+#endif // SHARED_RING_WRITER_H
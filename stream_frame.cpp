@@ -0,0 +1,115 @@
+#include "stream_frame.h"
+#include <cstring>
+
+struct StreamFrameHeader {
+  quint16 magic;
+  quint8 version;
+  quint8 kind;
+  quint32 seriesId;
+  quint32 count;
+  quint32 reserved;
+};
+
+Q_STATIC_ASSERT(sizeof(StreamFrameHeader) == StreamFrameHeaderSize);
+
+// True unless Qt was built with qreal as float
+static const bool QPointFIsTwoDoubles = sizeof(QPointF) == 2 * sizeof(double);
+
+static char *appendHeader(QByteArray &out, quint32 seriesId,
+                          StreamFrameKind kind, int count, int payloadBytes) {
+  StreamFrameHeader header;
+  header.magic = StreamFrameMagic;
+  header.version = StreamFrameVersion;
+  header.kind = quint8(kind);
+  header.seriesId = seriesId;
+  header.count = quint32(count);
+  header.reserved = 0;
+
+  const int offset = out.size();
+  out.resize(offset + StreamFrameHeaderSize + payloadBytes);
+  char *frame = out.data() + offset;
+  std::memcpy(frame, &header, sizeof(header));
+  return frame + StreamFrameHeaderSize;
+}
+
+void appendStreamFrame(QByteArray &out, quint32 seriesId,
+                       const QPointF *points, int count) {
+  count = qBound(0, count, StreamFrameMaxSamples);
+  char *payload = appendHeader(out, seriesId, StreamFrameXY, count,
+                               count * int(2 * sizeof(double)));
+  if (QPointFIsTwoDoubles) {
+    std::memcpy(payload, static_cast<const void *>(points),
+                size_t(count) * sizeof(QPointF));
+    return;
+  }
+  for (int i = 0; i < count; ++i) {
+    const double xy[2] = {points[i].x(), points[i].y()};
+    std::memcpy(payload + i * sizeof(xy), xy, sizeof(xy));
+  }
+}
+
+void appendStreamFrame(QByteArray &out, quint32 seriesId, const double *y,
+                       int count, double x0, double dx) {
+  count = qBound(0, count, StreamFrameMaxSamples);
+  char *payload = appendHeader(out, seriesId, StreamFrameYOnly, count,
+                               (count + 2) * int(sizeof(double)));
+  std::memcpy(payload, &x0, sizeof(double));
+  std::memcpy(payload + sizeof(double), &dx, sizeof(double));
+  std::memcpy(payload + 2 * sizeof(double), y, size_t(count) * sizeof(double));
+}
+
+int parseStreamFrames(const char *data, int size,
+                      QHash<quint32, QVector<QPointF>> &series,
+                      qint64 &frames, qint64 &samples) {
+  int offset = 0;
+  while (size - offset >= StreamFrameHeaderSize) {
+    StreamFrameHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+    if (header.magic != StreamFrameMagic ||
+        header.version != StreamFrameVersion ||
+        header.count > quint32(StreamFrameMaxSamples) ||
+        (header.kind != StreamFrameXY && header.kind != StreamFrameYOnly)) {
+      return -1;
+    }
+
+    const int count = int(header.count);
+    const int payloadBytes = header.kind == StreamFrameXY
+                                 ? count * int(2 * sizeof(double))
+                                 : (count + 2) * int(sizeof(double));
+    if (size - offset - StreamFrameHeaderSize < payloadBytes) {
+      break;
+    }
+    const char *payload = data + offset + StreamFrameHeaderSize;
+
+    // Straight into the series' batch; XY payloads have the memory
+    // layout of QPointF wherever qreal is double
+    QVector<QPointF> &points = series[header.seriesId];
+    const int first = points.size();
+    points.resize(first + count);
+    QPointF *out = points.data() + first;
+    if (header.kind == StreamFrameXY && QPointFIsTwoDoubles) {
+      std::memcpy(static_cast<void *>(out), payload, size_t(payloadBytes));
+    } else if (header.kind == StreamFrameXY) {
+      for (int i = 0; i < count; ++i) {
+        double xy[2];
+        std::memcpy(xy, payload + i * sizeof(xy), sizeof(xy));
+        out[i] = QPointF(xy[0], xy[1]);
+      }
+    } else {
+      double x0, dx;
+      std::memcpy(&x0, payload, sizeof(double));
+      std::memcpy(&dx, payload + sizeof(double), sizeof(double));
+      const char *y = payload + 2 * sizeof(double);
+      for (int i = 0; i < count; ++i) {
+        double value;
+        std::memcpy(&value, y + i * sizeof(double), sizeof(double));
+        out[i] = QPointF(x0 + i * dx, value);
+      }
+    }
+
+    offset += StreamFrameHeaderSize + payloadBytes;
+    ++frames;
+    samples += count;
+  }
+  return offset;
+}
@@ -0,0 +1,50 @@
+#ifndef STREAM_FRAME_H
+#define STREAM_FRAME_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+
+// Binary frame carrying samples of one series, as sent to
+// StreamIngestServer. Little-endian, like the host on every supported
+// platform, so payloads are copied without conversion.
+//
+//   offset  size       field
+//   0       2          magic, StreamFrameMagic ("XS")
+//   2       1          version, StreamFrameVersion
+//   3       1          kind: StreamFrameXY or StreamFrameYOnly
+//   4       4          series id
+//   8       4          sample count, at most StreamFrameMaxSamples
+//   12      4          reserved, zero
+//   16                 XY:    count x {x, y} doubles
+//                      YOnly: x0, dx doubles, then count y doubles;
+//                             sample i is at x = x0 + i * dx
+//
+// Over TCP and local sockets frames follow each other in the byte
+// stream; over UDP every datagram holds one or more whole frames.
+enum StreamFrameKind {
+    StreamFrameXY = 0,
+    StreamFrameYOnly = 1
+};
+
+static const quint16 StreamFrameMagic = 0x5358; // "XS"
+static const quint8 StreamFrameVersion = 1;
+static const int StreamFrameHeaderSize = 16;
+static const int StreamFrameMaxSamples = 1 << 20;
+
+void appendStreamFrame(QByteArray &out, quint32 seriesId,
+                       const QPointF *points, int count);
+void appendStreamFrame(QByteArray &out, quint32 seriesId, const double *y,
+                       int count, double x0, double dx);
+
+// Decodes whole frames from the front of 'data', appending their samples
+// to 'series' by id. Returns the bytes consumed (a trailing partial frame
+// is left for the next call) and adds up the frames and samples decoded,
+// or returns -1 where the data stops being a frame stream.
+int parseStreamFrames(const char *data, int size,
+                      QHash<quint32, QVector<QPointF>> &series,
+                      qint64 &frames, qint64 &samples);
+
+#endif // STREAM_FRAME_H
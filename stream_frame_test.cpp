@@ -0,0 +1,180 @@
+// Checks parseStreamFrames() against frames built by appendStreamFrame():
+// a stream of mixed XY and YOnly frames decodes to exactly the samples
+// sent, however it is split into reads, and data that stops being a frame
+// stream is reported instead of decoded. Exits non-zero on the first
+// failure.
+#include "stream_frame.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+#include <cstring>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+// A stream for series 1..3 and the samples it carries, by id
+struct TestStream {
+  QByteArray bytes;
+  QHash<quint32, QVector<QPointF>> expected;
+  qint64 frames;
+  qint64 samples;
+};
+
+static TestStream makeStream() {
+  TestStream stream;
+  stream.frames = 0;
+  stream.samples = 0;
+  quint32 state = 17;
+  double x = 0.0;
+  for (int frame = 0; frame < 60; ++frame) {
+    state = state * 1664525u + 1013904223u;
+    const quint32 id = 1 + (state >> 16) % 3;
+    // Includes empty frames
+    const int count = int((state >> 8) % 97);
+    QVector<QPointF> &expected = stream.expected[id];
+
+    if (frame % 2 == 0) {
+      QVector<QPointF> points(count);
+      for (int i = 0; i < count; ++i) {
+        points[i] = QPointF(x, double(frame * 1000 + i) / 3.0);
+        x += 0.25;
+      }
+      appendStreamFrame(stream.bytes, id, points.constData(), count);
+      expected += points;
+    } else {
+      QVector<double> y(count);
+      for (int i = 0; i < count; ++i) {
+        y[i] = -double(frame * 1000 + i) / 7.0;
+        expected.append(QPointF(x + i * 0.5, y[i]));
+      }
+      appendStreamFrame(stream.bytes, id, y.constData(), count, x, 0.5);
+      x += count * 0.5;
+    }
+    ++stream.frames;
+    stream.samples += count;
+  }
+  return stream;
+}
+
+static bool sameSeries(const QHash<quint32, QVector<QPointF>> &series,
+                       const QHash<quint32, QVector<QPointF>> &expected) {
+  for (quint32 id = 1; id <= 3; ++id) {
+    const QVector<QPointF> points = series.value(id);
+    const QVector<QPointF> wanted = expected.value(id);
+    if (points.size() != wanted.size()) {
+      return false;
+    }
+    for (int i = 0; i < points.size(); ++i) {
+      if (points[i].x() != wanted[i].x() ||
+          points[i].y() != wanted[i].y()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void wholeStream() {
+  const TestStream stream = makeStream();
+  QHash<quint32, QVector<QPointF>> series;
+  qint64 frames = 0;
+  qint64 samples = 0;
+  const int consumed = parseStreamFrames(
+      stream.bytes.constData(), stream.bytes.size(), series, frames, samples);
+  check(consumed == stream.bytes.size(), "a whole stream is consumed");
+  check(frames == stream.frames && samples == stream.samples,
+        "frames and samples are counted");
+  check(sameSeries(series, stream.expected), "samples decode exactly");
+}
+
+static void splitReads() {
+  // Reads of every size from 1 byte up, as TCP may deliver them; the
+  // unconsumed tail is kept in front of the next read, like readStream()
+  const TestStream stream = makeStream();
+  bool ok = true;
+  for (int step = 1; step < 700 && ok; step += step < 40 ? 1 : 37) {
+    QHash<quint32, QVector<QPointF>> series;
+    qint64 frames = 0;
+    qint64 samples = 0;
+    QByteArray pending;
+    for (int offset = 0; offset < stream.bytes.size(); offset += step) {
+      pending.append(stream.bytes.mid(offset, step));
+      const int consumed = parseStreamFrames(
+          pending.constData(), pending.size(), series, frames, samples);
+      if (consumed < 0) {
+        ok = false;
+        break;
+      }
+      pending.remove(0, consumed);
+    }
+    ok = ok && pending.isEmpty() && frames == stream.frames &&
+         samples == stream.samples && sameSeries(series, stream.expected);
+  }
+  check(ok, "split reads decode the same samples");
+}
+
+static int parse(const QByteArray &bytes) {
+  QHash<quint32, QVector<QPointF>> series;
+  qint64 frames = 0;
+  qint64 samples = 0;
+  return parseStreamFrames(bytes.constData(), bytes.size(), series, frames,
+                           samples);
+}
+
+static QByteArray corrupted(QByteArray bytes, int offset, char value) {
+  bytes[offset] = value;
+  return bytes;
+}
+
+static void corruptFrames() {
+  QByteArray frame;
+  const QPointF points[] = {QPointF(1, 2), QPointF(3, 4)};
+  appendStreamFrame(frame, 9, points, 2);
+
+  check(parse(frame) == frame.size(), "an intact frame is accepted");
+  check(parse(corrupted(frame, 0, 'Z')) == -1, "bad magic is rejected");
+  check(parse(corrupted(frame, 2, char(StreamFrameVersion + 1))) == -1,
+        "unknown version is rejected");
+  check(parse(corrupted(frame, 3, 7)) == -1, "unknown kind is rejected");
+
+  QByteArray huge = frame;
+  const quint32 count = quint32(StreamFrameMaxSamples) + 1;
+  std::memcpy(huge.data() + 8, &count, sizeof(count));
+  check(parse(huge) == -1, "oversized count is rejected");
+
+  // Valid frames followed by garbage: the stream is broken from there on
+  QByteArray broken = frame + frame;
+  broken.append(QByteArray(StreamFrameHeaderSize, 'x'));
+  check(parse(broken) == -1, "garbage after valid frames is reported");
+
+  // Incomplete headers and payloads wait for more data
+  QHash<quint32, QVector<QPointF>> series;
+  qint64 frames = 0;
+  qint64 samples = 0;
+  check(parseStreamFrames(frame.constData(), StreamFrameHeaderSize - 1,
+                          series, frames, samples) == 0 &&
+            parseStreamFrames(frame.constData(), frame.size() - 1, series,
+                              frames, samples) == 0 &&
+            frames == 0 && series.value(9).isEmpty(),
+        "partial frames are left for the next call");
+}
+
+int main() {
+  wholeStream();
+  splitReads();
+  corruptFrames();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "Stream frame checks passed";
+  return 0;
+}
@@ -0,0 +1,201 @@
+// Loopback harness and throughput benchmark for StreamIngestServer.
+//
+//   stream_ingest_demo viewer    <tcp|local|udp> [port|name]
+//   stream_ingest_demo generator <tcp|local|udp> [port|name] [seconds] [series]
+//   stream_ingest_demo bench     <tcp|local|udp> [seconds] [series]
+//
+// The generator sends frames as fast as the transport takes them and
+// prints the rate it sent at; bench runs both ends in one process and
+// prints the sustained rate delivered to the chart.
+#include "stream_frame.h"
+#include "stream_ingest_server.h"
+#include "xy_chart_widget.h"
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtMath>
+
+static const quint16 DefaultPort = 5555;
+static const char *DefaultName = "xychart-stream";
+static const double SampleRate = 1000000.0;
+// XY frames of 2048 samples keep UDP datagrams at 32 KiB
+static const int UdpFrameSamples = 2048;
+static const int StreamFrameSamples = 8192;
+static const qint64 MaxQueuedBytes = 4 * 1024 * 1024;
+
+// Returns the samples sent, or -1 if the server was not reachable
+static qint64 generate(const QString &transport, const QString &target,
+                       int seconds, int seriesCount) {
+  QTcpSocket tcp;
+  QLocalSocket local;
+  QUdpSocket udp;
+  QIODevice *device = nullptr;
+  if (transport == "tcp") {
+    tcp.connectToHost(QHostAddress::LocalHost, target.toUShort());
+    if (!tcp.waitForConnected(3000)) {
+      qWarning() << "Cannot connect:" << tcp.errorString();
+      return -1;
+    }
+    device = &tcp;
+  } else if (transport == "local") {
+    local.connectToServer(target);
+    if (!local.waitForConnected(3000)) {
+      qWarning() << "Cannot connect:" << local.errorString();
+      return -1;
+    }
+    device = &local;
+  }
+
+  const int frameSamples =
+      device == nullptr ? UdpFrameSamples : StreamFrameSamples;
+  // One period of the test signal, replayed with advancing x
+  QVector<double> wave(frameSamples);
+  for (int i = 0; i < frameSamples; ++i) {
+    wave[i] = qSin(2.0 * M_PI * i / frameSamples) +
+              0.2 * qSin(2.0 * M_PI * 17.0 * i / frameSamples);
+  }
+
+  QVector<QPointF> points(frameSamples);
+  QByteArray frame;
+  qint64 sent = 0;
+  qint64 index = 0;
+  QElapsedTimer clock;
+  clock.start();
+  while (clock.elapsed() < seconds * 1000) {
+    for (int s = 0; s < seriesCount; ++s) {
+      for (int i = 0; i < frameSamples; ++i) {
+        points[i] = QPointF((index + i) / SampleRate, wave.at(i) + s);
+      }
+      frame.resize(0);
+      appendStreamFrame(frame, quint32(s + 1), points.constData(),
+                        frameSamples);
+      if (device == nullptr) {
+        udp.writeDatagram(frame, QHostAddress::LocalHost, target.toUShort());
+      } else {
+        device->write(frame);
+        while (device->bytesToWrite() > MaxQueuedBytes) {
+          device->waitForBytesWritten(100);
+        }
+      }
+    }
+    index += frameSamples;
+    sent += qint64(frameSamples) * seriesCount;
+  }
+
+  if (device != nullptr) {
+    while (device->bytesToWrite() > 0 && device->waitForBytesWritten(1000)) {
+    }
+    device->close();
+  }
+  const qint64 ms = qMax<qint64>(clock.elapsed(), 1);
+  qDebug() << "Sent" << sent << "samples in" << ms << "ms:"
+           << qRound64(sent * 1000.0 / ms) << "samples/s";
+  return sent;
+}
+
+class GeneratorThread : public QThread {
+public:
+  GeneratorThread(const QString &transport, const QString &target,
+                  int seconds, int seriesCount)
+      : m_transport(transport), m_target(target), m_seconds(seconds),
+        m_seriesCount(seriesCount) {}
+
+protected:
+  void run() override {
+    generate(m_transport, m_target, m_seconds, m_seriesCount);
+  }
+
+private:
+  QString m_transport;
+  QString m_target;
+  int m_seconds;
+  int m_seriesCount;
+};
+
+static void printRate(const StreamIngestServer &server) {
+  qDebug() << "Delivered" << server.samplesDelivered() << "of"
+           << server.samplesReceived() << "samples received in"
+           << server.framesReceived() << "frames," << server.samplesDropped()
+           << "dropped:" << qRound64(server.samplesPerSecond())
+           << "samples/s";
+}
+
+int main(int argc, char *argv[]) {
+  QApplication app(argc, argv);
+  const QStringList args = app.arguments();
+  const QString mode = args.value(1, "bench");
+  const QString transport = args.value(2, "tcp");
+  const QString defaultTarget =
+      transport == "local" ? QString(DefaultName) : QString::number(DefaultPort);
+
+  if (mode == "generator") {
+    const QString target = args.value(3, defaultTarget);
+    const int seconds = args.value(4, "10").toInt();
+    const int seriesCount = qMax(1, args.value(5, "1").toInt());
+    return generate(transport, target, seconds, seriesCount) < 0 ? 1 : 0;
+  }
+
+  XYChartWidget chart;
+  chart.setWindowTitle("Stream ingest - " + transport);
+  chart.setTitle("Streamed samples (" + transport + ")");
+  chart.setXLabel("Time (s)");
+  chart.setYLabel("Value");
+  chart.setMaxPointsPerSeries(1000000);
+  chart.resize(1000, 500);
+  chart.show();
+
+  StreamIngestServer server(&chart);
+  const bool bench = mode == "bench";
+  // The benchmark takes any free port
+  const QString target = bench ? defaultTarget : args.value(3, defaultTarget);
+  const quint16 port = bench ? 0 : target.toUShort();
+  bool listening = false;
+  if (transport == "local") {
+    listening = server.listenLocal(target);
+  } else if (transport == "udp") {
+    listening = server.listenUdp(port);
+  } else {
+    listening = server.listenTcp(port);
+  }
+  if (!listening) {
+    return 1;
+  }
+
+  QTimer report;
+  QObject::connect(&report, &QTimer::timeout,
+                   [&server]() { printRate(server); });
+  report.start(1000);
+
+  GeneratorThread *generator = nullptr;
+  if (bench) {
+    const int seconds = args.value(3, "10").toInt();
+    const int seriesCount = qMax(1, args.value(4, "1").toInt());
+    generator = new GeneratorThread(
+        transport,
+        transport == "local" ? target : QString::number(server.serverPort()),
+        seconds, seriesCount);
+    // Let data still in transit be read; close() hands the rest to the
+    // chart before the final figure
+    QObject::connect(generator, &QThread::finished, &app, [&]() {
+      QTimer::singleShot(500, &app, [&]() {
+        server.close();
+        qDebug() << "Sustained:";
+        printRate(server);
+        app.quit();
+      });
+    });
+    generator->start();
+  }
+
+  const int result = app.exec();
+  if (generator != nullptr) {
+    generator->wait();
+    delete generator;
+  }
+  return result;
+}
@@ -0,0 +1,368 @@
+#include "stream_ingest_server.h"
+#include "stream_frame.h"
+#include "xy_chart_widget.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QWaitCondition>
+#include <utility>
+
+// Owns the sockets and runs their event loop; decoded samples collect in
+// m_batches until the next post to the server's thread
+class StreamReceiveThread : public QThread {
+public:
+  StreamReceiveThread(StreamIngestServer *server,
+                      StreamIngestServer::Transport transport,
+                      const QString &name, quint16 port,
+                      const QHostAddress &address)
+      : m_server(server), m_transport(transport), m_name(name), m_port(port),
+        m_address(address), m_started(false), m_listening(false) {}
+
+  // Blocks until the sockets listen or have failed to
+  bool waitListening(QString &message, quint16 &port) {
+    QMutexLocker locker(&m_mutex);
+    while (!m_started) {
+      m_wake.wait(&m_mutex);
+    }
+    message = m_message;
+    port = m_port;
+    return m_listening;
+  }
+
+  // What was decoded after the last post; once the thread has finished
+  QHash<quint32, QVector<QPointF>> takeBatches() {
+    trim();
+    QHash<quint32, QVector<QPointF>> batches;
+    batches.swap(m_batches);
+    return batches;
+  }
+
+protected:
+  void run() override {
+    QTcpServer tcpServer;
+    QLocalServer localServer;
+    QUdpSocket udpSocket;
+
+    bool ok = false;
+    QString message;
+    quint16 port = 0;
+    if (m_transport == StreamIngestServer::Tcp) {
+      ok = tcpServer.listen(m_address, m_port);
+      port = tcpServer.serverPort();
+      message = tcpServer.errorString();
+    } else if (m_transport == StreamIngestServer::Local) {
+      // A socket file left by a crashed server would block the name
+      QLocalServer::removeServer(m_name);
+      ok = localServer.listen(m_name);
+      message = localServer.errorString();
+    } else {
+      ok = udpSocket.bind(m_address, m_port);
+      port = udpSocket.localPort();
+      message = udpSocket.errorString();
+    }
+    {
+      QMutexLocker locker(&m_mutex);
+      m_started = true;
+      m_listening = ok;
+      m_message = message;
+      m_port = port;
+      m_wake.wakeAll();
+    }
+    if (!ok) {
+      return;
+    }
+
+    QObject::connect(&tcpServer, &QTcpServer::newConnection, [&]() {
+      while (QTcpSocket *socket = tcpServer.nextPendingConnection()) {
+        addConnection(socket);
+      }
+    });
+    QObject::connect(&localServer, &QLocalServer::newConnection, [&]() {
+      while (QLocalSocket *socket = localServer.nextPendingConnection()) {
+        addConnection(socket);
+      }
+    });
+    QObject::connect(&udpSocket, &QUdpSocket::readyRead,
+                     [&]() { readDatagrams(udpSocket); });
+
+    QTimer postTimer;
+    QObject::connect(&postTimer, &QTimer::timeout, [this]() { post(); });
+    postTimer.start(StreamIngestServer::PostIntervalMs);
+
+    exec();
+
+    // Connections go down with their servers; nothing may call back
+    for (QIODevice *socket : m_buffers.keys()) {
+      QObject::disconnect(socket, nullptr, nullptr, nullptr);
+    }
+    m_buffers.clear();
+    // StreamIngestServer::close() takes the last batches
+  }
+
+private:
+  template <class Socket> void addConnection(Socket *socket) {
+    m_buffers.insert(socket, QByteArray());
+    QObject::connect(socket, &Socket::readyRead, socket,
+                     [this, socket]() { readStream(socket); });
+    QObject::connect(socket, &Socket::disconnected, socket,
+                     [this, socket]() {
+                       readStream(socket);
+                       m_buffers.remove(socket);
+                       socket->deleteLater();
+                     });
+  }
+
+  void readStream(QIODevice *socket) {
+    auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+      return;
+    }
+    QByteArray &buffer = it.value();
+    const QByteArray data = socket->readAll();
+    if (data.isEmpty()) {
+      return;
+    }
+    m_server->m_bytes.fetchAndAddRelaxed(data.size());
+    if (buffer.isEmpty()) {
+      buffer = data;
+    } else {
+      buffer.append(data);
+    }
+
+    const int consumed =
+        decode(buffer.constData(), buffer.size(), m_batches, false);
+    if (consumed < 0) {
+      // Framing is lost for good: drop the client rather than guess
+      m_buffers.erase(it);
+      socket->close();
+      postError(QString("Corrupt frame stream; connection closed"));
+      return;
+    }
+    buffer.remove(0, consumed);
+  }
+
+  void readDatagrams(QUdpSocket &socket) {
+    while (socket.hasPendingDatagrams()) {
+      m_datagram.resize(int(qMax<qint64>(socket.pendingDatagramSize(), 0)));
+      const qint64 size =
+          socket.readDatagram(m_datagram.data(), m_datagram.size());
+      if (size <= 0) {
+        continue;
+      }
+      m_server->m_bytes.fetchAndAddRelaxed(size);
+      // Frames never span datagrams, so a partial one is garbage too.
+      // Frames go to the batches only once the whole datagram decoded.
+      QHash<quint32, QVector<QPointF>> frames;
+      const int consumed =
+          decode(m_datagram.constData(), int(size), frames, true);
+      if (consumed != int(size)) {
+        postError(QString("Corrupt datagram discarded"));
+        continue;
+      }
+      for (auto it = frames.begin(); it != frames.end(); ++it) {
+        QVector<QPointF> &batch = m_batches[it.key()];
+        if (batch.isEmpty()) {
+          batch.swap(it.value());
+        } else {
+          batch += it.value();
+        }
+      }
+    }
+  }
+
+  // Decoded samples count as received; with 'atomic', those of a buffer
+  // that turns out corrupt count as dropped too
+  int decode(const char *data, int size,
+             QHash<quint32, QVector<QPointF>> &batches, bool atomic) {
+    qint64 frames = 0;
+    qint64 samples = 0;
+    const int consumed =
+        parseStreamFrames(data, size, batches, frames, samples);
+    m_server->m_frames.fetchAndAddRelaxed(frames);
+    m_server->m_samples.fetchAndAddRelaxed(samples);
+    if (atomic && consumed != size) {
+      m_server->m_dropped.fetchAndAddRelaxed(samples);
+    }
+    return consumed;
+  }
+
+  // Bounds what waits for a GUI thread that is falling behind
+  void trim() {
+    for (auto it = m_batches.begin(); it != m_batches.end(); ++it) {
+      const int excess = it->size() - StreamIngestServer::MaxPendingSamples;
+      if (excess > 0) {
+        it->remove(0, excess);
+        m_server->m_dropped.fetchAndAddRelaxed(excess);
+      }
+    }
+  }
+
+  void post() {
+    trim();
+    // One batch in flight at a time; the next one merges meanwhile
+    if (m_batches.isEmpty() || m_server->m_inFlight.loadAcquire() > 0) {
+      return;
+    }
+    m_server->m_inFlight.ref();
+
+    QHash<quint32, QVector<QPointF>> batches;
+    batches.swap(m_batches);
+    StreamIngestServer *server = m_server;
+    QMetaObject::invokeMethod(
+        server,
+        [server, batches]() mutable {
+          server->m_inFlight.deref();
+          server->deliver(std::move(batches));
+        },
+        Qt::QueuedConnection);
+  }
+
+  void postError(const QString &message) {
+    StreamIngestServer *server = m_server;
+    QMetaObject::invokeMethod(
+        server, [server, message]() { server->reportError(message); },
+        Qt::QueuedConnection);
+  }
+
+  StreamIngestServer *m_server;
+  const StreamIngestServer::Transport m_transport;
+  const QString m_name;
+  quint16 m_port;
+  const QHostAddress m_address;
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  bool m_started;
+  bool m_listening;
+  QString m_message;
+
+  // Touched only by the thread
+  QHash<QIODevice *, QByteArray> m_buffers;
+  QHash<quint32, QVector<QPointF>> m_batches;
+  QByteArray m_datagram;
+};
+
+StreamIngestServer::StreamIngestServer(XYChartWidget *chart, QObject *parent)
+    : QObject(parent), m_chart(chart), m_thread(nullptr), m_transport(Tcp),
+      m_port(0), m_inFlight(0), m_frames(0), m_samples(0), m_bytes(0),
+      m_dropped(0), m_delivered(0), m_elapsedMs(0) {}
+
+StreamIngestServer::~StreamIngestServer() { close(); }
+
+void StreamIngestServer::mapSeries(quint32 seriesId,
+                                   const QString &seriesName) {
+  m_seriesNames.insert(seriesId, seriesName);
+}
+
+QString StreamIngestServer::seriesName(quint32 seriesId) const {
+  return m_seriesNames.value(seriesId, QString("stream %1").arg(seriesId));
+}
+
+bool StreamIngestServer::listenTcp(quint16 port, const QHostAddress &address) {
+  return start(Tcp, QString(), port, address);
+}
+
+bool StreamIngestServer::listenLocal(const QString &name) {
+  return start(Local, name, 0, QHostAddress());
+}
+
+bool StreamIngestServer::listenUdp(quint16 port, const QHostAddress &address) {
+  return start(Udp, QString(), port, address);
+}
+
+bool StreamIngestServer::start(Transport transport, const QString &name,
+                               quint16 port, const QHostAddress &address) {
+  if (isListening() || m_chart.isNull()) {
+    qWarning() << "StreamIngestServer: cannot start listening";
+    return false;
+  }
+
+  m_transport = transport;
+  m_frames.store(0);
+  m_samples.store(0);
+  m_bytes.store(0);
+  m_dropped.store(0);
+  m_delivered = 0;
+  m_elapsedMs = 0;
+
+  m_thread = new StreamReceiveThread(this, transport, name, port, address);
+  m_thread->start();
+  QString message;
+  if (!m_thread->waitListening(message, m_port)) {
+    qWarning() << "StreamIngestServer: cannot listen:" << message;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    return false;
+  }
+  m_elapsed.start();
+  return true;
+}
+
+void StreamIngestServer::close() {
+  if (!m_thread) {
+    return;
+  }
+  m_thread->quit();
+  m_thread->wait();
+  m_elapsedMs = m_elapsed.elapsed();
+  // The batch still queued for this thread, then what arrived after it:
+  // both reach the chart, in order, before close() returns
+  QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+  deliver(m_thread->takeBatches());
+  delete m_thread;
+  m_thread = nullptr;
+}
+
+bool StreamIngestServer::isListening() const { return m_thread != nullptr; }
+
+StreamIngestServer::Transport StreamIngestServer::transport() const {
+  return m_transport;
+}
+
+quint16 StreamIngestServer::serverPort() const { return m_port; }
+
+qint64 StreamIngestServer::framesReceived() const { return m_frames.load(); }
+
+qint64 StreamIngestServer::samplesReceived() const {
+  return m_samples.load();
+}
+
+qint64 StreamIngestServer::bytesReceived() const { return m_bytes.load(); }
+
+qint64 StreamIngestServer::samplesDropped() const { return m_dropped.load(); }
+
+qint64 StreamIngestServer::samplesDelivered() const { return m_delivered; }
+
+qint64 StreamIngestServer::elapsedMs() const {
+  return isListening() ? m_elapsed.elapsed() : m_elapsedMs;
+}
+
+double StreamIngestServer::samplesPerSecond() const {
+  qint64 ms = elapsedMs();
+  return ms > 0 ? m_delivered * 1000.0 / ms : 0.0;
+}
+
+void StreamIngestServer::deliver(QHash<quint32, QVector<QPointF>> batches) {
+  if (m_chart.isNull()) {
+    return;
+  }
+  for (auto it = batches.begin(); it != batches.end(); ++it) {
+    if (!it->isEmpty()) {
+      m_delivered += it->size();
+      m_chart->addPoints(seriesName(it.key()), std::move(it.value()));
+    }
+  }
+}
+
+void StreamIngestServer::reportError(const QString &message) {
+  emit error(message);
+}
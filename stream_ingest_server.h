@@ -0,0 +1,105 @@
+#ifndef STREAM_INGEST_SERVER_H
+#define STREAM_INGEST_SERVER_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+class XYChartWidget;
+class StreamReceiveThread;
+
+// Streams samples from other programs into an XYChartWidget over a TCP
+// port, a local socket (Unix domain socket / Windows named pipe) or a UDP
+// port, using the binary frames of stream_frame.h.
+//
+// Sockets live on a background thread, which decodes frames straight
+// into per-series batches and hands them to the GUI thread every
+// PostIntervalMs; each batch reaches the chart as one addPoints() call.
+// While the GUI thread is still busy with the previous batches, new
+// samples keep accumulating, up to MaxPendingSamples per series, after
+// which the oldest are dropped. close() delivers whatever is still
+// pending. A corrupt stream closes its connection; a corrupt datagram is
+// discarded.
+class StreamIngestServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Transport { Tcp, Local, Udp };
+
+    static const int PostIntervalMs = 10;
+    static const int MaxPendingSamples = 1 << 22;
+
+    explicit StreamIngestServer(XYChartWidget *chart, QObject *parent = nullptr);
+    ~StreamIngestServer();
+
+    // Frames with 'seriesId' go to 'seriesName'; unmapped ids are shown
+    // as "stream <id>"
+    void mapSeries(quint32 seriesId, const QString &seriesName);
+    QString seriesName(quint32 seriesId) const;
+
+    // Port 0 picks a free port, see serverPort()
+    bool listenTcp(quint16 port,
+                   const QHostAddress &address = QHostAddress::LocalHost);
+    bool listenLocal(const QString &name);
+    bool listenUdp(quint16 port,
+                   const QHostAddress &address = QHostAddress::LocalHost);
+    void close();
+    bool isListening() const;
+    Transport transport() const;
+    quint16 serverPort() const;
+
+    // Throughput since listening started. Received counts are taken as
+    // frames are decoded; delivered samples are those handed to the chart,
+    // which after close() are all received ones not dropped.
+    qint64 framesReceived() const;
+    qint64 samplesReceived() const;
+    qint64 bytesReceived() const;
+    // Received samples never delivered: those trimmed by MaxPendingSamples
+    // and those of whole frames in a discarded datagram. Bytes that do not
+    // decode (the rest of a corrupt stream or datagram) hold no countable
+    // samples; see bytesReceived().
+    qint64 samplesDropped() const;
+    qint64 samplesDelivered() const;
+    qint64 elapsedMs() const;
+    // Delivered samples per second
+    double samplesPerSecond() const;
+
+signals:
+    void error(const QString &message);
+
+private:
+    friend class StreamReceiveThread;
+
+    bool start(Transport transport, const QString &name, quint16 port,
+               const QHostAddress &address);
+    void deliver(QHash<quint32, QVector<QPointF>> batches);
+    void reportError(const QString &message);
+
+    QPointer<XYChartWidget> m_chart;
+    StreamReceiveThread *m_thread;
+    Transport m_transport;
+    quint16 m_port;
+    QHash<quint32, QString> m_seriesNames;
+    // Batches posted by the thread and not yet delivered
+    QAtomicInt m_inFlight;
+
+    // Counted by the thread
+    QAtomicInteger<qint64> m_frames;
+    QAtomicInteger<qint64> m_samples;
+    QAtomicInteger<qint64> m_bytes;
+    QAtomicInteger<qint64> m_dropped;
+    // Counted on the server's thread
+    qint64 m_delivered;
+    QElapsedTimer m_elapsed;
+    qint64 m_elapsedMs;
+};
+
+#endif // STREAM_INGEST_SERVER_H
@@ -1,4 +1,4 @@
-QT += core gui widgets
+QT += core gui widgets network
 
 CONFIG += c++11
 
@@ -7,10 +7,55 @@ TEMPLATE = app
 
 SOURCES += \
     xy_chart_widget.cpp \
+    series_data_source.cpp \
+    mapped_series_file.cpp \
+    series_file_loader.cpp \
+    marker_sprite.cpp \
+    density_raster.cpp \
+    persistence_buffer.cpp \
+    tiered_history.cpp \
+    compressed_series.cpp \
+    range_statistics.cpp \
+    series_statistics.cpp \
+    trigger_engine.cpp \
+    derived_series.cpp \
+    chart_update_scheduler.cpp \
+    render_quality_governor.cpp \
+    log_column.cpp \
+    annotation_layer.cpp \
+    threshold_monitor.cpp \
+    shared_ring_source.cpp \
+    shared_ring_writer.cpp \
+    stream_frame.cpp \
+    stream_ingest_server.cpp \
     test_save_graph.cpp
 
 HEADERS += \
-    xy_chart_widget.h
+    xy_chart_widget.h \
+    ring_buffer.h \
+    series_data_source.h \
+    mapped_series_file.h \
+    series_file_loader.h \
+    marker_sprite.h \
+    density_raster.h \
+    persistence_buffer.h \
+    tiered_history.h \
+    compressed_series.h \
+    sample_series.h \
+    range_statistics.h \
+    series_statistics.h \
+    trigger_engine.h \
+    derived_series.h \
+    chart_update_scheduler.h \
+    render_quality_governor.h \
+    log_column.h \
+    annotation_layer.h \
+    threshold_monitor.h \
+    shared_ring.h \
+    shared_ring_source.h \
+    shared_ring_writer.h \
+    stream_frame.h \
+    stream_ingest_server.h
 
 # Build settings
 DESTDIR = bin
@@ -0,0 +1,117 @@
+#include "threshold_monitor.h"
+#include <QtAlgorithms>
+
+ThresholdMonitor::ThresholdMonitor(double lower, double upper,
+                                   const QColor &color)
+    : m_lower(qMin(lower, upper)), m_upper(qMax(lower, upper)),
+      m_color(color), m_fedSamples(0), m_hasPrevious(false),
+      m_violating(false), m_openStart(0.0) {
+  m_regions.setCapacity(MaxRegions);
+}
+
+double ThresholdMonitor::lower() const { return m_lower; }
+
+double ThresholdMonitor::upper() const { return m_upper; }
+
+QColor ThresholdMonitor::color() const { return m_color; }
+
+qint64 ThresholdMonitor::fedSamples() const { return m_fedSamples; }
+
+void ThresholdMonitor::setFedSamples(qint64 samples) {
+  m_fedSamples = samples;
+}
+
+void ThresholdMonitor::process(const QPointF *points, int count,
+                               QVector<ThresholdCrossing> &crossings) {
+  double y[64];
+  for (int base = 0; base < count; base += 64) {
+    const int n = qMin(64, count - base);
+    const QPointF *block = points + base;
+    for (int i = 0; i < n; ++i) {
+      y[i] = block[i].y();
+    }
+
+    // Bit i of 'changes' is set where sample i's state differs from the
+    // state before it; most blocks have none
+    const quint64 outside = outsideMask(y, n, m_lower, m_upper);
+    const quint64 before = (outside << 1) | quint64(m_violating);
+    quint64 changes = outside ^ before;
+    if (n < 64) {
+      changes &= (quint64(1) << n) - 1;
+    }
+
+    while (changes != 0) {
+      const int i = int(qCountTrailingZeroBits(changes));
+      changes &= changes - 1;
+      const QPointF &current = block[i];
+      const QPointF previous =
+          i > 0 ? block[i - 1] : (m_hasPrevious ? m_previous : current);
+
+      ThresholdCrossing crossing;
+      crossing.violating = (outside >> i) & 1;
+      if (crossing.violating) {
+        crossing.point = crossingPoint(previous, current);
+        m_openStart = crossing.point.x();
+      } else {
+        crossing.point = crossingPoint(current, previous);
+        m_regions.append(ViolationRegion(m_openStart, crossing.point.x()));
+      }
+      crossings.append(crossing);
+    }
+
+    m_violating = (outside >> (n - 1)) & 1;
+    m_previous = block[n - 1];
+    m_hasPrevious = true;
+  }
+}
+
+void ThresholdMonitor::reset() {
+  if (m_violating && m_hasPrevious) {
+    m_regions.append(ViolationRegion(m_openStart, m_previous.x()));
+  }
+  m_violating = false;
+  m_hasPrevious = false;
+}
+
+void ThresholdMonitor::clear() {
+  m_violating = false;
+  m_hasPrevious = false;
+  m_regions.clear();
+}
+
+bool ThresholdMonitor::isViolating() const { return m_violating; }
+
+const RingBuffer<ViolationRegion> &ThresholdMonitor::regions() const {
+  return m_regions;
+}
+
+ViolationRegion ThresholdMonitor::openRegion() const {
+  return ViolationRegion(m_openStart, m_previous.x());
+}
+
+qint64 ThresholdMonitor::memoryUsage() const {
+  return m_regions.memoryUsage();
+}
+
+quint64 ThresholdMonitor::outsideMask(const double *y, int count,
+                                      double lower, double upper) {
+  // Plain compares OR-ed into the mask, which compilers vectorize
+  quint64 mask = 0;
+  for (int i = 0; i < count; ++i) {
+    mask |= quint64((y[i] < lower) | (y[i] > upper)) << i;
+  }
+  return mask;
+}
+
+QPointF ThresholdMonitor::crossingPoint(const QPointF &inside,
+                                        const QPointF &outside) const {
+  // Interpolated along the segment to the limit that was passed
+  const double limit = outside.y() > m_upper ? m_upper : m_lower;
+  const double dy = outside.y() - inside.y();
+  double x = outside.x();
+  if (dy != 0.0 && inside.x() != outside.x()) {
+    const double t = qBound(0.0, (limit - inside.y()) / dy, 1.0);
+    x = inside.x() + t * (outside.x() - inside.x());
+  }
+  return QPointF(x, limit);
+}
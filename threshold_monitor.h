@@ -0,0 +1,84 @@
+#ifndef THRESHOLD_MONITOR_H
+#define THRESHOLD_MONITOR_H
+
+#include "ring_buffer.h"
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+
+// A series entering or leaving violation of its threshold band
+struct ThresholdCrossing {
+    // Where the line between the two samples crossed the limit
+    QPointF point;
+    // True when leaving the band, false when returning into it
+    bool violating;
+};
+
+// An x range during which a series was outside its band
+struct ViolationRegion {
+    double start;
+    double end;
+
+    ViolationRegion() : start(0.0), end(0.0) {}
+    ViolationRegion(double s, double e) : start(s), end(e) {}
+};
+
+// Checks a series' samples against a [lower, upper] band as they arrive.
+// Samples are classified 64 at a time into a bit mask without branches;
+// only where the mask differs from the previous sample's state is any
+// work done, so a series that stays in (or out of) its band costs one
+// compare pair per sample. Violation regions are kept, newest last, for
+// shading, up to MaxRegions of them.
+class ThresholdMonitor {
+public:
+    static const int MaxRegions = 4096;
+
+    // Use -inf/+inf for a one-sided band
+    ThresholdMonitor(double lower, double upper, const QColor &color);
+
+    double lower() const;
+    double upper() const;
+    QColor color() const;
+
+    // Samples already checked, counted like DataSeries::samplesAppended
+    qint64 fedSamples() const;
+    void setFedSamples(qint64 samples);
+
+    // Takes the samples following those of the previous call, in ascending
+    // x; crossings are appended to 'crossings'
+    void process(const QPointF *points, int count,
+                 QVector<ThresholdCrossing> &crossings);
+    // The next samples do not continue the previous ones
+    void reset();
+    // Also forgets the violation regions
+    void clear();
+
+    bool isViolating() const;
+    // Closed regions, oldest first
+    const RingBuffer<ViolationRegion> &regions() const;
+    // The region still open while violating, up to the last sample
+    ViolationRegion openRegion() const;
+
+    qint64 memoryUsage() const;
+
+    // Bit i set when y[i] lies outside [lower, upper]; count <= 64
+    static quint64 outsideMask(const double *y, int count, double lower,
+                               double upper);
+
+private:
+    QPointF crossingPoint(const QPointF &inside, const QPointF &outside) const;
+
+    double m_lower;
+    double m_upper;
+    QColor m_color;
+    qint64 m_fedSamples;
+
+    bool m_hasPrevious;
+    QPointF m_previous;
+    bool m_violating;
+    double m_openStart;
+    RingBuffer<ViolationRegion> m_regions;
+};
+
+#endif // THRESHOLD_MONITOR_H
@@ -0,0 +1,154 @@
+// Checks ThresholdMonitor's 64-sample masks: outsideMask() must agree with
+// a per-sample compare for every block length and bit position, and
+// process() must report the same crossings as a sample-by-sample state
+// machine however the samples are split into calls. Exits non-zero on the
+// first failure.
+#include "threshold_monitor.h"
+#include <QColor>
+#include <QDebug>
+#include <QPointF>
+#include <QVector>
+#include <limits>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    qWarning() << "FAIL:" << what;
+    ++failures;
+  }
+}
+
+static bool outside(double y, double lower, double upper) {
+  return y < lower || y > upper;
+}
+
+static void masks() {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  // Limits themselves are inside; NaN compares false and counts as inside
+  const double values[] = {-1.0, 1.0,  0.0, -1.5,  1.5,
+                           -inf, inf, nan, -0.999};
+  double y[64];
+  quint32 state = 11;
+  bool ok = true;
+  for (int round = 0; round < 200; ++round) {
+    for (int i = 0; i < 64; ++i) {
+      state = state * 1664525u + 1013904223u;
+      y[i] = values[(state >> 16) % 9];
+    }
+    for (int count = 1; count <= 64; ++count) {
+      quint64 expected = 0;
+      for (int i = 0; i < count; ++i) {
+        expected |= quint64(outside(y[i], -1.0, 1.0)) << i;
+      }
+      ok = ok &&
+           ThresholdMonitor::outsideMask(y, count, -1.0, 1.0) == expected;
+    }
+  }
+  check(ok, "outsideMask matches per-sample compares at every length");
+
+  for (int i = 0; i < 64; ++i) {
+    y[i] = 0.0;
+  }
+  y[63] = 2.0;
+  check(ThresholdMonitor::outsideMask(y, 64, -1.0, 1.0) == quint64(1) << 63,
+        "bit 63 is the last sample");
+}
+
+// Feeds 'points' in uneven calls and compares with a scalar state machine
+static bool matchesScalar(const QVector<QPointF> &points, double lower,
+                          double upper, quint32 seed) {
+  ThresholdMonitor monitor(lower, upper, QColor());
+  QVector<ThresholdCrossing> crossings;
+  quint32 state = seed;
+  for (int first = 0; first < points.size();) {
+    state = state * 1664525u + 1013904223u;
+    const int count = qMin(int((state >> 16) % 150), points.size() - first);
+    monitor.process(points.constData() + first, count, crossings);
+    first += count;
+  }
+
+  bool violating = false;
+  int next = 0;
+  int closed = 0;
+  for (int i = 0; i < points.size(); ++i) {
+    const bool now = outside(points[i].y(), lower, upper);
+    if (now == violating) {
+      continue;
+    }
+    violating = now;
+    if (next >= crossings.size()) {
+      return false;
+    }
+    const ThresholdCrossing &crossing = crossings[next++];
+    // On the limit passed, between the previous sample and this one
+    const double previousX = points[qMax(i - 1, 0)].x();
+    const double limit = now ? (points[i].y() > upper ? upper : lower)
+                             : (points[i - 1].y() > upper ? upper : lower);
+    if (crossing.violating != now || crossing.point.y() != limit ||
+        crossing.point.x() < previousX ||
+        crossing.point.x() > points[i].x()) {
+      return false;
+    }
+    closed += now ? 0 : 1;
+  }
+  const int maxRegions = ThresholdMonitor::MaxRegions;
+  return next == crossings.size() && monitor.isViolating() == violating &&
+         monitor.regions().size() == qMin(closed, maxRegions);
+}
+
+static void crossings() {
+  const double inf = std::numeric_limits<double>::infinity();
+  quint32 state = 5;
+  bool ok = true;
+  for (int trial = 0; trial < 100; ++trial) {
+    QVector<QPointF> points;
+    for (int i = 0; i < 3000; ++i) {
+      state = state * 1664525u + 1013904223u;
+      // Long quiet stretches with bursts outside the band
+      const bool burst = ((state >> 20) % 16) == 0;
+      const double y = ((state >> 8) % 500) / 100.0 - 2.5;
+      points.append(QPointF(i, burst ? y * 2.0 : y * 0.3));
+    }
+    ok = ok && matchesScalar(points, -1.0, 1.0, state);
+    ok = ok && matchesScalar(points, -inf, 0.5, state + 1);
+  }
+  check(ok, "crossings match a scalar state machine across call splits");
+}
+
+static void regions() {
+  ThresholdMonitor monitor(-1.0, 1.0, QColor());
+  QVector<ThresholdCrossing> crossings;
+  const QPointF points[] = {QPointF(0, 0), QPointF(1, 3), QPointF(2, 3),
+                            QPointF(3, 0), QPointF(4, -3)};
+  monitor.process(points, 5, crossings);
+  check(crossings.size() == 3 &&
+            crossings[0].point == QPointF(1.0 / 3, 1.0) &&
+            crossings[1].point == QPointF(3.0 - 1.0 / 3, 1.0),
+        "crossings are interpolated onto the limit");
+  check(monitor.regions().size() == 1 &&
+            monitor.regions().at(0).start == crossings[0].point.x() &&
+            monitor.regions().at(0).end == crossings[1].point.x(),
+        "leaving the band closes a region");
+  check(monitor.isViolating() && monitor.openRegion().end == 4.0,
+        "the open region runs to the last sample");
+
+  monitor.reset();
+  check(!monitor.isViolating() && monitor.regions().size() == 2,
+        "reset() closes the open region");
+  monitor.clear();
+  check(monitor.regions().isEmpty(), "clear() forgets the regions");
+}
+
+int main() {
+  masks();
+  crossings();
+  regions();
+  if (failures > 0) {
+    qWarning() << failures << "check(s) failed";
+    return 1;
+  }
+  qDebug() << "ThresholdMonitor checks passed";
+  return 0;
+}
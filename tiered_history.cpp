@@ -0,0 +1,141 @@
+#include "tiered_history.h"
+#include <limits>
+
+TieredHistory::TieredHistory()
+    : m_budget(0), m_tiers(TierCount), m_extentValid(true) {}
+
+void TieredHistory::setMemoryBudget(qint64 bytes) {
+  m_budget = qMax<qint64>(bytes, 0);
+  if (m_budget == 0) {
+    m_tiers = QVector<RingBuffer<HistoryBucket>>(TierCount);
+    m_partial = HistoryBucket();
+    m_extentValid = true;
+    m_extent = HistoryBucket();
+    return;
+  }
+
+  // Every tier gets an equal share, enough for at least two merges
+  const qint64 buckets = m_budget / qint64(sizeof(HistoryBucket)) / TierCount;
+  const int capacity = int(qBound<qint64>(2 * TierFanout, buckets,
+                                          std::numeric_limits<int>::max()));
+  for (auto &tier : m_tiers) {
+    tier.setCapacity(capacity);
+  }
+  m_extentValid = false;
+}
+
+qint64 TieredHistory::memoryBudget() const { return m_budget; }
+
+bool TieredHistory::isEnabled() const { return m_budget > 0; }
+
+qint64 TieredHistory::memoryUsage() const {
+  qint64 bytes = 0;
+  for (const auto &tier : m_tiers) {
+    bytes += qint64(tier.capacity()) * qint64(sizeof(HistoryBucket));
+  }
+  return bytes;
+}
+
+void TieredHistory::append(const QPointF &point) {
+  if (!isEnabled()) {
+    return;
+  }
+
+  HistoryBucket sample;
+  sample.xFirst = sample.xLast = point.x();
+  sample.minY = sample.maxY = sample.sumY = point.y();
+  sample.count = 1;
+  merge(m_partial, sample);
+
+  if (m_extentValid) {
+    merge(m_extent, sample);
+  }
+
+  if (m_partial.count >= BaseBucketPoints) {
+    push(0, m_partial);
+    m_partial = HistoryBucket();
+  }
+}
+
+void TieredHistory::push(int tierIndex, const HistoryBucket &bucket) {
+  RingBuffer<HistoryBucket> &tier = m_tiers[tierIndex];
+  if (tier.isFull()) {
+    if (tierIndex + 1 < m_tiers.size()) {
+      HistoryBucket merged;
+      for (int i = 0; i < TierFanout; ++i) {
+        merge(merged, tier.at(i));
+      }
+      tier.removeFirst(TierFanout);
+      push(tierIndex + 1, merged);
+    } else {
+      // Oldest data leaves the history; the extent may shrink
+      tier.removeFirst(1);
+      m_extentValid = false;
+    }
+  }
+  tier.append(bucket);
+}
+
+void TieredHistory::merge(HistoryBucket &into, const HistoryBucket &bucket) {
+  if (bucket.count == 0) {
+    return;
+  }
+  if (into.count == 0) {
+    into = bucket;
+    return;
+  }
+  into.xFirst = qMin(into.xFirst, bucket.xFirst);
+  into.xLast = qMax(into.xLast, bucket.xLast);
+  into.minY = qMin(into.minY, bucket.minY);
+  into.maxY = qMax(into.maxY, bucket.maxY);
+  into.sumY += bucket.sumY;
+  into.count += bucket.count;
+}
+
+void TieredHistory::clear() {
+  for (auto &tier : m_tiers) {
+    tier.clear();
+  }
+  m_partial = HistoryBucket();
+  m_extentValid = true;
+  m_extent = HistoryBucket();
+}
+
+bool TieredHistory::isEmpty() const {
+  if (m_partial.count > 0) {
+    return false;
+  }
+  for (const auto &tier : m_tiers) {
+    if (!tier.isEmpty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const RingBuffer<HistoryBucket> &TieredHistory::tier(int index) const {
+  return m_tiers.at(index);
+}
+
+const HistoryBucket &TieredHistory::partialBucket() const { return m_partial; }
+
+bool TieredHistory::extent(double &xMin, double &xMax, double &yMin,
+                           double &yMax) const {
+  if (!m_extentValid) {
+    m_extent = m_partial;
+    for (const auto &tier : m_tiers) {
+      for (const HistoryBucket &bucket : tier) {
+        merge(m_extent, bucket);
+      }
+    }
+    m_extentValid = true;
+  }
+  if (m_extent.count == 0) {
+    return false;
+  }
+  xMin = m_extent.xFirst;
+  xMax = m_extent.xLast;
+  yMin = m_extent.minY;
+  yMax = m_extent.maxY;
+  return true;
+}
@@ -0,0 +1,67 @@
+#ifndef TIERED_HISTORY_H
+#define TIERED_HISTORY_H
+
+#include "ring_buffer.h"
+#include <QPointF>
+#include <QtGlobal>
+
+// Samples older than a series' raw window, condensed to min/max/mean
+struct HistoryBucket {
+    double xFirst, xLast;
+    double minY, maxY;
+    double sumY;
+    qint64 count;
+
+    HistoryBucket() : xFirst(0.0), xLast(0.0), minY(0.0), maxY(0.0),
+                      sumY(0.0), count(0) {}
+    double meanY() const { return count > 0 ? sumY / count : 0.0; }
+};
+
+// Downsampled history of points evicted from a bounded series.
+//
+// Tier 0 buckets hold BaseBucketPoints samples each; whenever a tier is
+// full its TierFanout oldest buckets are merged into one bucket of the
+// next, coarser tier, and the last tier drops its oldest bucket. Each
+// tier is a fixed ring, so memory stays within the budget while the time
+// span covered grows by TierFanout per tier: with the defaults a 1 MB
+// budget keeps roughly 300 million samples' worth of min/max/mean.
+class TieredHistory {
+public:
+    static const int BaseBucketPoints = 16;
+    static const int TierFanout = 8;
+    static const int TierCount = 5;
+
+    TieredHistory();
+
+    // 0 disables the history and frees it
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    bool isEnabled() const;
+    qint64 memoryUsage() const;
+
+    void append(const QPointF &point);
+    void clear();
+    bool isEmpty() const;
+
+    // Tier 0 is the finest; within a tier buckets are oldest first. The
+    // partial bucket still filling from evictions is newer than all tiers.
+    const RingBuffer<HistoryBucket> &tier(int index) const;
+    const HistoryBucket &partialBucket() const;
+
+    // Extent of everything in the history; false if it is empty
+    bool extent(double &xMin, double &xMax, double &yMin, double &yMax) const;
+
+private:
+    void push(int tierIndex, const HistoryBucket &bucket);
+    static void merge(HistoryBucket &into, const HistoryBucket &bucket);
+
+    qint64 m_budget;
+    QVector<RingBuffer<HistoryBucket>> m_tiers;
+    HistoryBucket m_partial;
+
+    // Grows with appends; rescanned only after the last tier drops data
+    mutable bool m_extentValid;
+    mutable HistoryBucket m_extent;
+};
+
+#endif // TIERED_HISTORY_H
@@ -0,0 +1,257 @@
+#include "trigger_engine.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtAlgorithms>
+#include <QVector>
+#include <QWaitCondition>
+#include <limits>
+
+// First index in [first, last) whose x is >= value
+static int lowerBound(const double *x, int first, int last, double value) {
+  int count = last - first;
+  while (count > 0) {
+    const int half = count / 2;
+    if (x[first + half] < value) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return first;
+}
+
+// Owns the scan state; the GUI thread only appends to m_pending
+class TriggerScanThread : public QThread {
+public:
+  explicit TriggerScanThread(TriggerEngine *engine)
+      : m_engine(engine), m_generation(0), m_restart(true), m_stop(false) {}
+
+  void configure(const TriggerSettings &settings, int generation) {
+    QMutexLocker locker(&m_mutex);
+    m_settings = settings;
+    m_generation = generation;
+    m_pending.resize(0);
+    m_restart = true;
+  }
+
+  void feed(const QPointF *points, int count) {
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.size() + count > TriggerEngine::MaxPendingPoints) {
+      // Falling behind: drop the backlog and start searching afresh
+      m_pending.resize(0);
+      m_restart = true;
+      const int kept = qMin(count, int(TriggerEngine::MaxPendingPoints));
+      points += count - kept;
+      count = kept;
+    }
+    for (int i = 0; i < count; ++i) {
+      m_pending.append(points[i]);
+    }
+    m_wake.wakeOne();
+  }
+
+  void stop() {
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_wake.wakeOne();
+  }
+
+protected:
+  void run() override {
+    QVector<QPointF> batch;
+    TriggerSettings settings;
+    int generation = 0;
+    for (;;) {
+      {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stop && m_pending.isEmpty()) {
+          m_wake.wait(&m_mutex);
+        }
+        if (m_stop) {
+          return;
+        }
+        batch.swap(m_pending);
+        m_pending.resize(0);
+        if (m_restart) {
+          m_restart = false;
+          m_armed = false;
+          m_waiting = false;
+          m_hasPrevious = false;
+          m_nextAllowed = -std::numeric_limits<double>::infinity();
+        }
+        settings = m_settings;
+        generation = m_generation;
+      }
+      scan(batch, settings, generation);
+    }
+  }
+
+private:
+  void scan(const QVector<QPointF> &batch, const TriggerSettings &settings,
+            int generation) {
+    // Split into contiguous x and y so the edge kernel reads plain doubles
+    const int n = batch.size();
+    m_x.resize(n);
+    m_y.resize(n);
+    for (int i = 0; i < n; ++i) {
+      m_x[i] = batch.at(i).x();
+      m_y[i] = batch.at(i).y();
+    }
+    const double *x = m_x.constData();
+    const double *y = m_y.constData();
+
+    const double armLevel = settings.edge == RisingEdge
+                                ? settings.level - settings.hysteresis
+                                : settings.level + settings.hysteresis;
+    const double postTrigger =
+        settings.window * (1.0 - qBound(0.0, settings.preTrigger, 1.0));
+
+    int i = 0;
+    while (i < n) {
+      if (m_waiting) {
+        const int complete = lowerBound(x, i, n, m_triggerX + postTrigger);
+        if (complete >= n) {
+          break;
+        }
+        TriggerEngine *engine = m_engine;
+        const double triggerX = m_triggerX;
+        QMetaObject::invokeMethod(
+            engine,
+            [engine, triggerX, generation]() {
+              engine->deliver(triggerX, generation);
+            },
+            Qt::QueuedConnection);
+        m_waiting = false;
+        m_armed = false;
+        m_nextAllowed = m_triggerX + qMax(postTrigger, settings.holdoff);
+        i = complete;
+      }
+      if (x[i] < m_nextAllowed) {
+        i = lowerBound(x, i, n, m_nextAllowed);
+        continue;
+      }
+
+      const int found = TriggerEngine::findEdge(y + i, n - i, settings.level,
+                                                armLevel, settings.edge,
+                                                m_armed);
+      if (found < 0) {
+        break;
+      }
+
+      // Interpolate where the signal crossed the level
+      const int t = i + found;
+      const QPointF previous =
+          t > 0 ? batch.at(t - 1) : (m_hasPrevious ? m_previous : batch.at(t));
+      const double dy = y[t] - previous.y();
+      m_triggerX = x[t];
+      if (dy != 0.0) {
+        m_triggerX = previous.x() +
+                     (x[t] - previous.x()) * (settings.level - previous.y()) / dy;
+      }
+      m_waiting = true;
+      i = t + 1;
+    }
+
+    if (n > 0) {
+      m_previous = batch.last();
+      m_hasPrevious = true;
+    }
+  }
+
+  TriggerEngine *m_engine;
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  QVector<QPointF> m_pending;
+  TriggerSettings m_settings;
+  int m_generation;
+  bool m_restart;
+  bool m_stop;
+
+  // Scan state, touched only by the worker
+  bool m_armed;
+  bool m_waiting;
+  double m_triggerX;
+  double m_nextAllowed;
+  bool m_hasPrevious;
+  QPointF m_previous;
+  QVector<double> m_x;
+  QVector<double> m_y;
+};
+
+TriggerEngine::TriggerEngine(QObject *parent)
+    : QObject(parent), m_thread(new TriggerScanThread(this)),
+      m_generation(0) {
+  m_thread->configure(m_settings, m_generation);
+  m_thread->start();
+}
+
+TriggerEngine::~TriggerEngine() {
+  m_thread->stop();
+  m_thread->wait();
+  delete m_thread;
+}
+
+void TriggerEngine::setSettings(const TriggerSettings &settings) {
+  m_settings = settings;
+  m_thread->configure(m_settings, ++m_generation);
+}
+
+TriggerSettings TriggerEngine::settings() const { return m_settings; }
+
+void TriggerEngine::feed(const QPointF *points, int count) {
+  if (count > 0) {
+    m_thread->feed(points, count);
+  }
+}
+
+void TriggerEngine::reset() { m_thread->configure(m_settings, ++m_generation); }
+
+void TriggerEngine::deliver(double x, int generation) {
+  // Edges found under previous settings are stale
+  if (generation == m_generation) {
+    emit triggered(x);
+  }
+}
+
+int TriggerEngine::findEdge(const double *y, int count, double level,
+                            double armLevel, TriggerEdge edge, bool &armed) {
+  // 64 samples at a time: branch-free compares into bit masks, which the
+  // compiler turns into vector compares, then the state machine resolved
+  // with bit scans instead of a branch per sample
+  const bool rising = edge == RisingEdge;
+  for (int base = 0; base < count; base += 64) {
+    const int n = qMin(64, count - base);
+    const double *block = y + base;
+    quint64 past = 0;
+    quint64 arm = 0;
+    if (rising) {
+      for (int i = 0; i < n; ++i) {
+        past |= quint64(block[i] >= level) << i;
+        arm |= quint64(block[i] < armLevel) << i;
+      }
+    } else {
+      for (int i = 0; i < n; ++i) {
+        past |= quint64(block[i] <= level) << i;
+        arm |= quint64(block[i] > armLevel) << i;
+      }
+    }
+
+    quint64 candidates = past;
+    if (!armed) {
+      if (arm == 0) {
+        continue;
+      }
+      // Only edges after the first arming sample count
+      candidates &= ~quint64(0) << qCountTrailingZeroBits(arm);
+      armed = true;
+    }
+    if (candidates != 0) {
+      armed = false;
+      return base + int(qCountTrailingZeroBits(candidates));
+    }
+  }
+  return -1;
+}
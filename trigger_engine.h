@@ -0,0 +1,74 @@
+#ifndef TRIGGER_ENGINE_H
+#define TRIGGER_ENGINE_H
+
+#include <QObject>
+#include <QPointF>
+#include <QtGlobal>
+
+class TriggerScanThread;
+
+enum TriggerEdge {
+    RisingEdge,
+    FallingEdge
+};
+
+struct TriggerSettings {
+    TriggerEdge edge;
+    double level;
+    // The signal must first be this far on the other side of the level
+    // before an edge counts, so noise around the level does not retrigger
+    double hysteresis;
+    // Edges within this x distance after a trigger are ignored
+    double holdoff;
+    // Displayed x span and the fraction of it before the trigger point
+    double window;
+    double preTrigger;
+
+    TriggerSettings() : edge(RisingEdge), level(0.0), hysteresis(0.0),
+                        holdoff(0.0), window(1.0), preTrigger(0.5) {}
+};
+
+// Edge trigger for streamed samples. feed() only queues the samples; a
+// worker thread scans them and reports an edge through triggered() once
+// the post-trigger part of its window has arrived, after which the next
+// edge is searched past the window and the holdoff.
+class TriggerEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Samples queued beyond this are dropped oldest first
+    static const int MaxPendingPoints = 4 * 1024 * 1024;
+
+    explicit TriggerEngine(QObject *parent = nullptr);
+    ~TriggerEngine();
+
+    // Also restarts the search
+    void setSettings(const TriggerSettings &settings);
+    TriggerSettings settings() const;
+
+    // Queues samples in ascending x; cheap enough for the GUI thread
+    void feed(const QPointF *points, int count);
+    void reset();
+
+    // Scans y for the first edge crossing 'level' after the signal has
+    // been beyond 'armLevel' (below it for rising edges, above for
+    // falling). 'armed' carries that state across calls. Returns the
+    // index of the first sample past the level, or -1.
+    static int findEdge(const double *y, int count, double level,
+                        double armLevel, TriggerEdge edge, bool &armed);
+
+signals:
+    // x of the edge, interpolated between the samples around the level
+    void triggered(double x);
+
+private:
+    friend class TriggerScanThread;
+    void deliver(double x, int generation);
+
+    TriggerScanThread *m_thread;
+    TriggerSettings m_settings;
+    int m_generation;
+};
+
+#endif // TRIGGER_ENGINE_H
@@ -1,24 +1,138 @@
 #include "xy_chart_widget.h"
+#include "chart_update_scheduler.h"
+#include <QCoreApplication>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFontMetrics>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QPainterPath>
+#include <QPair>
+#include <QPointer>
+#include <QPolygonF>
+#include <QSet>
+#include <QTimer>
+#include <QWheelEvent>
 #include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <utility>
+
+// Every live chart, for the process-wide memory budget
+static QList<XYChartWidget *> &chartRegistry() {
+  static QList<XYChartWidget *> charts;
+  return charts;
+}
+
+static qint64 s_globalMemoryBudget = 0;
+
+// A series trimmed by a memory budget keeps at least this many raw points
+static const int MinTrimmedPoints = 1024;
+
+// Points copied out of a series for processing go in chunks this large
+static const int ReadChunkPoints = 4096;
+
+// Appended data is checked against the memory budgets this often
+static const int BudgetCheckMs = 100;
+
+// Zoom/pan previews last until the view has been still this long
+static const int PreviewSettleMs = 150;
+
+// Full render quality returns after this long without new data or moves
+static const int QualityIdleMs = 300;
+
+// Annotation labels beyond this many rows under the plot top are hidden
+static const int AnnotationLabelRows = 3;
+
+// Where an axis value is laid out: itself, or its log10 on a log axis.
+// Drawing works in this linear space; values <= 0 map to -inf/NaN there.
+static double layoutValue(double value, bool logScale) {
+  return logScale ? std::log10(value) : value;
+}
+
+static double axisValue(double layout, bool logScale) {
+  return logScale ? std::pow(10.0, layout) : layout;
+}
+
+// Value at tick i of 10 across an axis. Ticks are evenly spaced on
+// screen, so on a log axis they step by equal factors and are labelled
+// with significant digits rather than one decimal.
+static QString tickLabel(double min, double max, int i, bool logScale) {
+  if (!logScale) {
+    return QString::number(min + (max - min) * i / 10, 'f', 1);
+  }
+  const double logMin = std::log10(min);
+  const double logMax = std::log10(max);
+  return QString::number(std::pow(10.0, logMin + (logMax - logMin) * i / 10),
+                         'g', 3);
+}
+
+static bool isFinitePoint(const QPointF &point) {
+  return std::isfinite(point.x()) && std::isfinite(point.y());
+}
 
 XYChartWidget::XYChartWidget(QWidget *parent)
     : QWidget(parent), m_showGrid(true), m_showAxisLabels(true),
+      m_legendStatisticsVisible(false),
       m_autoScale(true), m_xMin(0.0), m_xMax(10.0), m_yMin(0.0), m_yMax(10.0),
-      m_maxPointsPerSeries(-1), m_leftMargin(10), m_rightMargin(10),
-      m_topMargin(40), m_bottomMargin(50), m_colorIndex(0),
-      m_crosshairVisible(true), m_crosshairPos(-1, -1), m_nextAxisId(1),
-      m_multiAxisEnabled(false), m_autoGroupSeries(false), m_maxYAxes(4),
-      m_groupingThreshold(0.3), m_axisSpacing(40), m_darkModeEnabled(false) {
+      m_xLogScale(false),
+      m_maxPointsPerSeries(-1), m_markerBudget(1000000), m_historyBudget(0),
+      m_memoryBudget(0),
+      m_budgetTimer(new QTimer(this)), m_persistenceTimer(new QTimer(this)),
+      m_sharedRingTimer(new QTimer(this)), m_leftMargin(10),
+      m_rightMargin(10), m_topMargin(40), m_bottomMargin(50), m_colorIndex(0),
+      m_nextAxisId(1), m_multiAxisEnabled(false), m_autoGroupSeries(false),
+      m_maxYAxes(4), m_groupingThreshold(0.3), m_axisSpacing(40),
+      m_crosshairVisible(true), m_crosshairPos(-1, -1),
+      m_measurementCursorsVisible(false), m_draggedCursor(-1),
+      m_trigger(nullptr), m_triggerFed(0), m_triggerLastX(0.0),
+      m_triggerLocked(false), m_triggerX(0.0),
+      m_annotationRevision(std::numeric_limits<quint64>::max()),
+      m_annotationXMin(0.0), m_annotationXMax(0.0), m_annotationLeft(0),
+      m_annotationRight(0), m_annotationXLog(false), m_zoomPanEnabled(true),
+      m_previewing(false), m_settleTimer(new QTimer(this)), m_frameXMin(0.0),
+      m_frameXMax(0.0), m_frameYMin(0.0), m_frameYMax(0.0), m_frameDirty(true),
+      m_dragButton(Qt::NoButton), m_qualityTimer(new QTimer(this)),
+      m_busy(false), m_darkModeEnabled(false) {
   setMinimumSize(400, 300);
   setBackgroundRole(QPalette::Base);
   setAutoFillBackground(true);
   setMouseTracking(true);
 
+  m_budgetTimer->setSingleShot(true);
+  m_budgetTimer->setInterval(BudgetCheckMs);
+  connect(m_budgetTimer, &QTimer::timeout, this, [this]() {
+    enforceMemoryBudget(QList<XYChartWidget *>() << this, m_memoryBudget);
+  });
+
+  m_persistenceTimer->setSingleShot(true);
+  m_persistenceTimer->setInterval(33);
+  connect(m_persistenceTimer, &QTimer::timeout, this,
+          [this]() { updateSeriesLayer(); });
+
+  connect(m_sharedRingTimer, &QTimer::timeout, this,
+          [this]() { pollSharedRings(); });
+
+  m_settleTimer->setSingleShot(true);
+  m_settleTimer->setInterval(PreviewSettleMs);
+  connect(m_settleTimer, &QTimer::timeout, this, [this]() {
+    m_previewing = false;
+    update();
+  });
+
+  m_quality.setBudget(16 * 1000000);
+  m_qualityTimer->setSingleShot(true);
+  m_qualityTimer->setInterval(QualityIdleMs);
+  connect(m_qualityTimer, &QTimer::timeout, this, [this]() {
+    m_busy = false;
+    if (m_quality.quality() != FullQuality) {
+      m_quality.idle();
+      updateSeriesLayer();
+    }
+  });
+
   // Create default axis 0
   YAxisInfo defaultAxis;
   defaultAxis.axisId = 0;
@@ -28,9 +142,17 @@ XYChartWidget::XYChartWidget(QWidget *parent)
   defaultAxis.side = Qt::AlignLeft;
   defaultAxis.autoScale = true;
   m_yAxes[0] = defaultAxis;
+
+  // Placed inside the visible range when first shown
+  m_cursorX[0] = m_cursorX[1] = std::numeric_limits<double>::quiet_NaN();
+
+  chartRegistry().append(this);
 }
 
-XYChartWidget::~XYChartWidget() {}
+XYChartWidget::~XYChartWidget() {
+  chartRegistry().removeAll(this);
+  ChartUpdateScheduler::instance()->remove(this);
+}
 
 void XYChartWidget::addSeries(const QString &seriesName, const QColor &color) {
   if (m_series.contains(seriesName)) {
@@ -44,225 +166,1662 @@ void XYChartWidget::addSeries(const QString &seriesName, const QColor &color) {
   series.color = color.isValid() ? color : getNextColor();
   series.pen.setColor(series.color);
   series.pen.setWidth(2);
+  series.points.setCapacity(qMax(m_maxPointsPerSeries, 0));
+  series.history.setMemoryBudget(m_historyBudget);
 
   m_series[seriesName] = series;
 
-  // Add to default axis
-  if (m_yAxes.contains(0)) {
-    if (!m_yAxes[0].seriesNames.contains(seriesName)) {
-      m_yAxes[0].seriesNames.append(seriesName);
+  // Add to default axis
+  if (m_yAxes.contains(0)) {
+    if (!m_yAxes[0].seriesNames.contains(seriesName)) {
+      m_yAxes[0].seriesNames.append(seriesName);
+    }
+  }
+
+  updateSeriesLayer();
+}
+
+void XYChartWidget::addPoint(const QString &seriesName, double x, double y) {
+  addPoint(seriesName, QPointF(x, y));
+}
+
+void XYChartWidget::addPoint(const QString &seriesName, const QPointF &point) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+  if (appendCompressed(seriesName, &point, 1)) {
+    return;
+  }
+  if (!m_series[seriesName].source.isNull()) {
+    qWarning() << "Series" << seriesName << "is backed by a data source";
+    return;
+  }
+
+  // A bounded series overwrites its oldest point
+  appendToSeries(m_series[seriesName], &point, 1);
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::addPoints(const QString &seriesName,
+                              const QVector<QPointF> &points) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+  if (appendCompressed(seriesName, points.constData(), points.size())) {
+    return;
+  }
+  if (!m_series[seriesName].source.isNull()) {
+    qWarning() << "Series" << seriesName << "is backed by a data source";
+    return;
+  }
+
+  // Sharing is only possible while nothing has to go to the history, and
+  // storage reserved with reserveSeries() is filled rather than dropped
+  DataSeries &series = m_series[seriesName];
+  if (series.points.isEmpty() && !series.points.isAllocated() &&
+      !series.history.isEnabled()) {
+    series.points.assign(points);
+    series.extent = SeriesExtent();
+    series.legendStatistics.invalidate();
+    series.samplesAppended += points.size();
+  } else {
+    appendToSeries(series, points.constData(), points.size());
+  }
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::addPoints(const QString &seriesName,
+                              QVector<QPointF> &&points) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+  if (appendCompressed(seriesName, points.constData(), points.size())) {
+    return;
+  }
+  if (!m_series[seriesName].source.isNull()) {
+    qWarning() << "Series" << seriesName << "is backed by a data source";
+    return;
+  }
+
+  // An empty series adopts the caller's buffer instead of copying it,
+  // unless reserveSeries() already sized its storage
+  DataSeries &series = m_series[seriesName];
+  if (series.points.isEmpty() && !series.points.isAllocated() &&
+      !series.history.isEnabled()) {
+    series.samplesAppended += points.size();
+    series.points.assign(std::move(points));
+    series.extent = SeriesExtent();
+    series.legendStatistics.invalidate();
+  } else {
+    appendToSeries(series, points.constData(), points.size());
+  }
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::setSeriesData(const QString &seriesName,
+                                  const QVector<QPointF> &points) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+
+  if (!m_series[seriesName].compressed.isNull()) {
+    m_series[seriesName].compressed->clear();
+    m_series[seriesName].legendStatistics.invalidate();
+    appendCompressed(seriesName, points.constData(), points.size());
+    return;
+  }
+
+  m_series[seriesName].source.clear();
+  m_series[seriesName].samples.clear();
+  m_series[seriesName].sharedRing.clear();
+
+  // Shared with the caller while unbounded; a bounded series copies only
+  // the points that fit into its window
+  m_series[seriesName].points.assign(points);
+  m_series[seriesName].extent = SeriesExtent();
+  m_series[seriesName].history.clear();
+  m_series[seriesName].legendStatistics.invalidate();
+  m_series[seriesName].samplesAppended += points.size();
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::setSeriesData(const QString &seriesName,
+                                  QVector<QPointF> &&points) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+
+  if (!m_series[seriesName].compressed.isNull()) {
+    m_series[seriesName].compressed->clear();
+    m_series[seriesName].legendStatistics.invalidate();
+    appendCompressed(seriesName, points.constData(), points.size());
+    return;
+  }
+
+  m_series[seriesName].source.clear();
+  m_series[seriesName].samples.clear();
+  m_series[seriesName].sharedRing.clear();
+  m_series[seriesName].samplesAppended += points.size();
+  m_series[seriesName].points.assign(std::move(points));
+  m_series[seriesName].extent = SeriesExtent();
+  m_series[seriesName].history.clear();
+  m_series[seriesName].legendStatistics.invalidate();
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::setSeriesData(const QString &seriesName,
+                                  const QPointF *points, qint64 count,
+                                  const std::function<void()> &release) {
+  setSeriesSource(seriesName, QSharedPointer<SeriesDataSource>(
+                                  new BufferDataSource(points, count, release)));
+}
+
+void XYChartWidget::setSeriesData(const QString &seriesName, const double *y,
+                                  qint64 count, double x0, double dx,
+                                  const std::function<void()> &release) {
+  setSeriesSource(seriesName,
+                  QSharedPointer<SeriesDataSource>(
+                      new BufferDataSource(y, count, x0, dx, release)));
+}
+
+void XYChartWidget::reserveSeries(const QString &seriesName, int capacity) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+
+  if (m_maxPointsPerSeries > 0) {
+    capacity = qMin(capacity, m_maxPointsPerSeries);
+  }
+  m_series[seriesName].points.reserve(capacity);
+}
+
+void XYChartWidget::setSeriesSource(
+    const QString &seriesName,
+    const QSharedPointer<SeriesDataSource> &source) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+
+  m_series[seriesName].points.clear();
+  m_series[seriesName].source = source;
+  m_series[seriesName].compressed.clear();
+  m_series[seriesName].samples.clear();
+  m_series[seriesName].sharedRing.clear();
+  m_series[seriesName].extent = SeriesExtent();
+  m_series[seriesName].statistics.clear();
+  m_series[seriesName].legendStatistics.invalidate();
+
+  seriesDataChanged(seriesName);
+}
+
+bool XYChartWidget::attachSharedRing(const QString &seriesName,
+                                     const QString &key, int pollMs) {
+  QSharedPointer<SharedRingSource> ring(new SharedRingSource());
+  if (!ring->attach(key)) {
+    return false;
+  }
+
+  setSeriesSource(seriesName, ring);
+  DataSeries &series = m_series[seriesName];
+  series.sharedRing = ring;
+  // What the ring already holds counts as added once attached
+  series.samplesAppended += ring->count();
+  seriesDataChanged(seriesName);
+
+  m_sharedRingTimer->start(qMax(pollMs, 1));
+  return true;
+}
+
+void XYChartWidget::pollSharedRings() {
+  QStringList changed;
+  QVector<QPointF> evicted;
+  for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+    if (it->sharedRing.isNull()) {
+      continue;
+    }
+    SeriesStatistics &statistics = it->legendStatistics;
+    evicted.resize(0);
+    const qint64 added =
+        it->sharedRing->poll(statistics.isValid() ? &evicted : nullptr);
+    if (added <= 0) {
+      continue;
+    }
+    it->samplesAppended += added;
+    it->extent = SeriesExtent();
+    changed.append(it.key());
+
+    if (!statistics.isValid()) {
+      continue;
+    }
+    // Samples the producer overwrote first cannot be taken back out
+    bool lost = false;
+    for (const QPointF &point : evicted) {
+      lost = lost || std::isnan(point.x());
+    }
+    if (lost) {
+      statistics.invalidate();
+      continue;
+    }
+    for (const QPointF &point : evicted) {
+      statistics.removeFirst(point.y());
+    }
+    const qint64 count = it->sharedRing->count();
+    QVector<QPointF> chunk(ReadChunkPoints);
+    for (qint64 index = count - qMin(added, count); index < count;
+         index += chunk.size()) {
+      const int n = int(
+          it->sharedRing->readPoints(index, chunk.size(), chunk.data()));
+      statistics.append(chunk.constData(), n);
+    }
+  }
+  if (changed.isEmpty()) {
+    bool attached = false;
+    for (const auto &series : m_series) {
+      attached = attached || !series.sharedRing.isNull();
+    }
+    if (!attached) {
+      m_sharedRingTimer->stop();
+    }
+    return;
+  }
+
+  for (const QString &name : changed) {
+    seriesDataChanged(name);
+  }
+}
+
+void XYChartWidget::setSeriesCompressed(const QString &seriesName,
+                                        bool enabled) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+  DataSeries &series = m_series[seriesName];
+  if (enabled == !series.compressed.isNull()) {
+    return;
+  }
+
+  if (enabled) {
+    if (!series.source.isNull()) {
+      qWarning() << "Series" << seriesName << "is backed by a data source";
+      return;
+    }
+    QSharedPointer<CompressedSeries> compressed(new CompressedSeries());
+    for (int run = 0; run < 2; ++run) {
+      int length = 0;
+      const QPointF *points = series.points.run(run, length);
+      compressed->append(points, length);
+    }
+    series.points.clear();
+    series.source = compressed;
+    series.compressed = compressed;
+  } else {
+    // Decode back into the (possibly bounded) point window
+    QVector<QPointF> points(int(series.compressed->count()));
+    series.compressed->readPoints(0, points.size(), points.data());
+    series.source.clear();
+    series.compressed.clear();
+    series.points.assign(std::move(points));
+  }
+  series.extent = SeriesExtent();
+  series.legendStatistics.invalidate();
+
+  seriesDataChanged(seriesName);
+}
+
+bool XYChartWidget::appendCompressed(const QString &seriesName,
+                                     const QPointF *points, int count) {
+  DataSeries &series = m_series[seriesName];
+  if (series.compressed.isNull()) {
+    return false;
+  }
+  series.compressed->append(points, count);
+  if (series.legendStatistics.isValid()) {
+    series.legendStatistics.append(points, count);
+  }
+  series.samplesAppended += count;
+  seriesDataChanged(seriesName);
+  return true;
+}
+
+void XYChartWidget::setSeriesSampleFormat(const QString &seriesName,
+                                          SampleFormat format, double x0,
+                                          double dx) {
+  if (!m_series.contains(seriesName)) {
+    addSeries(seriesName);
+  }
+
+  QSharedPointer<SampleSource> samples;
+  switch (format) {
+  case Int16Samples:
+    samples.reset(new SampleSeries<qint16>(x0, dx));
+    break;
+  case Int32Samples:
+    samples.reset(new SampleSeries<qint32>(x0, dx));
+    break;
+  case FloatSamples:
+    samples.reset(new SampleSeries<float>(x0, dx));
+    break;
+  }
+  samples->setCapacity(qMax(m_maxPointsPerSeries, 0));
+
+  DataSeries &series = m_series[seriesName];
+  series.points.clear();
+  series.compressed.clear();
+  series.sharedRing.clear();
+  series.source = samples;
+  series.samples = samples;
+  series.extent = SeriesExtent();
+  series.history.clear();
+  series.statistics.clear();
+  series.legendStatistics.invalidate();
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::setSeriesScale(const QString &seriesName, double gain,
+                                   double offset) {
+  if (!m_series.contains(seriesName) || m_series[seriesName].samples.isNull()) {
+    qWarning() << "Series" << seriesName << "does not hold raw samples";
+    return;
+  }
+  m_series[seriesName].samples->setScale(gain, offset);
+  m_series[seriesName].extent = SeriesExtent();
+  m_series[seriesName].statistics.clear();
+  m_series[seriesName].legendStatistics.invalidate();
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::addSamples(const QString &seriesName,
+                               const qint16 *samples, int count) {
+  appendSamples(seriesName, samples, count);
+}
+
+void XYChartWidget::addSamples(const QString &seriesName,
+                               const qint32 *samples, int count) {
+  appendSamples(seriesName, samples, count);
+}
+
+void XYChartWidget::addSamples(const QString &seriesName, const float *samples,
+                               int count) {
+  appendSamples(seriesName, samples, count);
+}
+
+template <typename T>
+void XYChartWidget::appendSamples(const QString &seriesName, const T *samples,
+                                  int count) {
+  if (!m_series.contains(seriesName)) {
+    setSeriesSampleFormat(seriesName, SampleFormatOf<T>::value);
+  }
+  DataSeries &series = m_series[seriesName];
+  if (series.samples.isNull() ||
+      series.samples->format() != SampleFormatOf<T>::value) {
+    qWarning() << "Series" << seriesName
+               << "does not hold raw samples of this type";
+    return;
+  }
+  if (count <= 0) {
+    return;
+  }
+
+  // Blocks dropped by a bounded window go to the history
+  SeriesStatistics &statistics = series.legendStatistics;
+  QVector<QPointF> evicted;
+  static_cast<SampleSeries<T> *>(series.samples.data())
+      ->append(samples, count,
+               series.history.isEnabled() || statistics.isValid() ? &evicted
+                                                                  : nullptr);
+  if (statistics.isValid()) {
+    const double gain = series.samples->gain();
+    const double offset = series.samples->offset();
+    for (int i = 0; i < count; ++i) {
+      statistics.append(double(samples[i]) * gain + offset);
+    }
+    for (const QPointF &point : evicted) {
+      statistics.removeFirst(point.y());
+    }
+  }
+  if (series.history.isEnabled()) {
+    for (const QPointF &point : evicted) {
+      series.history.append(point);
+    }
+  }
+  series.samplesAppended += count;
+
+  seriesDataChanged(seriesName);
+}
+
+void XYChartWidget::addDerivedSeries(const QString &seriesName,
+                                     const QString &sourceName,
+                                     DerivedOperation operation, int length,
+                                     const QColor &color) {
+  if (m_series.contains(seriesName)) {
+    qWarning() << "Series" << seriesName << "already exists!";
+    return;
+  }
+  // Requiring an existing source also rules out derivation cycles
+  if (!m_series.contains(sourceName)) {
+    qWarning() << "Source series" << sourceName << "does not exist";
+    return;
+  }
+
+  addSeries(seriesName, color.isValid() ? color : getNextColor());
+  DataSeries &series = m_series[seriesName];
+  series.derivation = QSharedPointer<DerivedSeries>(
+      new DerivedSeries(sourceName, operation, length));
+  if (operation == Spectrum) {
+    connect(series.derivation.data(), &DerivedSeries::spectrumReady, this,
+            [this, seriesName]() {
+              if (m_series.contains(seriesName) &&
+                  !m_series[seriesName].derivation.isNull()) {
+                setSeriesData(seriesName,
+                              m_series[seriesName].derivation->takeSpectrum());
+              }
+            });
+  }
+
+  // Start from what the source already holds
+  seriesDataChanged(sourceName);
+}
+
+void XYChartWidget::feedDerivedSeries(const QString &sourceName) {
+  DataSeries &source = m_series[sourceName];
+  const qint64 count = seriesCount(source);
+  QStringList updated;
+  QVector<QPointF> chunk;
+  QVector<QPointF> output;
+
+  for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+    DataSeries &series = it.value();
+    if (series.derivation.isNull() ||
+        series.derivation->sourceName() != sourceName) {
+      continue;
+    }
+
+    // Only samples appended since the last update, as far as the source
+    // still holds them
+    DerivedSeries &derivation = *series.derivation;
+    bool gap = false;
+    const qint64 added = unreadSamples(source, derivation.fedSamples(), gap);
+    derivation.setFedSamples(source.samplesAppended);
+    if (gap) {
+      derivation.reset();
+    }
+    if (added <= 0) {
+      continue;
+    }
+
+    chunk.resize(ReadChunkPoints);
+    output.resize(0);
+    for (qint64 index = count - added; index < count;) {
+      const int n = int(qMin<qint64>(chunk.size(), count - index));
+      readSeriesPoints(source, index, n, chunk.data());
+      derivation.process(chunk.constData(), n, output);
+      index += n;
+    }
+    if (output.isEmpty()) {
+      continue;
+    }
+
+    if (!series.compressed.isNull()) {
+      series.compressed->append(output.constData(), output.size());
+      if (series.legendStatistics.isValid()) {
+        series.legendStatistics.append(output.constData(), output.size());
+      }
+      series.samplesAppended += output.size();
+    } else if (series.source.isNull()) {
+      appendToSeries(series, output.constData(), output.size());
+    } else {
+      continue;
+    }
+    if (m_trigger != nullptr && it.key() == m_triggerSeries) {
+      feedTrigger(series);
+    }
+    if (!series.threshold.isNull()) {
+      feedThreshold(series, true);
+    }
+    if (m_multiAxisEnabled) {
+      calculateAutoScaleForAxis(series.yAxisId);
+    }
+    updated.append(it.key());
+  }
+
+  // Series derived from the ones just updated
+  for (const QString &name : updated) {
+    feedDerivedSeries(name);
+  }
+}
+
+void XYChartWidget::setSeriesThreshold(const QString &seriesName,
+                                       double lower, double upper,
+                                       const QColor &color) {
+  if (!m_series.contains(seriesName)) {
+    qWarning() << "Series" << seriesName << "does not exist";
+    return;
+  }
+
+  DataSeries &series = m_series[seriesName];
+  series.threshold = QSharedPointer<ThresholdMonitor>(new ThresholdMonitor(
+      lower, upper, color.isValid() ? color : series.color));
+  // What the series holds is checked for shading only
+  series.threshold->setFedSamples(series.samplesAppended -
+                                  seriesCount(series));
+  feedThreshold(series, false);
+  updateSeriesLayer();
+}
+
+void XYChartWidget::clearSeriesThreshold(const QString &seriesName) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].threshold.clear();
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::feedThreshold(DataSeries &series, bool notify) {
+  ThresholdMonitor &monitor = *series.threshold;
+  const qint64 count = seriesCount(series);
+  bool gap = false;
+  const qint64 added = unreadSamples(series, monitor.fedSamples(), gap);
+  monitor.setFedSamples(series.samplesAppended);
+  if (gap) {
+    // Samples evicted unchecked: what is left does not follow on
+    monitor.reset();
+  }
+  if (added <= 0) {
+    return;
+  }
+
+  QVector<QPointF> chunk(int(qMin<qint64>(added, ReadChunkPoints)));
+  QVector<ThresholdCrossing> crossings;
+  for (qint64 index = count - added; index < count;) {
+    const int n = int(qMin<qint64>(chunk.size(), count - index));
+    readSeriesPoints(series, index, n, chunk.data());
+    monitor.process(chunk.constData(), n, crossings);
+    index += n;
+  }
+
+  if (notify) {
+    for (const ThresholdCrossing &crossing : crossings) {
+      emit thresholdCrossed(series.name, crossing.point, crossing.violating);
+    }
+  }
+}
+
+void XYChartWidget::seriesDataChanged(const QString &seriesName) {
+  // Measuring walks every series, so budgets are checked once per
+  // BudgetCheckMs rather than on every append
+  if (m_memoryBudget > 0 && !m_budgetTimer->isActive()) {
+    m_budgetTimer->start();
+  }
+  if (s_globalMemoryBudget > 0) {
+    scheduleGlobalBudgetCheck();
+  }
+
+  if (m_trigger != nullptr && seriesName == m_triggerSeries) {
+    feedTrigger(m_series[seriesName]);
+  }
+  if (!m_series[seriesName].threshold.isNull()) {
+    feedThreshold(m_series[seriesName], true);
+  }
+  feedDerivedSeries(seriesName);
+  // New samples of a series on a log axis get their log10 once, here
+  syncLogColumns(m_series[seriesName]);
+
+  // Regroup only once a series' magnitude has drifted far enough
+  if (m_multiAxisEnabled && m_autoGroupSeries &&
+      needsRegroup(m_series[seriesName])) {
+    autoGroupSeriesToAxes();
+  }
+
+  // Auto-scale: Update both global and axis-specific scales
+  if (m_autoScale) {
+    calculateAutoScale();
+  }
+
+  // Also update axis-specific auto-scale if in multi-axis mode
+  if (m_multiAxisEnabled) {
+    int axisId = m_series[seriesName].yAxisId;
+    calculateAutoScaleForAxis(axisId);
+  }
+
+  // Repainted with the next shared frame rather than once per append
+  markBusy();
+  m_frameDirty = true;
+  ChartUpdateScheduler::instance()->requestUpdate(this);
+}
+
+void XYChartWidget::appendToSeries(DataSeries &series, const QPointF *points,
+                                   int count) {
+  if (count <= 0) {
+    return;
+  }
+
+  SeriesExtent &extent = series.extent;
+  RingBuffer<QPointF> &ring = series.points;
+
+  if (extent.valid) {
+    // Rescan lazily if a point about to be evicted may be an extremum
+    if (ring.isBounded() && count >= ring.capacity()) {
+      extent.valid = false;
+    }
+    const int evicted = ring.overflow(count);
+    for (int i = 0; i < evicted && extent.valid; ++i) {
+      const QPointF &old = ring.at(i);
+      if (old.y() <= extent.yMin || old.y() >= extent.yMax ||
+          (!extent.xSorted &&
+           (old.x() <= extent.xMin || old.x() >= extent.xMax))) {
+        extent.valid = false;
+      }
+    }
+  } else if (ring.isEmpty()) {
+    extent.xMin = extent.xMax = points[0].x();
+    extent.yMin = extent.yMax = points[0].y();
+    extent.xSorted = true;
+    extent.valid = true;
+  }
+
+  if (extent.valid) {
+    double previousX = ring.isEmpty() ? points[0].x() : ring.last().x();
+    for (int i = 0; i < count; ++i) {
+      const QPointF &point = points[i];
+      if (point.x() < previousX) {
+        extent.xSorted = false;
+      }
+      previousX = point.x();
+      extent.xMin = qMin(extent.xMin, point.x());
+      extent.xMax = qMax(extent.xMax, point.x());
+      extent.yMin = qMin(extent.yMin, point.y());
+      extent.yMax = qMax(extent.yMax, point.y());
+    }
+  }
+
+  // Points pushed out of the window go to the history, oldest first:
+  // existing points, then incoming ones that do not fit at all
+  const int overflow = ring.overflow(count);
+  SeriesStatistics &statistics = series.legendStatistics;
+  if (statistics.isValid()) {
+    const int evictedExisting = qMin(overflow, ring.size());
+    for (int i = 0; i < evictedExisting; ++i) {
+      statistics.removeFirst(ring.at(i).y());
+    }
+    statistics.append(points, count);
+    for (int i = 0; i < overflow - evictedExisting; ++i) {
+      statistics.removeFirst(points[i].y());
+    }
+  }
+  if (overflow > 0 && series.history.isEnabled()) {
+    const int evictedExisting = qMin(overflow, ring.size());
+    for (int i = 0; i < evictedExisting; ++i) {
+      series.history.append(ring.at(i));
+    }
+    for (int i = 0; i < overflow - evictedExisting; ++i) {
+      series.history.append(points[i]);
+    }
+  }
+
+  ring.append(points, count);
+  series.samplesAppended += count;
+}
+
+SeriesExtent XYChartWidget::extentOf(DataSeries &series) {
+  SeriesExtent &extent = series.extent;
+
+  // Sources keep their own extents (overview or cached full range)
+  if (!series.source.isNull()) {
+    extent.valid =
+        series.source->xRange(extent.xMin, extent.xMax) &&
+        series.source->yRange(0, series.source->count(), extent.yMin,
+                              extent.yMax);
+    return extent;
+  }
+
+  // The history always lies before the raw window
+  SeriesExtent history;
+  if (series.history.extent(history.xMin, history.xMax, history.yMin,
+                            history.yMax)) {
+    history.valid = true;
+  }
+
+  const RingBuffer<QPointF> &points = series.points;
+  if (points.isEmpty()) {
+    extent = SeriesExtent();
+    return history;
+  }
+
+  if (!extent.valid) {
+    extent.xMin = extent.xMax = points.first().x();
+    extent.yMin = extent.yMax = points.first().y();
+    extent.xSorted = true;
+    double previousX = extent.xMin;
+    for (const QPointF &point : points) {
+      if (point.x() < previousX) {
+        extent.xSorted = false;
+      }
+      previousX = point.x();
+      extent.xMin = qMin(extent.xMin, point.x());
+      extent.xMax = qMax(extent.xMax, point.x());
+      extent.yMin = qMin(extent.yMin, point.y());
+      extent.yMax = qMax(extent.yMax, point.y());
+    }
+    extent.valid = true;
+  } else if (extent.xSorted) {
+    // Eviction may have moved the oldest x
+    extent.xMin = points.first().x();
+    extent.xMax = points.last().x();
+  }
+
+  if (!history.valid) {
+    return extent;
+  }
+  SeriesExtent combined = extent;
+  combined.xMin = qMin(combined.xMin, history.xMin);
+  combined.xMax = qMax(combined.xMax, history.xMax);
+  combined.yMin = qMin(combined.yMin, history.yMin);
+  combined.yMax = qMax(combined.yMax, history.yMax);
+  return combined;
+}
+
+// log10 |y| range of a series, the quantity series are clustered by. A
+// series crossing zero has no smallest magnitude and counts by its peak.
+static void seriesLogRange(const SeriesExtent &extent, double &logMin,
+                           double &logMax) {
+  const double a = std::fabs(extent.yMin);
+  const double b = std::fabs(extent.yMax);
+  logMax = std::log10(qMax(qMax(a, b), 1e-300));
+  const bool crossesZero = extent.yMin <= 0.0 && extent.yMax >= 0.0;
+  logMin = crossesZero ? logMax : std::log10(qMax(qMin(a, b), 1e-300));
+}
+
+// Overlap of two log ranges as intersection over union, each widened about
+// its centre to at least 'width' decades so near-constant series compare
+static double logRangeOverlap(double min1, double max1, double min2,
+                              double max2, double width) {
+  const double pad1 = qMax(0.0, width - (max1 - min1)) / 2.0;
+  const double pad2 = qMax(0.0, width - (max2 - min2)) / 2.0;
+  min1 -= pad1;
+  max1 += pad1;
+  min2 -= pad2;
+  max2 += pad2;
+  const double common = qMin(max1, max2) - qMax(min1, min2);
+  const double total = qMax(max1, max2) - qMin(min1, min2);
+  return common > 0.0 && total > 0.0 ? common / total : 0.0;
+}
+
+bool XYChartWidget::needsRegroup(DataSeries &series) {
+  const SeriesExtent &extent = extentOf(series);
+  if (!extent.valid) {
+    return false;
+  }
+  if (std::isnan(series.groupedLogMin)) {
+    return true;
+  }
+
+  // Hysteresis: small drifts while streaming keep the current axis
+  double logMin, logMax;
+  seriesLogRange(extent, logMin, logMax);
+  return std::fabs(logMin - series.groupedLogMin) > 0.5 ||
+         std::fabs(logMax - series.groupedLogMax) > 0.5;
+}
+
+void XYChartWidget::clearSeries(const QString &seriesName) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].points.clear();
+    if (!m_series[seriesName].compressed.isNull()) {
+      m_series[seriesName].compressed->clear();
+    } else if (!m_series[seriesName].samples.isNull()) {
+      m_series[seriesName].samples->clear();
+    } else {
+      m_series[seriesName].source.clear();
+      m_series[seriesName].sharedRing.clear();
+    }
+    m_series[seriesName].extent = SeriesExtent();
+    m_series[seriesName].history.clear();
+    if (m_series[seriesName].legendStatistics.isValid()) {
+      m_series[seriesName].legendStatistics.clear();
+    }
+    if (!m_series[seriesName].threshold.isNull()) {
+      m_series[seriesName].threshold->clear();
+    }
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::clearAllSeries() {
+  for (auto &series : m_series) {
+    series.points.clear();
+    if (!series.compressed.isNull()) {
+      series.compressed->clear();
+    } else if (!series.samples.isNull()) {
+      series.samples->clear();
+    } else {
+      series.source.clear();
+      series.sharedRing.clear();
+    }
+    series.extent = SeriesExtent();
+    series.history.clear();
+    if (series.legendStatistics.isValid()) {
+      series.legendStatistics.clear();
+    }
+    if (!series.threshold.isNull()) {
+      series.threshold->clear();
+    }
+  }
+  updateSeriesLayer();
+}
+
+void XYChartWidget::removeSeries(const QString &seriesName) {
+  m_series.remove(seriesName);
+  // Series derived from it keep their data but stop following
+  for (auto &series : m_series) {
+    if (!series.derivation.isNull() &&
+        series.derivation->sourceName() == seriesName) {
+      series.derivation.clear();
+    }
+  }
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setSeriesVisible(const QString &seriesName, bool visible) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].visible = visible;
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setSeriesColor(const QString &seriesName,
+                                   const QColor &color) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].color = color;
+    m_series[seriesName].pen.setColor(color);
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setSeriesPenWidth(const QString &seriesName, int width) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].pen.setWidth(width);
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setSeriesMarker(const QString &seriesName,
+                                    MarkerShape shape, int size) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].markerShape = shape;
+    m_series[seriesName].markerSize = qMax(size, 1);
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setSeriesLineVisible(const QString &seriesName,
+                                         bool visible) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].lineVisible = visible;
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setMarkerBudget(int maxPoints) {
+  m_markerBudget = qMax(maxPoints, 0);
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setSeriesRenderMode(const QString &seriesName,
+                                        SeriesRenderMode mode) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].renderMode = mode;
+    // Release the buffers of modes no longer in use
+    if (mode != DensityMode) {
+      m_series[seriesName].densityRaster = DensityRaster();
+    }
+    if (mode != PersistenceMode) {
+      m_series[seriesName].persistence = PersistenceBuffer();
+    }
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setSeriesPersistence(const QString &seriesName,
+                                         int halfLifeMs) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].persistenceHalfLifeMs = qMax(halfLifeMs, 0);
+    updateSeriesLayer();
+  }
+}
+
+void XYChartWidget::setXRange(double min, double max) {
+  m_xMin = min;
+  m_xMax = max;
+  m_autoScale = false;
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setYRange(double min, double max) {
+  m_yMin = min;
+  m_yMax = max;
+  m_autoScale = false;
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setAutoScale(bool enable) {
+  m_autoScale = enable;
+  if (m_autoScale) {
+    calculateAutoScale();
+  }
+  updateSeriesLayer();
+}
+
+// A log range needs positive ends; a range reaching zero or below keeps
+// its maximum and shows three decades under it
+static void makeLogRange(double &min, double &max) {
+  if (!(max > 0.0)) {
+    min = 1.0;
+    max = 10.0;
+  } else if (!(min > 0.0) || min >= max) {
+    min = max * 1e-3;
+  }
+}
+
+void XYChartWidget::setXLogScale(bool enabled) {
+  if (enabled == m_xLogScale) {
+    return;
+  }
+  m_xLogScale = enabled;
+  if (enabled) {
+    makeLogRange(m_xMin, m_xMax);
+  }
+  for (auto &series : m_series) {
+    syncLogColumns(series);
+    // Traces were drawn in the other layout coordinates
+    series.persistence = PersistenceBuffer();
+  }
+  if (m_autoScale) {
+    calculateAutoScale();
+  }
+  updateSeriesLayer();
+}
+
+bool XYChartWidget::isXLogScale() const { return m_xLogScale; }
+
+void XYChartWidget::setYLogScale(bool enabled) {
+  if (enabled && !isAxisLogScale(0)) {
+    makeLogRange(m_yMin, m_yMax);
+  }
+  setAxisLogScale(0, enabled);
+  if (m_autoScale) {
+    calculateAutoScale();
+  }
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setHistoryBudget(qint64 bytesPerSeries) {
+  m_historyBudget = qMax<qint64>(bytesPerSeries, 0);
+  for (auto &series : m_series) {
+    series.history.setMemoryBudget(m_historyBudget);
+  }
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setSeriesHistoryBudget(const QString &seriesName,
+                                           qint64 bytes) {
+  if (m_series.contains(seriesName)) {
+    m_series[seriesName].history.setMemoryBudget(bytes);
+    updateSeriesLayer();
+  }
+}
+
+static SeriesMemoryUsage measureSeries(const DataSeries &series) {
+  SeriesMemoryUsage usage;
+  usage.points = series.points.memoryUsage();
+  if (!series.source.isNull()) {
+    if (series.compressed.isNull()) {
+      usage.points += series.source->memoryUsage();
+    } else {
+      usage.compressed = series.compressed->memoryUsage();
+      usage.caches += series.compressed->cacheMemoryUsage();
+    }
+    usage.index = series.source->indexMemoryUsage();
+  }
+  usage.index += series.statistics.memoryUsage();
+  usage.history = series.history.memoryUsage();
+  usage.caches += series.densityRaster.memoryUsage() +
+                  series.persistence.memoryUsage() +
+                  series.markerSprite.memoryUsage() +
+                  series.legendStatistics.memoryUsage() +
+                  series.logX.memoryUsage() + series.logY.memoryUsage();
+  if (!series.derivation.isNull()) {
+    usage.caches += series.derivation->memoryUsage();
+  }
+  if (!series.threshold.isNull()) {
+    usage.caches += series.threshold->memoryUsage();
+  }
+  return usage;
+}
+
+SeriesMemoryUsage
+XYChartWidget::seriesMemoryUsage(const QString &seriesName) const {
+  auto it = m_series.constFind(seriesName);
+  if (it == m_series.constEnd()) {
+    return SeriesMemoryUsage();
+  }
+  return measureSeries(it.value());
+}
+
+qint64 XYChartWidget::memoryUsage() const {
+  qint64 bytes = 0;
+  for (const auto &series : m_series) {
+    bytes += measureSeries(series).total();
+  }
+  return bytes;
+}
+
+void XYChartWidget::setMemoryBudget(qint64 bytes) {
+  m_memoryBudget = qMax<qint64>(bytes, 0);
+  enforceMemoryBudget(QList<XYChartWidget *>() << this, m_memoryBudget);
+}
+
+qint64 XYChartWidget::memoryBudget() const { return m_memoryBudget; }
+
+void XYChartWidget::setGlobalMemoryBudget(qint64 bytes) {
+  s_globalMemoryBudget = qMax<qint64>(bytes, 0);
+  enforceMemoryBudget(chartRegistry(), s_globalMemoryBudget);
+}
+
+qint64 XYChartWidget::globalMemoryBudget() { return s_globalMemoryBudget; }
+
+qint64 XYChartWidget::globalMemoryUsage() {
+  qint64 bytes = 0;
+  for (const XYChartWidget *chart : chartRegistry()) {
+    bytes += chart->memoryUsage();
+  }
+  return bytes;
+}
+
+void XYChartWidget::scheduleGlobalBudgetCheck() {
+  // One timer for the process, so the check covers every chart in one pass
+  // however many of them are appending; owned by the application like the
+  // update scheduler
+  static QPointer<QTimer> timer;
+  if (timer.isNull()) {
+    timer = new QTimer(QCoreApplication::instance());
+    timer->setSingleShot(true);
+    timer->setInterval(BudgetCheckMs);
+    QObject::connect(timer.data(), &QTimer::timeout, []() {
+      enforceMemoryBudget(chartRegistry(), s_globalMemoryBudget);
+    });
+  }
+  if (!timer->isActive()) {
+    timer->start();
+  }
+}
+
+qint64 XYChartWidget::trimmableBytes(const DataSeries &series) {
+  // Raw and compressed samples; external sources are not ours to trim
+  qint64 bytes = series.points.memoryUsage();
+  if (!series.compressed.isNull()) {
+    bytes += series.compressed->memoryUsage();
+  }
+  if (!series.samples.isNull()) {
+    bytes += series.samples->memoryUsage();
+  }
+  return bytes;
+}
+
+qint64 XYChartWidget::releaseHiddenCaches() {
+  qint64 released = 0;
+  for (auto &series : m_series) {
+    if (series.visible) {
+      continue;
+    }
+    // Rebuilt on demand once the series is shown again
+    released += series.densityRaster.memoryUsage() +
+                series.persistence.memoryUsage() +
+                series.markerSprite.memoryUsage();
+    series.densityRaster = DensityRaster();
+    series.persistence = PersistenceBuffer();
+    series.markerSprite = MarkerSprite();
+  }
+  return released;
+}
+
+qint64 XYChartWidget::trimSeries(DataSeries &series, qint64 maxBytes) {
+  const qint64 before = trimmableBytes(series);
+  if (before <= maxBytes) {
+    return 0;
+  }
+
+  if (!series.compressed.isNull()) {
+    QVector<QPointF> evicted;
+    series.compressed->removeOldest(
+        before - maxBytes, series.history.isEnabled() ? &evicted : nullptr);
+    for (const QPointF &point : evicted) {
+      series.history.append(point);
+    }
+  } else if (!series.samples.isNull()) {
+    const qint64 capacity =
+        qMax<qint64>(MinTrimmedPoints, maxBytes / series.samples->sampleSize());
+    // Already within the window; bounding it would only let it grow
+    if (series.samples->count() <= capacity ||
+        (series.samples->capacity() > 0 &&
+         series.samples->capacity() <= capacity)) {
+      return 0;
+    }
+    QVector<QPointF> evicted;
+    series.samples->setCapacity(
+        capacity, series.history.isEnabled() ? &evicted : nullptr);
+    for (const QPointF &point : evicted) {
+      series.history.append(point);
+    }
+  } else if (series.source.isNull()) {
+    // Bounding the window also stops it from growing back
+    const int capacity = int(qBound<qint64>(
+        MinTrimmedPoints, maxBytes / qint64(sizeof(QPointF)),
+        std::numeric_limits<int>::max()));
+    if (series.points.size() <= capacity ||
+        (series.points.isBounded() && series.points.capacity() <= capacity)) {
+      return 0;
+    }
+    if (series.history.isEnabled()) {
+      for (int i = 0; i < series.points.size() - capacity; ++i) {
+        series.history.append(series.points.at(i));
+      }
+    }
+    series.points.setCapacity(capacity);
+  }
+  series.extent = SeriesExtent();
+  series.legendStatistics.invalidate();
+  return before - trimmableBytes(series);
+}
+
+void XYChartWidget::enforceMemoryBudget(const QList<XYChartWidget *> &charts,
+                                        qint64 budget) {
+  if (budget <= 0) {
+    return;
+  }
+  qint64 usage = 0;
+  for (const XYChartWidget *chart : charts) {
+    usage += chart->memoryUsage();
+  }
+  if (usage <= budget) {
+    return;
+  }
+
+  QVector<qint64> released(charts.size(), 0);
+  for (int i = 0; i < charts.size(); ++i) {
+    released[i] = charts.at(i)->releaseHiddenCaches();
+    usage -= released[i];
+  }
+
+  if (usage > budget) {
+    // Water-filling: the largest series are cut down to a common level,
+    // chosen so that together they free the excess
+    QVector<qint64> sizes;
+    for (const XYChartWidget *chart : charts) {
+      for (const auto &series : chart->m_series) {
+        sizes.append(trimmableBytes(series));
+      }
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<qint64>());
+
+    const qint64 excess = usage - budget;
+    qint64 level = 0;
+    qint64 sum = 0;
+    for (int k = 0; k < sizes.size(); ++k) {
+      sum += sizes.at(k);
+      const qint64 next = k + 1 < sizes.size() ? sizes.at(k + 1) : 0;
+      if (sum - (k + 1) * next >= excess) {
+        level = (sum - excess) / (k + 1);
+        break;
+      }
+    }
+
+    for (int i = 0; i < charts.size(); ++i) {
+      for (auto &series : charts.at(i)->m_series) {
+        released[i] += charts.at(i)->trimSeries(series, level);
+      }
+    }
+  }
+
+  for (int i = 0; i < charts.size(); ++i) {
+    if (released.at(i) <= 0) {
+      continue;
+    }
+    XYChartWidget *chart = charts.at(i);
+    if (chart->m_autoScale) {
+      chart->calculateAutoScale();
+    }
+    if (chart->m_multiAxisEnabled) {
+      for (auto it = chart->m_yAxes.begin(); it != chart->m_yAxes.end();
+           ++it) {
+        chart->calculateAutoScaleForAxis(it.key());
+      }
+    }
+    chart->updateSeriesLayer();
+    emit chart->memoryTrimmed(released.at(i));
+  }
+}
+
+void XYChartWidget::setMaxPointsPerSeries(int maxPoints) {
+  m_maxPointsPerSeries = maxPoints;
+
+  // Resize every window once; existing series keep their newest points and
+  // hand the rest to their history
+  for (auto &series : m_series) {
+    if (maxPoints > 0 && series.history.isEnabled()) {
+      for (int i = 0; i < series.points.size() - maxPoints; ++i) {
+        series.history.append(series.points.at(i));
+      }
+    }
+    series.points.setCapacity(qMax(maxPoints, 0));
+    if (!series.samples.isNull()) {
+      QVector<QPointF> evicted;
+      series.samples->setCapacity(
+          qMax(maxPoints, 0), series.history.isEnabled() ? &evicted : nullptr);
+      for (const QPointF &point : evicted) {
+        series.history.append(point);
+      }
+    }
+    series.extent = SeriesExtent();
+    series.legendStatistics.invalidate();
+  }
+
+  if (m_autoScale) {
+    calculateAutoScale();
+  }
+  if (m_multiAxisEnabled) {
+    for (auto it = m_yAxes.begin(); it != m_yAxes.end(); ++it) {
+      calculateAutoScaleForAxis(it.key());
+    }
+  }
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setGridVisible(bool visible) {
+  m_showGrid = visible;
+  update();
+}
+
+void XYChartWidget::setAxisLabelsVisible(bool visible) {
+  m_showAxisLabels = visible;
+  update();
+}
+
+void XYChartWidget::setLegendStatisticsVisible(bool visible) {
+  m_legendStatisticsVisible = visible;
+  if (!visible) {
+    for (auto &series : m_series) {
+      series.legendStatistics.invalidate();
+    }
+  }
+  update();
+}
+
+bool XYChartWidget::isLegendStatisticsVisible() const {
+  return m_legendStatisticsVisible;
+}
+
+void XYChartWidget::setTitle(const QString &title) {
+  m_title = title;
+  update();
+}
+
+void XYChartWidget::setXLabel(const QString &label) {
+  m_xLabel = label;
+  update();
+}
+
+void XYChartWidget::setYLabel(const QString &label) {
+  m_yLabel = label;
+  update();
+}
+
+QStringList XYChartWidget::getSeriesNames() const { return m_series.keys(); }
+
+int XYChartWidget::getSeriesCount() const { return m_series.size(); }
+
+void XYChartWidget::setCrosshairVisible(bool visible) {
+  m_crosshairVisible = visible;
+  update();
+}
+
+bool XYChartWidget::isCrosshairVisible() const { return m_crosshairVisible; }
+
+void XYChartWidget::setMeasurementCursorsVisible(bool visible) {
+  m_measurementCursorsVisible = visible;
+  if (visible && (std::isnan(m_cursorX[0]) || std::isnan(m_cursorX[1]))) {
+    setMeasurementCursors(m_xMin + (m_xMax - m_xMin) / 3.0,
+                          m_xMin + (m_xMax - m_xMin) * 2.0 / 3.0);
+  }
+  if (!visible) {
+    // The trees are rebuilt when the cursors come back
+    for (auto &series : m_series) {
+      series.statistics.clear();
     }
   }
-
   update();
 }
 
-void XYChartWidget::addPoint(const QString &seriesName, double x, double y) {
-  addPoint(seriesName, QPointF(x, y));
+bool XYChartWidget::isMeasurementCursorsVisible() const {
+  return m_measurementCursorsVisible;
 }
 
-void XYChartWidget::addPoint(const QString &seriesName, const QPointF &point) {
-  if (!m_series.contains(seriesName)) {
-    addSeries(seriesName);
-  }
-
-  m_series[seriesName].points.append(point);
+void XYChartWidget::setMeasurementCursors(double x1, double x2) {
+  m_cursorX[0] = x1;
+  m_cursorX[1] = x2;
+  emit measurementChanged(x1, x2);
+  update();
+}
 
-  // Limit number of points if set
-  if (m_maxPointsPerSeries > 0 &&
-      m_series[seriesName].points.size() > m_maxPointsPerSeries) {
-    m_series[seriesName].points.removeFirst();
-  }
+double XYChartWidget::measurementCursor(int index) const {
+  return index == 0 || index == 1 ? m_cursorX[index]
+                                  : std::numeric_limits<double>::quiet_NaN();
+}
 
-  // Auto-scale: Update both global and axis-specific scales
-  if (m_autoScale) {
-    calculateAutoScale();
+void XYChartWidget::syncStatistics(DataSeries &series) {
+  RangeStatistics &statistics = series.statistics;
+  const qint64 count = seriesCount(series);
+
+  // Samples appended since the last sync are the newest ones, and anything
+  // the series no longer holds was evicted from the front. When the counts
+  // do not add up (replaced data, new source) the tree is rebuilt.
+  bool gap = false;
+  qint64 added = unreadSamples(series, statistics.appendedSamples(), gap);
+  const qint64 evicted = statistics.count() + added - count;
+  if (gap || evicted < 0) {
+    statistics.clear();
+    added = count;
+  } else {
+    statistics.removeFirst(evicted);
   }
 
-  // Also update axis-specific auto-scale if in multi-axis mode
-  if (m_multiAxisEnabled) {
-    int axisId = m_series[seriesName].yAxisId;
-    calculateAutoScaleForAxis(axisId);
+  QVector<QPointF> chunk(ReadChunkPoints);
+  for (qint64 index = count - added; index < count;) {
+    const int n = int(qMin<qint64>(chunk.size(), count - index));
+    readSeriesPoints(series, index, n, chunk.data());
+    statistics.append(chunk.constData(), n);
+    index += n;
   }
-
-  update();
+  statistics.setAppendedSamples(series.samplesAppended);
 }
 
-void XYChartWidget::addPoints(const QString &seriesName,
-                              const QVector<QPointF> &points) {
-  if (!m_series.contains(seriesName)) {
-    addSeries(seriesName);
-  }
+void XYChartWidget::syncLogColumns(DataSeries &series) {
+  // Only in-memory points are cached; sources are transformed as read
+  const bool inMemory = series.source.isNull();
+  series.logX.setEnabled(inMemory && m_xLogScale);
+  series.logY.setEnabled(inMemory && isAxisLogScale(series.yAxisId));
+  series.logX.sync(series.points, series.samplesAppended);
+  series.logY.sync(series.points, series.samplesAppended);
+}
 
-  m_series[seriesName].points.append(points);
+qint64 XYChartWidget::seriesCount(const DataSeries &series) {
+  return series.source.isNull() ? qint64(series.points.size())
+                                : series.source->count();
+}
 
-  // Limit number of points
-  if (m_maxPointsPerSeries > 0 &&
-      m_series[seriesName].points.size() > m_maxPointsPerSeries) {
-    int excess = m_series[seriesName].points.size() - m_maxPointsPerSeries;
-    m_series[seriesName].points.remove(0, excess);
-  }
+qint64 XYChartWidget::unreadSamples(const DataSeries &series, qint64 fed,
+                                    bool &gap) {
+  const qint64 count = seriesCount(series);
+  const qint64 added = series.samplesAppended - fed;
+  // More than the series holds were evicted unread; fewer than none means
+  // the consumer counted another series (replaced or recreated)
+  gap = added > count || added < 0;
+  return gap ? count : added;
+}
 
-  // Auto-scale: Update both global and axis-specific scales
-  if (m_autoScale) {
-    calculateAutoScale();
+void XYChartWidget::readSeriesPoints(const DataSeries &series, qint64 first,
+                                     int count, QPointF *out) {
+  if (!series.source.isNull()) {
+    series.source->readPoints(first, count, out);
+    return;
   }
-
-  // Also update axis-specific auto-scale if in multi-axis mode
-  if (m_multiAxisEnabled) {
-    int axisId = m_series[seriesName].yAxisId;
-    calculateAutoScaleForAxis(axisId);
+  const int start = int(first);
+  for (int i = 0; i < count; ++i) {
+    out[i] = series.points.at(start + i);
   }
-
-  update();
 }
 
-void XYChartWidget::setSeriesData(const QString &seriesName,
-                                  const QVector<QPointF> &points) {
-  if (!m_series.contains(seriesName)) {
-    addSeries(seriesName);
+void XYChartWidget::readLayoutPoints(DataSeries &series, qint64 first,
+                                     int count, QPointF *out) {
+  const bool xLog = m_xLogScale;
+  const bool yLog = isAxisLogScale(series.yAxisId);
+  if (series.source.isNull()) {
+    syncLogColumns(series);
+    const int start = int(first);
+    for (int i = 0; i < count; ++i) {
+      const QPointF &point = series.points.at(start + i);
+      out[i] = QPointF(xLog ? series.logX.at(start + i) : point.x(),
+                       yLog ? series.logY.at(start + i) : point.y());
+    }
+    return;
   }
 
-  m_series[seriesName].points = points;
-
-  // Limit number of points
-  if (m_maxPointsPerSeries > 0 &&
-      m_series[seriesName].points.size() > m_maxPointsPerSeries) {
-    int excess = m_series[seriesName].points.size() - m_maxPointsPerSeries;
-    m_series[seriesName].points.remove(0, excess);
+  series.source->readPoints(first, count, out);
+  if (xLog || yLog) {
+    for (int i = 0; i < count; ++i) {
+      out[i] = QPointF(layoutValue(out[i].x(), xLog),
+                       layoutValue(out[i].y(), yLog));
+    }
   }
+}
 
-  // Auto-scale: Update both global and axis-specific scales
+void XYChartWidget::setTrigger(const QString &seriesName,
+                               const TriggerSettings &settings) {
+  if (m_trigger == nullptr) {
+    m_trigger = new TriggerEngine(this);
+    connect(m_trigger, &TriggerEngine::triggered, this, [this](double x) {
+      m_triggerLocked = true;
+      m_triggerX = x;
+      applyTriggerWindow();
+      emit triggered(x);
+      updateSeriesLayer();
+    });
+  }
+  m_trigger->setSettings(settings);
+  m_triggerSeries = seriesName;
+  m_triggerLocked = false;
+
+  // Only data added from now on is searched
+  m_triggerFed = m_series.contains(seriesName)
+                     ? m_series[seriesName].samplesAppended
+                     : 0;
+  m_triggerLastX = -std::numeric_limits<double>::infinity();
+}
+
+void XYChartWidget::clearTrigger() {
+  delete m_trigger;
+  m_trigger = nullptr;
+  m_triggerSeries.clear();
+  m_triggerLocked = false;
   if (m_autoScale) {
     calculateAutoScale();
   }
+  updateSeriesLayer();
+}
 
-  // Also update axis-specific auto-scale if in multi-axis mode
-  if (m_multiAxisEnabled) {
-    int axisId = m_series[seriesName].yAxisId;
-    calculateAutoScaleForAxis(axisId);
-  }
-
-  update();
+int XYChartWidget::addAnnotation(double x, const QString &label,
+                                 const QColor &color) {
+  return addAnnotationSpan(x, x, label, color);
 }
 
-void XYChartWidget::clearSeries(const QString &seriesName) {
-  if (m_series.contains(seriesName)) {
-    m_series[seriesName].points.clear();
-    update();
+int XYChartWidget::addAnnotationSpan(double xStart, double xEnd,
+                                     const QString &label,
+                                     const QColor &color) {
+  const int id = m_annotations.add(xStart, xEnd, label, color);
+  if (id >= 0) {
+    // Events may stream in; they share the next frame like new data
+    ChartUpdateScheduler::instance()->requestUpdate(this);
   }
+  return id;
 }
 
-void XYChartWidget::clearAllSeries() {
-  for (auto &series : m_series) {
-    series.points.clear();
+bool XYChartWidget::removeAnnotation(int id) {
+  if (!m_annotations.remove(id)) {
+    return false;
   }
   update();
+  return true;
 }
 
-void XYChartWidget::removeSeries(const QString &seriesName) {
-  m_series.remove(seriesName);
+void XYChartWidget::clearAnnotations() {
+  m_annotations.clear();
   update();
 }
 
-void XYChartWidget::setSeriesVisible(const QString &seriesName, bool visible) {
-  if (m_series.contains(seriesName)) {
-    m_series[seriesName].visible = visible;
-    update();
+int XYChartWidget::annotationCount() const { return m_annotations.count(); }
+
+void XYChartWidget::feedTrigger(DataSeries &series) {
+  const qint64 count = seriesCount(series);
+  bool gap = false;
+  const qint64 added = unreadSamples(series, m_triggerFed, gap);
+  m_triggerFed = series.samplesAppended;
+  if (gap) {
+    m_trigger->reset();
+  }
+  if (added <= 0) {
+    return;
   }
-}
 
-void XYChartWidget::setSeriesColor(const QString &seriesName,
-                                   const QColor &color) {
-  if (m_series.contains(seriesName)) {
-    m_series[seriesName].color = color;
-    m_series[seriesName].pen.setColor(color);
-    update();
+  QVector<QPointF> chunk(ReadChunkPoints);
+  for (qint64 index = count - added; index < count;) {
+    const int n = int(qMin<qint64>(chunk.size(), count - index));
+    readSeriesPoints(series, index, n, chunk.data());
+    // The engine expects ascending x; replaced data starts a new search
+    if (chunk.at(0).x() < m_triggerLastX) {
+      m_trigger->reset();
+    }
+    m_triggerLastX = chunk.at(n - 1).x();
+    m_trigger->feed(chunk.constData(), n);
+    index += n;
   }
 }
 
-void XYChartWidget::setSeriesPenWidth(const QString &seriesName, int width) {
-  if (m_series.contains(seriesName)) {
-    m_series[seriesName].pen.setWidth(width);
-    update();
-  }
+void XYChartWidget::applyTriggerWindow() {
+  const TriggerSettings settings = m_trigger->settings();
+  m_xMin = m_triggerX - settings.window * qBound(0.0, settings.preTrigger, 1.0);
+  m_xMax = m_xMin + settings.window;
 }
 
-void XYChartWidget::setXRange(double min, double max) {
-  m_xMin = min;
-  m_xMax = max;
-  m_autoScale = false;
-  update();
+RangeSummary XYChartWidget::rangeStatistics(const QString &seriesName,
+                                            double x1, double x2) {
+  if (!m_series.contains(seriesName)) {
+    return RangeSummary();
+  }
+  DataSeries &series = m_series[seriesName];
+  if (series.source.isNull() && !extentOf(series).xSorted) {
+    return RangeSummary();
+  }
+  syncStatistics(series);
+
+  // Index range of x in [lo, hi]
+  const double lo = qMin(x1, x2);
+  const double hi = std::nextafter(qMax(x1, x2),
+                                   std::numeric_limits<double>::infinity());
+  qint64 first, last;
+  if (!series.source.isNull()) {
+    first = series.source->lowerBound(lo);
+    last = series.source->lowerBound(hi);
+    return series.statistics.query(first, last, [&series](qint64 i) {
+      return series.source->pointAt(i).y();
+    });
+  }
+
+  const RingBuffer<QPointF> &points = series.points;
+  auto lowerBound = [&points](double x) {
+    int begin = 0;
+    int size = points.size();
+    while (size > 0) {
+      const int half = size / 2;
+      if (points.at(begin + half).x() < x) {
+        begin += half + 1;
+        size -= half + 1;
+      } else {
+        size = half;
+      }
+    }
+    return qint64(begin);
+  };
+  first = lowerBound(lo);
+  last = lowerBound(hi);
+  return series.statistics.query(
+      first, last, [&points](qint64 i) { return points.at(int(i)).y(); });
 }
 
-void XYChartWidget::setYRange(double min, double max) {
-  m_yMin = min;
-  m_yMax = max;
-  m_autoScale = false;
-  update();
+void XYChartWidget::setDarkModeEnabled(bool enabled) {
+  m_darkModeEnabled = enabled;
+  updateSeriesLayer();
 }
 
-void XYChartWidget::setAutoScale(bool enable) {
-  m_autoScale = enable;
-  if (m_autoScale) {
-    calculateAutoScale();
+bool XYChartWidget::isDarkModeEnabled() const { return m_darkModeEnabled; }
+
+void XYChartWidget::setZoomPanEnabled(bool enabled) {
+  m_zoomPanEnabled = enabled;
+  if (!enabled) {
+    m_previewing = false;
+    m_dragButton = Qt::NoButton;
+    m_frame = QImage();
   }
-  update();
+  updateSeriesLayer();
 }
 
-void XYChartWidget::setMaxPointsPerSeries(int maxPoints) {
-  m_maxPointsPerSeries = maxPoints;
-}
+bool XYChartWidget::isZoomPanEnabled() const { return m_zoomPanEnabled; }
 
-void XYChartWidget::setGridVisible(bool visible) {
-  m_showGrid = visible;
-  update();
+void XYChartWidget::setFrameTimeBudget(int ms) {
+  m_quality.setBudget(qint64(qMax(ms, 0)) * 1000000);
+  updateSeriesLayer();
 }
 
-void XYChartWidget::setAxisLabelsVisible(bool visible) {
-  m_showAxisLabels = visible;
-  update();
+int XYChartWidget::frameTimeBudget() const {
+  return int(m_quality.budget() / 1000000);
 }
 
-void XYChartWidget::setTitle(const QString &title) {
-  m_title = title;
-  update();
+RenderQuality XYChartWidget::renderQuality() const {
+  return m_quality.quality();
 }
 
-void XYChartWidget::setXLabel(const QString &label) {
-  m_xLabel = label;
-  update();
+void XYChartWidget::markBusy() {
+  m_busy = true;
+  m_qualityTimer->start();
 }
 
-void XYChartWidget::setYLabel(const QString &label) {
-  m_yLabel = label;
+void XYChartWidget::updateSeriesLayer() {
+  m_frameDirty = true;
   update();
 }
 
-QStringList XYChartWidget::getSeriesNames() const { return m_series.keys(); }
-
-int XYChartWidget::getSeriesCount() const { return m_series.size(); }
-
-void XYChartWidget::setCrosshairVisible(bool visible) {
-  m_crosshairVisible = visible;
-  update();
+int XYChartWidget::decimationColumns() const {
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  return m_quality.quality() == MinimalQuality ? plotWidth / 2 : plotWidth;
 }
 
-bool XYChartWidget::isCrosshairVisible() const { return m_crosshairVisible; }
+QPen XYChartWidget::seriesPen(const DataSeries &series) const {
+  if (m_quality.quality() == FullQuality) {
+    return series.pen;
+  }
+  // Width 0 is a cosmetic 1 px line, the rasterizer's fastest path
+  QPen pen(series.pen);
+  pen.setWidth(0);
+  return pen;
+}
 
-void XYChartWidget::setDarkModeEnabled(bool enabled) {
-  m_darkModeEnabled = enabled;
-  update();
+void XYChartWidget::setUpdatePriority(int priority) {
+  ChartUpdateScheduler::instance()->setPriority(this, priority);
 }
 
-bool XYChartWidget::isDarkModeEnabled() const { return m_darkModeEnabled; }
+int XYChartWidget::updatePriority() const {
+  return ChartUpdateScheduler::instance()->priority(this);
+}
 
 void XYChartWidget::setMultiAxisEnabled(bool enabled) {
   m_multiAxisEnabled = enabled;
   if (enabled && m_autoGroupSeries) {
     autoGroupSeriesToAxes();
   }
-  update();
+  updateSeriesLayer();
 }
 
 bool XYChartWidget::isMultiAxisEnabled() const { return m_multiAxisEnabled; }
@@ -272,7 +1831,7 @@ void XYChartWidget::setAutoGroupSeries(bool enabled) {
   if (m_multiAxisEnabled && enabled) {
     autoGroupSeriesToAxes();
   }
-  update();
+  updateSeriesLayer();
 }
 
 bool XYChartWidget::isAutoGroupEnabled() const { return m_autoGroupSeries; }
@@ -297,7 +1856,7 @@ void XYChartWidget::createYAxis(int axisId, const QString &label,
     m_nextAxisId = axisId + 1;
   }
   updateMargins();
-  update();
+  updateSeriesLayer();
 }
 
 void XYChartWidget::assignSeriesToAxis(const QString &seriesName, int axisId) {
@@ -327,7 +1886,7 @@ void XYChartWidget::assignSeriesToAxis(const QString &seriesName, int axisId) {
     }
   }
 
-  update();
+  updateSeriesLayer();
 }
 
 int XYChartWidget::getAxisForSeries(const QString &seriesName) const {
@@ -345,7 +1904,7 @@ void XYChartWidget::setAxisRange(int axisId, double min, double max) {
   m_yAxes[axisId].min = min;
   m_yAxes[axisId].max = max;
   m_yAxes[axisId].autoScale = false;
-  update();
+  updateSeriesLayer();
 }
 
 void XYChartWidget::setAxisAutoScale(int axisId, bool enabled) {
@@ -357,12 +1916,40 @@ void XYChartWidget::setAxisAutoScale(int axisId, bool enabled) {
   if (enabled) {
     calculateAutoScaleForAxis(axisId);
   }
-  update();
+  updateSeriesLayer();
+}
+
+void XYChartWidget::setAxisLogScale(int axisId, bool enabled) {
+  if (!m_yAxes.contains(axisId) || m_yAxes[axisId].logScale == enabled) {
+    return;
+  }
+
+  YAxisInfo &axis = m_yAxes[axisId];
+  axis.logScale = enabled;
+  if (enabled) {
+    makeLogRange(axis.min, axis.max);
+  }
+  for (auto &series : m_series) {
+    if (series.yAxisId == axisId) {
+      syncLogColumns(series);
+      series.persistence = PersistenceBuffer();
+    }
+  }
+  calculateAutoScaleForAxis(axisId);
+  updateSeriesLayer();
+}
+
+bool XYChartWidget::isAxisLogScale(int axisId) const {
+  auto axis = m_yAxes.constFind(axisId);
+  return axis != m_yAxes.constEnd() && axis->logScale;
 }
 
 void XYChartWidget::paintEvent(QPaintEvent *event) {
   Q_UNUSED(event);
 
+  QElapsedTimer paintTimer;
+  paintTimer.start();
+
   QPainter painter(this);
   // Optimization: Only enable antialiasing for lines and curves, not for grid
   painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
@@ -390,26 +1977,65 @@ void XYChartWidget::paintEvent(QPaintEvent *event) {
   drawAxes(painter);
 
   // Draw data series
-  drawSeries(painter);
+  drawSeriesLayer(painter);
+
+  drawAnnotations(painter);
 
   // Draw legend
   if (!m_series.isEmpty()) {
     drawLegend(painter);
   }
 
+  if (m_measurementCursorsVisible) {
+    drawMeasurementCursors(painter);
+  }
+
   // Draw crosshair
   if (m_crosshairVisible) {
     drawCrosshair(painter);
   }
+
+  // Rubber band of a zoom in progress
+  if (m_dragButton == Qt::RightButton) {
+    QColor bandColor = m_darkModeEnabled ? Qt::white : QColor(0, 90, 200);
+    painter.setPen(QPen(bandColor, 1, Qt::DashLine));
+    bandColor.setAlpha(40);
+    painter.setBrush(bandColor);
+    painter.drawRect(QRect(m_dragStart, m_dragLast).normalized());
+  }
+
+  const qint64 paintNsecs = paintTimer.nsecsElapsed();
+  ChartUpdateScheduler::instance()->reportPaintTime(this, paintNsecs);
+  // Previews and idle repaints (crosshair, legend) say nothing about the
+  // cost of streaming frames
+  if (m_busy && !m_previewing) {
+    m_quality.frameFinished(paintNsecs);
+  }
 }
 
 void XYChartWidget::resizeEvent(QResizeEvent *event) {
   QWidget::resizeEvent(event);
-  update();
+  updateSeriesLayer();
 }
 
 void XYChartWidget::mousePressEvent(QMouseEvent *event) {
-  QPointF dataPoint = mapToData(event->pos());
+  // Grab a measurement cursor within a few pixels of the click
+  if (m_measurementCursorsVisible) {
+    for (int i = 0; i < 2; ++i) {
+      const double cursorX = mapToWidget(QPointF(m_cursorX[i], 0.0), 0).x();
+      if (std::fabs(cursorX - event->pos().x()) <= 4.0) {
+        m_draggedCursor = i;
+        QWidget::mousePressEvent(event);
+        return;
+      }
+    }
+  }
+
+  if (m_zoomPanEnabled && (event->button() == Qt::LeftButton ||
+                           event->button() == Qt::RightButton)) {
+    m_dragButton = event->button();
+    m_dragStart = m_dragLast = event->pos();
+  }
 
   // Find nearest series (optimization: limit search for large datasets)
   double minDist = std::numeric_limits<double>::max();
@@ -418,9 +2044,40 @@ void XYChartWidget::mousePressEvent(QMouseEvent *event) {
   const double distanceThreshold = 10.0; // 10 pixel threshold
   const int maxPointsToCheck =
       2000; // Optimization: skip detailed search for huge datasets
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  // X range within the threshold of the click; mapped rather than scaled
+  // so that it also holds on a log X axis
+  const QPointF reach(distanceThreshold, 0.0);
+  const double xLeft = mapToData(QPointF(event->pos()) - reach).x();
+  const double xRight = mapToData(QPointF(event->pos()) + reach).x();
 
   for (auto it = m_series.begin(); it != m_series.end(); ++it) {
-    if (!it->visible || it->points.isEmpty())
+    if (!it->visible)
+      continue;
+
+    // Data sources are sorted by x: only look at samples under the cursor
+    if (!it->source.isNull() && plotWidth > 0) {
+      const SeriesDataSource &source = *it->source;
+      qint64 first = source.lowerBound(xLeft);
+      qint64 last = source.lowerBound(xRight);
+      qint64 step = (last - first > maxPointsToCheck)
+                        ? (last - first) / maxPointsToCheck
+                        : 1;
+
+      for (qint64 i = first; i < last; i += step) {
+        QPointF point = source.pointAt(i);
+        QPointF widgetPoint = mapToWidget(point, it->yAxisId);
+        double dist = QLineF(widgetPoint, event->pos()).length();
+        if (dist < minDist && dist < distanceThreshold) {
+          minDist = dist;
+          nearestSeries = it->name;
+          nearestPoint = point;
+        }
+      }
+      continue;
+    }
+
+    if (it->points.isEmpty())
       continue;
 
     // Optimization: For very large datasets, sample points instead of checking
@@ -449,6 +2106,25 @@ void XYChartWidget::mousePressEvent(QMouseEvent *event) {
 }
 
 void XYChartWidget::mouseMoveEvent(QMouseEvent *event) {
+  if (m_draggedCursor >= 0) {
+    m_cursorX[m_draggedCursor] = mapToData(QPointF(event->pos()), 0).x();
+    emit measurementChanged(m_cursorX[0], m_cursorX[1]);
+    update();
+  }
+
+  if (m_dragButton == Qt::LeftButton) {
+    // Pan: the plot area moves with the mouse
+    const QPoint delta = event->pos() - m_dragLast;
+    const QRectF plotRect(m_leftMargin, m_topMargin,
+                          width() - m_leftMargin - m_rightMargin,
+                          height() - m_topMargin - m_bottomMargin);
+    showWidgetRect(plotRect.translated(-delta));
+  }
+  if (m_dragButton != Qt::NoButton) {
+    m_dragLast = event->pos();
+    update();
+  }
+
   // Optimization: Only update if crosshair position actually changed
   if (m_crosshairPos != event->pos()) {
     m_crosshairPos = event->pos();
@@ -457,6 +2133,93 @@ void XYChartWidget::mouseMoveEvent(QMouseEvent *event) {
   QWidget::mouseMoveEvent(event);
 }
 
+void XYChartWidget::mouseReleaseEvent(QMouseEvent *event) {
+  m_draggedCursor = -1;
+  if (m_dragButton == Qt::RightButton) {
+    // Tiny bands are accidental clicks
+    const QRect band = QRect(m_dragStart, event->pos()).normalized();
+    if (band.width() > 4 && band.height() > 4) {
+      showWidgetRect(band);
+    }
+    update();
+  }
+  m_dragButton = Qt::NoButton;
+  QWidget::mouseReleaseEvent(event);
+}
+
+void XYChartWidget::mouseDoubleClickEvent(QMouseEvent *event) {
+  if (m_zoomPanEnabled && event->button() == Qt::LeftButton) {
+    for (auto it = m_yAxes.begin(); it != m_yAxes.end(); ++it) {
+      it->autoScale = true;
+      calculateAutoScaleForAxis(it.key());
+    }
+    m_previewing = false;
+    setAutoScale(true);
+    emit viewChanged(m_xMin, m_xMax, m_yMin, m_yMax);
+  }
+  QWidget::mouseDoubleClickEvent(event);
+}
+
+void XYChartWidget::wheelEvent(QWheelEvent *event) {
+  if (!m_zoomPanEnabled) {
+    QWidget::wheelEvent(event);
+    return;
+  }
+
+  // Some platforms turn Shift+wheel into horizontal scrolling
+  const int delta = event->angleDelta().y() != 0 ? event->angleDelta().y()
+                                                 : event->angleDelta().x();
+  const double factor = std::pow(0.999, delta);  // about 11% per notch
+  const double xFactor = event->modifiers() & Qt::ControlModifier ? 1.0 : factor;
+  const double yFactor = event->modifiers() & Qt::ShiftModifier ? 1.0 : factor;
+
+  // Scale the plot area about the cursor
+  const QPointF anchor = event->pos();
+  const QRectF plotRect(m_leftMargin, m_topMargin,
+                        width() - m_leftMargin - m_rightMargin,
+                        height() - m_topMargin - m_bottomMargin);
+  showWidgetRect(QRectF(anchor.x() - (anchor.x() - plotRect.left()) * xFactor,
+                        anchor.y() - (anchor.y() - plotRect.top()) * yFactor,
+                        plotRect.width() * xFactor,
+                        plotRect.height() * yFactor));
+  event->accept();
+}
+
+void XYChartWidget::showWidgetRect(const QRectF &rect) {
+  if (!(rect.width() > 0.0 && rect.height() > 0.0)) {
+    return;
+  }
+
+  // Every axis maps through the current view before any range changes
+  QMap<int, QPair<double, double>> axisRanges;
+  for (auto it = m_yAxes.constBegin(); it != m_yAxes.constEnd(); ++it) {
+    axisRanges[it.key()] =
+        qMakePair(mapToData(rect.bottomLeft(), it.key()).y(),
+                  mapToData(rect.topLeft(), it.key()).y());
+  }
+  const QPointF topLeft = mapToData(rect.topLeft());
+  const QPointF bottomRight = mapToData(rect.bottomRight());
+
+  m_xMin = topLeft.x();
+  m_xMax = bottomRight.x();
+  m_yMin = bottomRight.y();
+  m_yMax = topLeft.y();
+  m_autoScale = false;
+  for (auto it = axisRanges.constBegin(); it != axisRanges.constEnd(); ++it) {
+    YAxisInfo &axis = m_yAxes[it.key()];
+    axis.min = it->first;
+    axis.max = it->second;
+    axis.autoScale = false;
+  }
+
+  // Preview from the cached frame now, exact redraw once the view settles
+  markBusy();
+  m_previewing = true;
+  m_settleTimer->start();
+  emit viewChanged(m_xMin, m_xMax, m_yMin, m_yMax);
+  update();
+}
+
 void XYChartWidget::leaveEvent(QEvent *event) {
   m_crosshairPos = QPoint(-1, -1);
   update();
@@ -467,56 +2230,112 @@ void XYChartWidget::calculateAutoScale() {
   if (m_series.isEmpty())
     return;
 
+  // Fitted in layout space, so log axes get their margin in decades
+  const bool yLog = isAxisLogScale(0);
+  double xMin = layoutValue(m_xMin, m_xLogScale);
+  double xMax = layoutValue(m_xMax, m_xLogScale);
+  double yMin = layoutValue(m_yMin, yLog);
+  double yMax = layoutValue(m_yMax, yLog);
   bool firstPoint = true;
 
-  for (const auto &series : m_series) {
-    if (!series.visible || series.points.isEmpty())
+  for (auto &series : m_series) {
+    if (!series.visible)
       continue;
 
-    for (const QPointF &point : series.points) {
-      if (firstPoint) {
-        m_xMin = m_xMax = point.x();
-        m_yMin = m_yMax = point.y();
-        firstPoint = false;
-      } else {
-        m_xMin = qMin(m_xMin, point.x());
-        m_xMax = qMax(m_xMax, point.x());
-        m_yMin = qMin(m_yMin, point.y());
-        m_yMax = qMax(m_yMax, point.y());
-      }
+    const SeriesExtent &extent = extentOf(series);
+    if (!extent.valid)
+      continue;
+
+    double seriesXMin = extent.xMin, seriesXMax = extent.xMax;
+    double seriesYMin = extent.yMin, seriesYMax = extent.yMax;
+    if (m_xLogScale && !logExtent(series, true, seriesXMin, seriesXMax))
+      continue;
+    if (yLog && !logExtent(series, false, seriesYMin, seriesYMax))
+      continue;
+
+    if (firstPoint) {
+      xMin = seriesXMin;
+      xMax = seriesXMax;
+      yMin = seriesYMin;
+      yMax = seriesYMax;
+      firstPoint = false;
+    } else {
+      xMin = qMin(xMin, seriesXMin);
+      xMax = qMax(xMax, seriesXMax);
+      yMin = qMin(yMin, seriesYMin);
+      yMax = qMax(yMax, seriesYMax);
     }
   }
 
   // Thêm margin 5%
-  double xRange = m_xMax - m_xMin;
-  double yRange = m_yMax - m_yMin;
+  double xRange = xMax - xMin;
+  double yRange = yMax - yMin;
 
   if (xRange < 1e-10)
     xRange = 1.0;
   if (yRange < 1e-10)
     yRange = 1.0;
 
-  m_xMin -= xRange * 0.05;
-  m_xMax += xRange * 0.05;
-  m_yMin -= yRange * 0.05;
-  m_yMax += yRange * 0.05;
+  m_xMin = axisValue(xMin - xRange * 0.05, m_xLogScale);
+  m_xMax = axisValue(xMax + xRange * 0.05, m_xLogScale);
+  m_yMin = axisValue(yMin - yRange * 0.05, yLog);
+  m_yMax = axisValue(yMax + yRange * 0.05, yLog);
+
+  // A triggered view keeps its x window until the next edge
+  if (m_triggerLocked) {
+    applyTriggerWindow();
+  }
+}
+
+bool XYChartWidget::logExtent(DataSeries &series, bool xCoordinate,
+                              double &min, double &max) {
+  // Cached columns know the log range exactly
+  bool valid = false;
+  syncLogColumns(series);
+  LogColumn &column = xCoordinate ? series.logX : series.logY;
+  if (column.isEnabled()) {
+    valid = column.range(min, max);
+    if (series.history.isEmpty()) {
+      return valid;
+    }
+  }
+
+  // Sources and history only keep a linear extent; one reaching zero or
+  // below is shown down to six decades under its maximum
+  const SeriesExtent extent = extentOf(series);
+  const double low = xCoordinate ? extent.xMin : extent.yMin;
+  const double high = xCoordinate ? extent.xMax : extent.yMax;
+  if (!extent.valid || !(high > 0.0)) {
+    return valid;
+  }
+  const double logMax = std::log10(high);
+  const double logMin = low > 0.0 ? std::log10(low) : logMax - 6.0;
+  min = valid ? qMin(min, logMin) : logMin;
+  max = valid ? qMax(max, logMax) : logMax;
+  return true;
 }
 
 QPointF XYChartWidget::mapToWidget(const QPointF &dataPoint) const {
   int plotWidth = width() - m_leftMargin - m_rightMargin;
   int plotHeight = height() - m_topMargin - m_bottomMargin;
 
-  double xRange = m_xMax - m_xMin;
-  double yRange = m_yMax - m_yMin;
+  // The global Y range follows axis 0's scale
+  const bool yLog = isAxisLogScale(0);
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  const double yMin = layoutValue(m_yMin, yLog);
+  double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  double yRange = layoutValue(m_yMax, yLog) - yMin;
 
   if (xRange < 1e-10)
     xRange = 1.0;
   if (yRange < 1e-10)
     yRange = 1.0;
 
-  double x = m_leftMargin + (dataPoint.x() - m_xMin) / xRange * plotWidth;
+  double x = m_leftMargin +
+             (layoutValue(dataPoint.x(), m_xLogScale) - xMin) / xRange *
+                 plotWidth;
   double y = height() - m_bottomMargin -
-             (dataPoint.y() - m_yMin) / yRange * plotHeight;
+             (layoutValue(dataPoint.y(), yLog) - yMin) / yRange * plotHeight;
 
   return QPointF(x, y);
 }
@@ -525,62 +2344,76 @@ QPointF XYChartWidget::mapToData(const QPointF &widgetPoint) const {
   int plotWidth = width() - m_leftMargin - m_rightMargin;
   int plotHeight = height() - m_topMargin - m_bottomMargin;
 
-  double xRange = m_xMax - m_xMin;
-  double yRange = m_yMax - m_yMin;
+  const bool yLog = isAxisLogScale(0);
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  const double yMin = layoutValue(m_yMin, yLog);
+  double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  double yRange = layoutValue(m_yMax, yLog) - yMin;
 
-  double x = m_xMin + (widgetPoint.x() - m_leftMargin) / plotWidth * xRange;
-  double y = m_yMin + (height() - m_bottomMargin - widgetPoint.y()) /
-                          plotHeight * yRange;
+  double x = xMin + (widgetPoint.x() - m_leftMargin) / plotWidth * xRange;
+  double y = yMin + (height() - m_bottomMargin - widgetPoint.y()) /
+                        plotHeight * yRange;
 
-  return QPointF(x, y);
+  return QPointF(axisValue(x, m_xLogScale), axisValue(y, yLog));
 }
 
 QPointF XYChartWidget::mapToWidget(const QPointF &dataPoint, int axisId) const {
+  QPointF scale;
+  QPointF offset;
+  layoutTransform(axisId, scale, offset);
+  return QPointF(
+      offset.x() + layoutValue(dataPoint.x(), m_xLogScale) * scale.x(),
+      offset.y() +
+          layoutValue(dataPoint.y(), isAxisLogScale(axisId)) * scale.y());
+}
+
+QPointF XYChartWidget::mapToData(const QPointF &widgetPoint, int axisId) const {
   int plotWidth = width() - m_leftMargin - m_rightMargin;
   int plotHeight = height() - m_topMargin - m_bottomMargin;
 
-  double xRange = m_xMax - m_xMin;
-  if (xRange < 1e-10)
-    xRange = 1.0;
-  double x = m_leftMargin + (dataPoint.x() - m_xMin) / xRange * plotWidth;
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  double x = xMin + (widgetPoint.x() - m_leftMargin) / plotWidth * xRange;
 
   // Use axis-specific Y range
-  double yRange = 10.0;
   double yMin = 0.0, yMax = 10.0;
-
+  const bool yLog = isAxisLogScale(axisId);
   if (m_yAxes.contains(axisId)) {
-    yMin = m_yAxes[axisId].min;
-    yMax = m_yAxes[axisId].max;
-    yRange = yMax - yMin;
+    yMin = layoutValue(m_yAxes[axisId].min, yLog);
+    yMax = layoutValue(m_yAxes[axisId].max, yLog);
   }
+  double yRange = yMax - yMin;
 
-  if (yRange < 1e-10)
-    yRange = 1.0;
-  double y =
-      height() - m_bottomMargin - (dataPoint.y() - yMin) / yRange * plotHeight;
+  double y = yMin + (height() - m_bottomMargin - widgetPoint.y()) / plotHeight *
+                        yRange;
 
-  return QPointF(x, y);
+  return QPointF(axisValue(x, m_xLogScale), axisValue(y, yLog));
 }
 
-QPointF XYChartWidget::mapToData(const QPointF &widgetPoint, int axisId) const {
+void XYChartWidget::layoutTransform(int axisId, QPointF &scale,
+                                    QPointF &offset) const {
   int plotWidth = width() - m_leftMargin - m_rightMargin;
   int plotHeight = height() - m_topMargin - m_bottomMargin;
 
-  double xRange = m_xMax - m_xMin;
-  double x = m_xMin + (widgetPoint.x() - m_leftMargin) / plotWidth * xRange;
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  if (xRange < 1e-10)
+    xRange = 1.0;
 
   // Use axis-specific Y range
-  double yMin = 0.0, yMax = 10.0;
-  if (m_yAxes.contains(axisId)) {
-    yMin = m_yAxes[axisId].min;
-    yMax = m_yAxes[axisId].max;
+  double yRange = 10.0;
+  double yMin = 0.0;
+  auto axis = m_yAxes.constFind(axisId);
+  if (axis != m_yAxes.constEnd()) {
+    yMin = layoutValue(axis->min, axis->logScale);
+    yRange = layoutValue(axis->max, axis->logScale) - yMin;
   }
-  double yRange = yMax - yMin;
-
-  double y = yMin + (height() - m_bottomMargin - widgetPoint.y()) / plotHeight *
-                        yRange;
+  if (yRange < 1e-10)
+    yRange = 1.0;
 
-  return QPointF(x, y);
+  scale = QPointF(plotWidth / xRange, -plotHeight / yRange);
+  offset = QPointF(m_leftMargin - xMin * scale.x(),
+                   height() - m_bottomMargin - yMin * scale.y());
 }
 
 void XYChartWidget::drawGrid(QPainter &painter) {
@@ -680,7 +2513,6 @@ void XYChartWidget::drawYAxis(QPainter &painter, const YAxisInfo &axis) {
 
     // Draw tick marks and value labels
     for (int i = 0; i <= 10; ++i) {
-      double value = axis.min + (axis.max - axis.min) * i / 10;
       int y = height() - m_bottomMargin -
               (height() - m_topMargin - m_bottomMargin) * i / 10;
 
@@ -688,7 +2520,7 @@ void XYChartWidget::drawYAxis(QPainter &painter, const YAxisInfo &axis) {
       painter.drawLine(xPos - 3, y, xPos + 3, y);
 
       // Value label
-      QString valueStr = QString::number(value, 'f', 1);
+      QString valueStr = tickLabel(axis.min, axis.max, i, axis.logScale);
       if (axis.side == Qt::AlignRight) {
         painter.drawText(xPos + 5, y - 10, 50, 20,
                          Qt::AlignLeft | Qt::AlignVCenter, valueStr);
@@ -778,27 +2610,23 @@ void XYChartWidget::drawAxes(QPainter &painter) {
     // Optimization: Pre-calculate axis dimensions
     const int plotWidth = width() - m_leftMargin - m_rightMargin;
     const int plotHeight = height() - m_topMargin - m_bottomMargin;
-    const double xRange = m_xMax - m_xMin;
-    const double yRange = m_yMax - m_yMin;
-    const double xStep = xRange / 10.0;
-    const double yStep = yRange / 10.0;
 
     // X-axis labels - optimized calculations
     for (int i = 0; i <= 10; ++i) {
-      double value = m_xMin + (xStep * i);
       int x = m_leftMargin + (plotWidth * i / 10);
       painter.drawText(x - 30, height() - m_bottomMargin + 20, 60, 20,
-                       Qt::AlignCenter, QString::number(value, 'f', 1));
+                       Qt::AlignCenter,
+                       tickLabel(m_xMin, m_xMax, i, m_xLogScale));
     }
 
     // Y-axis labels (only for single axis mode)
     if (!m_multiAxisEnabled) {
+      const bool yLog = isAxisLogScale(0);
       for (int i = 0; i <= 10; ++i) {
-        double value = m_yMin + (yStep * i);
         int y = height() - m_bottomMargin - (plotHeight * i / 10);
         painter.drawText(5, y - 10, m_leftMargin - 10, 20,
                          Qt::AlignRight | Qt::AlignVCenter,
-                         QString::number(value, 'f', 1));
+                         tickLabel(m_yMin, m_yMax, i, yLog));
       }
     }
 
@@ -822,46 +2650,688 @@ void XYChartWidget::drawAxes(QPainter &painter) {
 }
 
 void XYChartWidget::drawSeries(QPainter &painter) {
-  for (const auto &series : m_series) {
-    if (!series.visible || series.points.size() < 2)
+  int markerBudget = m_markerBudget;
+
+  for (auto &series : m_series) {
+    if (!series.visible)
+      continue;
+
+    syncLogColumns(series);
+    if (!series.threshold.isNull())
+      drawThreshold(painter, series);
+
+    if (series.renderMode == DensityMode) {
+      drawDensitySeries(painter, series);
+      continue;
+    }
+    if (series.renderMode == PersistenceMode) {
+      drawPersistenceSeries(painter, series);
+      continue;
+    }
+    if (series.renderMode == EnvelopeMode) {
+      drawEnvelopeSeries(painter, series);
+      continue;
+    }
+
+    if (!series.source.isNull()) {
+      drawSourceSeries(painter, series, markerBudget);
+      continue;
+    }
+
+    if (series.points.isEmpty() && series.history.isEmpty())
+      continue;
+
+    // Below full quality, long sorted lines (with their history) are
+    // min/max decimated instead of drawn segment by segment
+    const int plotWidth = width() - m_leftMargin - m_rightMargin;
+    if (m_quality.quality() != FullQuality && series.lineVisible &&
+        series.points.size() > 2 * plotWidth && extentOf(series).xSorted) {
+      painter.setPen(seriesPen(series));
+      drawDecimated(painter, series, decimationColumns());
+      continue;
+    }
+
+    if (!series.history.isEmpty())
+      drawHistory(painter, series);
+
+    if (series.points.isEmpty())
       continue;
 
-    painter.setPen(series.pen);
+    painter.setPen(seriesPen(series));
 
     // Use axis-specific mapping based on the series' yAxisId
     int axisId = series.yAxisId;
 
     // Optimization: Draw lines as a polyline instead of individual segments
     QVector<QPointF> widgetPoints;
-    widgetPoints.reserve(series.points.size());
-
-    for (int i = 0; i < series.points.size(); ++i) {
-      widgetPoints.append(mapToWidget(series.points[i], axisId));
+    const bool logScale = m_xLogScale || isAxisLogScale(axisId);
+    if (logScale) {
+      // From the cached log10 columns the mapping is one affine step, as
+      // on linear axes
+      QPointF scale;
+      QPointF offset;
+      layoutTransform(axisId, scale, offset);
+      widgetPoints.resize(series.points.size());
+      readLayoutPoints(series, 0, widgetPoints.size(), widgetPoints.data());
+      for (QPointF &point : widgetPoints) {
+        point = QPointF(offset.x() + point.x() * scale.x(),
+                        offset.y() + point.y() * scale.y());
+      }
+    } else {
+      widgetPoints.reserve(series.points.size());
+      for (int i = 0; i < series.points.size(); ++i) {
+        widgetPoints.append(mapToWidget(series.points[i], axisId));
+      }
     }
 
     // Draw polyline in one operation
-    if (widgetPoints.size() >= 2) {
+    if (series.lineVisible && widgetPoints.size() >= 2) {
       for (int i = 0; i < widgetPoints.size() - 1; ++i) {
+        // Values <= 0 on a log axis leave a gap
+        if (logScale && !(isFinitePoint(widgetPoints[i]) &&
+                          isFinitePoint(widgetPoints[i + 1])))
+          continue;
         painter.drawLine(widgetPoints[i], widgetPoints[i + 1]);
       }
     }
 
-    // Optimization: Skip point drawing for datasets with many points (> 500)
-    // as individual points become imperceptible and expensive to draw
-    if (series.points.size() <= 500) {
-      painter.setBrush(series.color);
-      for (const QPointF &widgetPoint : widgetPoints) {
-        painter.drawEllipse(widgetPoint, 3, 3);
+    drawMarkers(painter, series, widgetPoints, markerBudget);
+  }
+}
+
+void XYChartWidget::drawSeriesLayer(QPainter &painter) {
+  const QRect plotRect(m_leftMargin, m_topMargin,
+                       width() - m_leftMargin - m_rightMargin,
+                       height() - m_topMargin - m_bottomMargin);
+  const bool antialiased = m_quality.quality() == FullQuality;
+  if (!m_zoomPanEnabled || plotRect.isEmpty()) {
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing, antialiased);
+    drawSeries(painter);
+    painter.restore();
+    return;
+  }
+
+  // Crosshair, cursor, legend and annotation repaints leave the series as
+  // they were: reuse the frame while neither data nor the view changed
+  const qreal ratio = devicePixelRatioF();
+  if (!m_frameDirty && !m_frame.isNull() && m_framePlotRect == plotRect &&
+      m_frame.devicePixelRatio() == ratio && m_frameXMin == m_xMin &&
+      m_frameXMax == m_xMax && m_frameYMin == m_yMin &&
+      m_frameYMax == m_yMax) {
+    painter.drawImage(plotRect.topLeft(), m_frame);
+    return;
+  }
+
+  if (m_previewing && !m_frame.isNull()) {
+    // Zoom and pan move every axis by the same widget-space transform, so
+    // placing the cached view through the global range places all series
+    const QPointF topLeft = mapToWidget(QPointF(m_frameXMin, m_frameYMax));
+    const QPointF bottomRight = mapToWidget(QPointF(m_frameXMax, m_frameYMin));
+    painter.save();
+    painter.setClipRect(plotRect);
+    painter.drawImage(QRectF(topLeft, bottomRight), m_frame);
+    painter.restore();
+    return;
+  }
+
+  // Series are drawn into the cached frame, clipped to the plot area
+  const QSize size(qRound(plotRect.width() * ratio),
+                   qRound(plotRect.height() * ratio));
+  if (m_frame.size() != size) {
+    m_frame = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    m_frame.setDevicePixelRatio(ratio);
+  }
+  m_frame.fill(Qt::transparent);
+  {
+    QPainter layer(&m_frame);
+    layer.setRenderHints(painter.renderHints());
+    layer.setRenderHint(QPainter::Antialiasing, antialiased);
+    layer.translate(-plotRect.left(), -plotRect.top());
+    drawSeries(layer);
+  }
+  painter.drawImage(plotRect.topLeft(), m_frame);
+
+  m_frameXMin = m_xMin;
+  m_frameXMax = m_xMax;
+  m_frameYMin = m_yMin;
+  m_frameYMax = m_yMax;
+  m_framePlotRect = plotRect;
+  m_frameDirty = false;
+}
+
+void XYChartWidget::drawDensitySeries(QPainter &painter, DataSeries &series) {
+  const QRect plotRect(m_leftMargin, m_topMargin,
+                       width() - m_leftMargin - m_rightMargin,
+                       height() - m_topMargin - m_bottomMargin);
+  if (plotRect.isEmpty())
+    return;
+
+  // The layout-to-pixel mapping is affine, so binning needs only a scale
+  // and an offset instead of a mapToWidget() call per point
+  QPointF scale;
+  QPointF offset;
+  layoutTransform(series.yAxisId, scale, offset);
+  offset -= QPointF(plotRect.topLeft());
+
+  DensityRaster &raster = series.densityRaster;
+  raster.reset(plotRect.size());
+
+  if (m_xLogScale || isAxisLogScale(series.yAxisId)) {
+    // Log axes bin layout points: cached columns or transformed samples
+    qint64 first = 0;
+    qint64 last = series.points.size();
+    if (!series.source.isNull()) {
+      first = series.source->lowerBound(m_xMin);
+      last = qMin(series.source->lowerBound(m_xMax) + 1,
+                  series.source->count());
+    }
+    QVector<QPointF> chunk(ReadChunkPoints);
+    for (qint64 index = first; index < last;) {
+      const int n = int(qMin<qint64>(chunk.size(), last - index));
+      readLayoutPoints(series, index, n, chunk.data());
+      raster.accumulate(chunk.constData(), n, scale, offset);
+      index += n;
+    }
+  } else if (!series.source.isNull()) {
+    const SeriesDataSource &source = *series.source;
+    raster.accumulate(source, source.lowerBound(m_xMin),
+                      source.lowerBound(m_xMax) + 1, scale, offset);
+  } else {
+    for (int run = 0; run < 2; ++run) {
+      int length = 0;
+      const QPointF *points = series.points.run(run, length);
+      raster.accumulate(points, length, scale, offset);
+    }
+  }
+
+  painter.drawImage(plotRect.topLeft(), raster.image(series.color));
+}
+
+void XYChartWidget::drawPersistenceSeries(QPainter &painter,
+                                          DataSeries &series) {
+  const QRect plotRect(m_leftMargin, m_topMargin,
+                       width() - m_leftMargin - m_rightMargin,
+                       height() - m_topMargin - m_bottomMargin);
+  if (plotRect.isEmpty())
+    return;
+
+  // Traces are in layout coordinates (log10 on log axes)
+  QPointF scale;
+  QPointF offset;
+  layoutTransform(series.yAxisId, scale, offset);
+  offset -= QPointF(plotRect.topLeft());
+
+  // Autoscale and pans carry the accumulated image over; a new size or a
+  // large zoom starts over from the data currently held
+  PersistenceBuffer &buffer = series.persistence;
+  const bool restarted = buffer.prepare(plotRect.size(), scale, offset);
+  const float peak = buffer.decay(series.persistenceHalfLifeMs);
+
+  const qint64 size = seriesCount(series);
+  qint64 first = 0;
+  qint64 last = size;
+  if (restarted && !series.source.isNull()) {
+    // A source can be far larger than the view: start from what is visible
+    first = qMax<qint64>(series.source->lowerBound(m_xMin) - 1, 0);
+    last = qMin(series.source->lowerBound(m_xMax) + 1, size);
+  } else {
+    // Only samples appended since the last frame (sources grow too:
+    // compressed, raw-sample and shared-ring series), plus the one before
+    // them to continue the trace
+    const qint64 fresh = series.samplesAppended - buffer.drawnSamples();
+    first = size - qMin(fresh, size);
+    if (first > 0 && first < size && !restarted) {
+      --first;
+    }
+  }
+  QVector<QPointF> trace(int(qMax<qint64>(last - first, 0)));
+  readLayoutPoints(series, first, trace.size(), trace.data());
+  buffer.addTrace(trace.constData(), trace.size());
+  buffer.setDrawnSamples(series.samplesAppended);
+
+  painter.drawImage(plotRect.topLeft(), buffer.image(series.color));
+
+  if (peak > 0.01f && !m_persistenceTimer->isActive()) {
+    m_persistenceTimer->start();
+  }
+}
+
+void XYChartWidget::drawMarkers(QPainter &painter, DataSeries &series,
+                                const QVector<QPointF> &widgetPoints,
+                                int &markerBudget) {
+  if (series.markerShape == NoMarker || widgetPoints.isEmpty() ||
+      m_quality.quality() == MinimalQuality)
+    return;
+
+  const QRect plotRect(m_leftMargin, m_topMargin,
+                       width() - m_leftMargin - m_rightMargin,
+                       height() - m_topMargin - m_bottomMargin);
+
+  // Sprites make markers cheap, so the limits are legibility (on a line,
+  // denser markers merge into a band) and the per-frame budget
+  if (series.lineVisible && widgetPoints.size() > plotRect.width())
+    return;
+  if (widgetPoints.size() > markerBudget)
+    return;
+  markerBudget -= widgetPoints.size();
+
+  series.markerSprite.setStyle(series.markerShape, series.markerSize,
+                               series.color, devicePixelRatioF());
+  series.markerSprite.draw(painter, widgetPoints.constData(),
+                           widgetPoints.size(), plotRect);
+}
+
+void XYChartWidget::drawSourceSeries(QPainter &painter, DataSeries &series,
+                                     int &markerBudget) {
+  const SeriesDataSource &source = *series.source;
+  const qint64 count = source.count();
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  const double xRange = m_xMax - m_xMin;
+  if (count < 1 || plotWidth <= 0 || xRange <= 0.0)
+    return;
+
+  const int axisId = series.yAxisId;
+  const bool logScale = m_xLogScale || isAxisLogScale(axisId);
+
+  // Visible samples, widened by one on each side so lines reach the edges
+  const qint64 first = qMax<qint64>(source.lowerBound(m_xMin) - 1, 0);
+  const qint64 last = qMin(source.lowerBound(m_xMax) + 1, count);
+  if (last - first < 1)
+    return;
+
+  painter.setPen(seriesPen(series));
+
+  QVector<QPointF> widgetPoints;
+
+  // Few enough samples on screen, or a scatter series whose markers fit
+  // the budget: draw every one of them
+  const bool scatter = !series.lineVisible && series.markerShape != NoMarker;
+  if (last - first <= 2 * plotWidth ||
+      (scatter && last - first <= markerBudget)) {
+    widgetPoints.resize(int(last - first));
+    source.readPoints(first, last - first, widgetPoints.data());
+    for (QPointF &point : widgetPoints) {
+      point = mapToWidget(point, axisId);
+    }
+    if (series.lineVisible && logScale) {
+      // Split at values <= 0, which a log axis cannot place
+      int start = 0;
+      for (int i = 0; i <= widgetPoints.size(); ++i) {
+        if (i < widgetPoints.size() && isFinitePoint(widgetPoints[i]))
+          continue;
+        if (i - start >= 2)
+          painter.drawPolyline(widgetPoints.constData() + start, i - start);
+        start = i + 1;
+      }
+    } else if (series.lineVisible) {
+      painter.drawPolyline(widgetPoints.constData(), widgetPoints.size());
+    }
+    drawMarkers(painter, series, widgetPoints, markerBudget);
+    return;
+  }
+
+  drawDecimated(painter, series, decimationColumns());
+}
+
+void XYChartWidget::drawDecimated(QPainter &painter, const DataSeries &series,
+                                  int columnCount) {
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  const int axisId = series.yAxisId;
+  if (columnCount <= 0)
+    return;
+
+  // Min/max decimation: each column becomes a vertical span from its
+  // minimum to its maximum, joined to its neighbours through the column's
+  // first and last sample
+  QVector<ColumnStats> columns;
+  aggregateColumns(series, columnCount, columns);
+
+  const double columnWidth = double(plotWidth) / columnCount;
+  QVector<QPointF> widgetPoints;
+  widgetPoints.reserve(columnCount * 4);
+  for (int column = 0; column < columns.size(); ++column) {
+    const ColumnStats &stats = columns[column];
+    if (stats.count == 0)
+      continue;
+
+    const double x = m_leftMargin + (column + 0.5) * columnWidth;
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.firstY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.minY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.maxY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.lastY), axisId).y()));
+  }
+
+  painter.drawPolyline(widgetPoints.constData(), widgetPoints.size());
+}
+
+void XYChartWidget::aggregateColumns(const DataSeries &series, int plotWidth,
+                                     QVector<ColumnStats> &columns) const {
+  columns.fill(ColumnStats(), qMax(plotWidth, 0));
+  // Columns are equally wide in layout space (decades on a log X axis)
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  const double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  if (plotWidth <= 0 || !(xRange > 0.0))
+    return;
+
+  if (!series.source.isNull()) {
+    // Column boundaries by binary search and min/max from the source's
+    // overview, so the cost depends on the plot width, not on the sample
+    // count. The overview has no sums; the centre is the span midpoint.
+    const SeriesDataSource &source = *series.source;
+    const qint64 last = qMin(source.lowerBound(m_xMax) + 1, source.count());
+    QVector<qint64> bounds(plotWidth + 1);
+    bounds[0] = qMin(qMax<qint64>(source.lowerBound(m_xMin) - 1, 0), last);
+    for (int column = 0; column < plotWidth; ++column) {
+      qint64 end = last;
+      if (column + 1 < plotWidth && bounds.at(column) < last) {
+        double columnEnd =
+            axisValue(xMin + xRange * (column + 1) / plotWidth, m_xLogScale);
+        end = qBound(bounds.at(column), source.lowerBound(columnEnd), last);
+      }
+      bounds[column + 1] = end;
+    }
+
+    // One call, so typed sources decimate their raw samples directly
+    QVector<SpanRange> spans(plotWidth);
+    source.spanRanges(bounds.constData(), plotWidth, spans.data());
+    for (int column = 0; column < plotWidth; ++column) {
+      const qint64 count = bounds.at(column + 1) - bounds.at(column);
+      if (count <= 0)
+        continue;
+
+      ColumnStats &stats = columns[column];
+      const SpanRange &span = spans.at(column);
+      stats.minY = span.minY;
+      stats.maxY = span.maxY;
+      stats.firstY = span.firstY;
+      stats.lastY = span.lastY;
+      stats.meanY = (stats.minY + stats.maxY) / 2.0;
+      stats.count = count;
+    }
+    clampToLogAxis(series, columns);
+    return;
+  }
+
+  aggregateHistory(series, plotWidth, columns);
+
+  // In-memory points: one linear pass, binning each sample by its x (the
+  // cached log10 of it on a log axis)
+  const double columnsPerX = plotWidth / xRange;
+  const bool cachedX =
+      m_xLogScale && series.logX.size() == series.points.size();
+  int runStart = 0;
+  for (int run = 0; run < 2; ++run) {
+    int length = 0;
+    const QPointF *points = series.points.run(run, length);
+    for (int i = 0; i < length; ++i) {
+      const double x = cachedX ? series.logX.at(runStart + i)
+                               : layoutValue(points[i].x(), m_xLogScale);
+      const double position = (x - xMin) * columnsPerX;
+      if (!(position >= 0.0 && position < plotWidth))
+        continue;
+
+      ColumnStats &stats = columns[int(position)];
+      const double y = points[i].y();
+      if (stats.count == 0) {
+        stats.firstY = stats.minY = stats.maxY = y;
+      } else {
+        stats.minY = qMin(stats.minY, y);
+        stats.maxY = qMax(stats.maxY, y);
+      }
+      stats.lastY = y;
+      stats.meanY += y;
+      ++stats.count;
+    }
+    runStart += length;
+  }
+  for (ColumnStats &stats : columns) {
+    if (stats.count > 0) {
+      stats.meanY /= stats.count;
+    }
+  }
+  clampToLogAxis(series, columns);
+}
+
+void XYChartWidget::clampToLogAxis(const DataSeries &series,
+                                   QVector<ColumnStats> &columns) const {
+  auto axis = m_yAxes.constFind(series.yAxisId);
+  if (axis == m_yAxes.constEnd() || !axis->logScale)
+    return;
+
+  // Column values <= 0 cannot be placed on a log axis: spans reaching them
+  // are cut at the axis minimum, columns entirely below zero are dropped
+  const double floor = axis->min;
+  for (ColumnStats &stats : columns) {
+    if (stats.count == 0)
+      continue;
+    if (!(stats.maxY > 0.0)) {
+      stats.count = 0;
+      continue;
+    }
+    stats.minY = stats.minY > 0.0 ? stats.minY : floor;
+    stats.firstY = stats.firstY > 0.0 ? stats.firstY : floor;
+    stats.lastY = stats.lastY > 0.0 ? stats.lastY : floor;
+    stats.meanY = stats.meanY > 0.0 ? stats.meanY : floor;
+  }
+}
+
+void XYChartWidget::aggregateHistory(const DataSeries &series, int plotWidth,
+                                     QVector<ColumnStats> &columns) const {
+  const double xMin = layoutValue(m_xMin, m_xLogScale);
+  const double xRange = layoutValue(m_xMax, m_xLogScale) - xMin;
+  if (series.history.isEmpty() || plotWidth <= 0 || !(xRange > 0.0))
+    return;
+
+  // Buckets land in the column of their centre; meanY collects sums until
+  // the caller divides by count
+  const double columnsPerX = plotWidth / xRange;
+  auto add = [&](const HistoryBucket &bucket) {
+    if (bucket.count == 0 || bucket.xLast < m_xMin || bucket.xFirst > m_xMax)
+      return;
+    const double centre =
+        layoutValue((bucket.xFirst + bucket.xLast) / 2.0, m_xLogScale);
+    if (!std::isfinite(centre))
+      return;
+    const int column =
+        qBound(0, int((centre - xMin) * columnsPerX), plotWidth - 1);
+
+    ColumnStats &stats = columns[column];
+    if (stats.count == 0) {
+      stats.firstY = bucket.meanY();
+      stats.minY = bucket.minY;
+      stats.maxY = bucket.maxY;
+    } else {
+      stats.minY = qMin(stats.minY, bucket.minY);
+      stats.maxY = qMax(stats.maxY, bucket.maxY);
+    }
+    stats.lastY = bucket.meanY();
+    stats.meanY += bucket.sumY;
+    stats.count += bucket.count;
+  };
+
+  // Oldest first: coarsest tier down to the partial bucket
+  const TieredHistory &history = series.history;
+  for (int t = TieredHistory::TierCount - 1; t >= 0; --t) {
+    for (const HistoryBucket &bucket : history.tier(t)) {
+      add(bucket);
+    }
+  }
+  add(history.partialBucket());
+}
+
+void XYChartWidget::drawHistory(QPainter &painter, const DataSeries &series) {
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  QVector<ColumnStats> columns(qMax(plotWidth, 0));
+  aggregateHistory(series, plotWidth, columns);
+  clampToLogAxis(series, columns);
+
+  // Same first/min/max/last shape as decimated source series
+  QVector<QPointF> widgetPoints;
+  for (int column = 0; column < columns.size(); ++column) {
+    const ColumnStats &stats = columns[column];
+    if (stats.count == 0)
+      continue;
+
+    const double x = m_leftMargin + column + 0.5;
+    const int axisId = series.yAxisId;
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.firstY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.minY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.maxY), axisId).y()));
+    widgetPoints.append(
+        QPointF(x, mapToWidget(QPointF(0.0, stats.lastY), axisId).y()));
+  }
+  if (widgetPoints.isEmpty())
+    return;
+
+  // Join up with the raw window
+  if (!series.points.isEmpty()) {
+    const QPointF first = mapToWidget(series.points.first(), series.yAxisId);
+    if (isFinitePoint(first)) {
+      widgetPoints.append(first);
+    }
+  }
+
+  painter.setPen(seriesPen(series));
+  painter.drawPolyline(widgetPoints.constData(), widgetPoints.size());
+}
+
+void XYChartWidget::drawEnvelopeSeries(QPainter &painter, DataSeries &series) {
+  const int plotWidth = width() - m_leftMargin - m_rightMargin;
+  QVector<ColumnStats> columns;
+  aggregateColumns(series, plotWidth, columns);
+
+  QPointF scale;
+  QPointF offset;
+  layoutTransform(series.yAxisId, scale, offset);
+  const bool yLog = isAxisLogScale(series.yAxisId);
+  auto columnY = [&](double y) {
+    return offset.y() + layoutValue(y, yLog) * scale.y();
+  };
+
+  // Each run of non-empty columns becomes one closed band: maxima left to
+  // right, then minima back. Everything is filled in a single call.
+  QPainterPath band;
+  QPainterPath meanLine;
+  QPolygonF outline;
+  int column = 0;
+  while (column < columns.size()) {
+    if (columns[column].count == 0) {
+      ++column;
+      continue;
+    }
+
+    int runEnd = column;
+    while (runEnd < columns.size() && columns[runEnd].count > 0) {
+      ++runEnd;
+    }
+
+    outline.clear();
+    for (int c = column; c < runEnd; ++c) {
+      const double x = m_leftMargin + c + 0.5;
+      outline.append(QPointF(x, columnY(columns[c].maxY)));
+      const QPointF mean(x, columnY(columns[c].meanY));
+      if (c == column) {
+        meanLine.moveTo(mean);
+      } else {
+        meanLine.lineTo(mean);
+      }
+    }
+    for (int c = runEnd - 1; c >= column; --c) {
+      outline.append(QPointF(m_leftMargin + c + 0.5, columnY(columns[c].minY)));
+    }
+    band.addPolygon(outline);
+    band.closeSubpath();
+    column = runEnd;
+  }
+
+  QColor fill = series.color;
+  fill.setAlpha(70);
+  painter.fillPath(band, fill);
+
+  painter.setPen(seriesPen(series));
+  painter.setBrush(Qt::NoBrush);
+  painter.drawPath(meanLine);
+}
+
+
+QString XYChartWidget::legendStatisticsText(DataSeries &series) {
+  SeriesStatistics &statistics = series.legendStatistics;
+  if (!statistics.isValid()) {
+    // One full pass; from here on the ingestion path keeps it current
+    statistics.clear();
+    if (!series.source.isNull()) {
+      QVector<QPointF> chunk(ReadChunkPoints);
+      const qint64 count = series.source->count();
+      for (qint64 index = 0; index < count; index += chunk.size()) {
+        const int n = int(series.source->readPoints(index, chunk.size(),
+                                                    chunk.data()));
+        statistics.append(chunk.constData(), n);
+      }
+    } else {
+      for (int run = 0; run < 2; ++run) {
+        int length = 0;
+        const QPointF *points = series.points.run(run, length);
+        statistics.append(points, length);
       }
     }
   }
+  if (statistics.count() == 0) {
+    return QString("-");
+  }
+
+  // Sample rate in samples per x unit over the raw window
+  double xFirst = 0.0;
+  double xLast = 0.0;
+  if (!series.source.isNull()) {
+    series.source->xRange(xFirst, xLast);
+  } else {
+    xFirst = series.points.first().x();
+    xLast = series.points.last().x();
+  }
+  const double rate =
+      xLast > xFirst ? (statistics.count() - 1) / (xLast - xFirst) : 0.0;
+
+  return QString("last %1  min %2  max %3  mean %4  sd %5  rate %6")
+      .arg(statistics.last(), 0, 'g', 4)
+      .arg(statistics.min(), 0, 'g', 4)
+      .arg(statistics.max(), 0, 'g', 4)
+      .arg(statistics.mean(), 0, 'g', 4)
+      .arg(statistics.standardDeviation(), 0, 'g', 4)
+      .arg(rate, 0, 'g', 4);
 }
 
 void XYChartWidget::drawLegend(QPainter &painter) {
-  int legendX = width() - m_rightMargin - 200;
+  int legendWidth = 200;
   int legendY = m_topMargin + 10;
   int lineHeight = 20;
 
+  // Optional statistics line under each name, in a smaller font
+  QFont statisticsFont = painter.font();
+  statisticsFont.setPointSize(8);
+  const QFontMetrics statisticsMetrics(statisticsFont);
+  const int statisticsHeight =
+      m_legendStatisticsVisible ? statisticsMetrics.height() : 0;
+  QStringList statisticsLines;
+  if (m_legendStatisticsVisible) {
+    for (auto &series : m_series) {
+      if (!series.visible)
+        continue;
+      statisticsLines.append(legendStatisticsText(series));
+      legendWidth = qMax(legendWidth,
+                         45 + statisticsMetrics.width(statisticsLines.last()));
+    }
+  }
+  const int rowHeight = lineHeight + statisticsHeight;
+  int legendX = width() - m_rightMargin - legendWidth;
+
   // Legend colors based on dark mode
   QColor bgColor =
       m_darkModeEnabled ? QColor(50, 50, 50, 200) : QColor(255, 255, 255, 200);
@@ -880,23 +3350,40 @@ void XYChartWidget::drawLegend(QPainter &painter) {
   if (visibleCount == 0)
     return;
 
-  painter.drawRect(legendX - 5, legendY - 5, 200,
-                   visibleCount * lineHeight + 5);
+  painter.drawRect(legendX - 5, legendY - 5, legendWidth,
+                   visibleCount * rowHeight + 5);
 
   int i = 0;
   for (const auto &series : m_series) {
     if (!series.visible)
       continue;
 
-    // Draw colored line
-    painter.setPen(series.pen);
-    painter.drawLine(legendX, legendY + i * lineHeight + 10, legendX + 30,
-                     legendY + i * lineHeight + 10);
+    // Draw colored line, or the marker for scatter series
+    const int rowY = legendY + i * rowHeight;
+    if (series.lineVisible || series.markerShape == NoMarker) {
+      painter.setPen(series.pen);
+      painter.drawLine(legendX, rowY + 10, legendX + 30, rowY + 10);
+    } else {
+      const int size = qMin(series.markerSize, lineHeight - 4);
+      MarkerSprite::paint(painter, series.markerShape,
+                          QRectF(legendX + 15 - size / 2.0,
+                                 rowY + 10 - size / 2.0, size, size),
+                          series.color);
+    }
 
     // Draw name
     painter.setPen(textColor);
-    painter.drawText(legendX + 35, legendY + i * lineHeight, 150, lineHeight,
-                     Qt::AlignVCenter, series.name);
+    painter.drawText(legendX + 35, rowY, 150, lineHeight, Qt::AlignVCenter,
+                     series.name);
+
+    if (m_legendStatisticsVisible) {
+      const QFont nameFont = painter.font();
+      painter.setFont(statisticsFont);
+      painter.drawText(legendX + 35, rowY + lineHeight - 2,
+                       legendWidth - 40, statisticsHeight, Qt::AlignVCenter,
+                       statisticsLines.at(i));
+      painter.setFont(nameFont);
+    }
     i++;
   }
 }
@@ -958,12 +3445,231 @@ void XYChartWidget::drawCrosshair(QPainter &painter) {
   drawCrosshairTextBox(painter, m_crosshairPos, lines);
 }
 
+void XYChartWidget::drawMeasurementCursors(QPainter &painter) {
+  const int plotLeft = m_leftMargin;
+  const int plotRight = width() - m_rightMargin;
+  const int plotTop = m_topMargin;
+  const int plotBottom = height() - m_bottomMargin;
+
+  const QColor cursorColor = m_darkModeEnabled ? QColor(255, 170, 60)
+                                               : QColor(230, 120, 0);
+  int rightmost = plotLeft;
+  for (int i = 0; i < 2; ++i) {
+    const int x = int(mapToWidget(QPointF(m_cursorX[i], 0.0), 0).x());
+    if (x < plotLeft || x > plotRight) {
+      continue;
+    }
+    painter.setPen(QPen(cursorColor, 1, Qt::DashDotLine));
+    painter.drawLine(x, plotTop, x, plotBottom);
+    painter.drawText(x + 3, plotTop + painter.fontMetrics().ascent(),
+                     QString::number(i + 1));
+    rightmost = qMax(rightmost, x);
+  }
+
+  QStringList lines;
+  lines.append(QString("dX: %1").arg(m_cursorX[1] - m_cursorX[0], 0, 'g', 6));
+  for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+    if (!it->visible)
+      continue;
+    const RangeSummary stats =
+        rangeStatistics(it.key(), m_cursorX[0], m_cursorX[1]);
+    if (stats.count == 0)
+      continue;
+    lines.append(QString("%1: min %2  max %3  mean %4  rms %5")
+                     .arg(it->name)
+                     .arg(stats.minY, 0, 'g', 6)
+                     .arg(stats.maxY, 0, 'g', 6)
+                     .arg(stats.mean(), 0, 'g', 6)
+                     .arg(stats.rms(), 0, 'g', 6));
+  }
+  drawCrosshairTextBox(painter, QPoint(rightmost, plotTop), lines);
+}
+
+void XYChartWidget::layoutAnnotations(const QFontMetrics &metrics) {
+  const int plotLeft = m_leftMargin;
+  const int plotRight = width() - m_rightMargin;
+  if (m_annotationRevision == m_annotations.revision() &&
+      m_annotationXMin == m_xMin && m_annotationXMax == m_xMax &&
+      m_annotationLeft == plotLeft && m_annotationRight == plotRight &&
+      m_annotationXLog == m_xLogScale) {
+    return;
+  }
+  m_annotationRevision = m_annotations.revision();
+  m_annotationXMin = m_xMin;
+  m_annotationXMax = m_xMax;
+  m_annotationLeft = plotLeft;
+  m_annotationRight = plotRight;
+  m_annotationXLog = m_xLogScale;
+
+  QVector<int> visible;
+  m_annotations.query(m_xMin, m_xMax, visible);
+
+  auto column = [&](double x) {
+    const double widgetX = mapToWidget(QPointF(x, 1.0)).x();
+    if (!(widgetX >= plotLeft))
+      return plotLeft;
+    return widgetX > plotRight ? plotRight : qRound(widgetX);
+  };
+
+  // Labels go into the first row where they clear the previous label;
+  // rowEnds holds the right edge of the last label in each row
+  QVector<int> rowEnds(AnnotationLabelRows, std::numeric_limits<int>::min());
+  m_annotationLayout.resize(0);
+  for (int index : visible) {
+    const Annotation &annotation = m_annotations.at(index);
+    PlacedAnnotation placed;
+    placed.index = index;
+    placed.left = column(annotation.start);
+    placed.right = column(annotation.end);
+    placed.labelRow = -1;
+    placed.labelWidth = 0;
+
+    // Dense events land on the same pixels; each extent is drawn once
+    if (!m_annotationLayout.isEmpty() &&
+        m_annotationLayout.last().left == placed.left &&
+        m_annotationLayout.last().right == placed.right)
+      continue;
+
+    if (!annotation.label.isEmpty()) {
+      placed.labelWidth = metrics.width(annotation.label);
+      const int labelLeft = placed.left + 3;
+      for (int row = 0; row < rowEnds.size(); ++row) {
+        if (rowEnds[row] < labelLeft) {
+          placed.labelRow = row;
+          rowEnds[row] = labelLeft + placed.labelWidth + 4;
+          break;
+        }
+      }
+    }
+    m_annotationLayout.append(placed);
+  }
+}
+
+void XYChartWidget::drawAnnotations(QPainter &painter) {
+  if (m_annotations.count() == 0)
+    return;
+
+  painter.save();
+  QFont labelFont = painter.font();
+  labelFont.setPointSize(8);
+  painter.setFont(labelFont);
+  const QFontMetrics metrics = painter.fontMetrics();
+  layoutAnnotations(metrics);
+
+  const int plotTop = m_topMargin;
+  const int plotBottom = height() - m_bottomMargin;
+  const QColor defaultColor =
+      m_darkModeEnabled ? QColor(120, 200, 255) : QColor(0, 110, 200);
+  for (const PlacedAnnotation &placed : m_annotationLayout) {
+    const Annotation &annotation = m_annotations.at(placed.index);
+    const QColor color =
+        annotation.color.isValid() ? annotation.color : defaultColor;
+
+    if (placed.right > placed.left) {
+      QColor fill = color;
+      fill.setAlpha(40);
+      painter.fillRect(placed.left, plotTop, placed.right - placed.left,
+                       plotBottom - plotTop, fill);
+    }
+    // Edges cut off by the view are not drawn at the plot border
+    painter.setPen(QPen(color, 1));
+    if (annotation.start >= m_xMin) {
+      painter.drawLine(placed.left, plotTop, placed.left, plotBottom);
+    }
+    if (placed.right > placed.left && annotation.end <= m_xMax) {
+      painter.drawLine(placed.right, plotTop, placed.right, plotBottom);
+    }
+
+    if (placed.labelRow >= 0) {
+      painter.drawText(placed.left + 3,
+                       plotTop + metrics.ascent() +
+                           placed.labelRow * metrics.height(),
+                       annotation.label);
+    }
+  }
+  painter.restore();
+}
+
+void XYChartWidget::drawThreshold(QPainter &painter,
+                                  const DataSeries &series) {
+  const ThresholdMonitor &monitor = *series.threshold;
+  const int plotLeft = m_leftMargin;
+  const int plotRight = width() - m_rightMargin;
+  const int plotTop = m_topMargin;
+  const int plotBottom = height() - m_bottomMargin;
+
+  auto column = [&](double x) {
+    const double widgetX = mapToWidget(QPointF(x, 1.0), series.yAxisId).x();
+    if (!(widgetX >= plotLeft))
+      return plotLeft;
+    return widgetX > plotRight ? plotRight : qRound(widgetX);
+  };
+
+  // Violation regions in view, merged where they touch on screen so the
+  // shade does not darken where many short ones overlap
+  QColor shade = monitor.color();
+  shade.setAlpha(50);
+  int spanLeft = 0;
+  int spanRight = -1;
+  auto shadeRegion = [&](const ViolationRegion &region) {
+    const int left = column(region.start);
+    const int right = column(region.end);
+    if (spanRight >= 0 && left <= spanRight + 1) {
+      spanRight = qMax(spanRight, right);
+      return;
+    }
+    if (spanRight >= 0) {
+      painter.fillRect(spanLeft, plotTop, spanRight - spanLeft + 1,
+                       plotBottom - plotTop, shade);
+    }
+    spanLeft = left;
+    spanRight = right;
+  };
+
+  // Closed regions are in x order: skip those ending before the view
+  const RingBuffer<ViolationRegion> &regions = monitor.regions();
+  int first = 0;
+  int last = regions.size();
+  while (first < last) {
+    const int middle = (first + last) / 2;
+    if (regions.at(middle).end < m_xMin) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  for (int i = first; i < regions.size() && regions.at(i).start <= m_xMax;
+       ++i) {
+    shadeRegion(regions.at(i));
+  }
+  if (monitor.isViolating()) {
+    const ViolationRegion open = monitor.openRegion();
+    if (open.end >= m_xMin && open.start <= m_xMax) {
+      shadeRegion(open);
+    }
+  }
+  if (spanRight >= 0) {
+    painter.fillRect(spanLeft, plotTop, spanRight - spanLeft + 1,
+                     plotBottom - plotTop, shade);
+  }
+
+  // Limit lines; infinite limits (one-sided bands) are not drawn
+  painter.setPen(QPen(monitor.color(), 1, Qt::DashLine));
+  const double limits[2] = {monitor.lower(), monitor.upper()};
+  for (const double limit : limits) {
+    const double y = mapToWidget(QPointF(m_xMin, limit), series.yAxisId).y();
+    if (std::isfinite(y) && y >= plotTop && y <= plotBottom) {
+      painter.drawLine(QPointF(plotLeft, y), QPointF(plotRight, y));
+    }
+  }
+}
+
 void XYChartWidget::autoGroupSeriesToAxes() {
   if (!m_multiAxisEnabled || m_series.isEmpty()) {
     return;
   }
 
-  // Clear all axis assignments (except axis 0)
+  // Clear all axis assignments
   for (auto it = m_yAxes.begin(); it != m_yAxes.end(); ++it) {
     it.value().seriesNames.clear();
   }
@@ -971,21 +3677,189 @@ void XYChartWidget::autoGroupSeriesToAxes() {
   // If auto-grouping disabled or only one series, assign all to axis 0
   if (!m_autoGroupSeries || m_series.size() <= 1) {
     for (auto it = m_series.begin(); it != m_series.end(); ++it) {
-      it.value().yAxisId = 0;
+      DataSeries &series = it.value();
+      series.yAxisId = 0;
+      // Remember the measured range so a lone streaming series does not
+      // regroup on every append
+      const SeriesExtent &extent = extentOf(series);
+      if (extent.valid) {
+        seriesLogRange(extent, series.groupedLogMin, series.groupedLogMax);
+      } else {
+        series.groupedLogMin = std::numeric_limits<double>::quiet_NaN();
+        series.groupedLogMax = std::numeric_limits<double>::quiet_NaN();
+      }
       m_yAxes[0].seriesNames.append(it.key());
     }
+    for (int axisId : m_autoCreatedAxes) {
+      m_yAxes.remove(axisId);
+    }
+    m_autoCreatedAxes.clear();
     calculateAutoScaleForAxis(0);
+    updateMargins();
     return;
   }
 
-  // Simple grouping: use first axis for all series
-  // (Full clustering algorithm can be added later)
+  // Series ordered by the centre of their log range; series without data
+  // keep their axis
+  struct GroupedSeries {
+    double logMin;
+    double logMax;
+    QString name;
+  };
+  QVector<GroupedSeries> ordered;
+  QStringList pending;
   for (auto it = m_series.begin(); it != m_series.end(); ++it) {
-    it.value().yAxisId = 0;
-    m_yAxes[0].seriesNames.append(it.key());
+    const SeriesExtent &extent = extentOf(it.value());
+    if (extent.valid) {
+      GroupedSeries grouped;
+      seriesLogRange(extent, grouped.logMin, grouped.logMax);
+      grouped.name = it.key();
+      ordered.append(grouped);
+    } else {
+      pending.append(it.key());
+    }
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const GroupedSeries &a, const GroupedSeries &b) {
+              const double centreA = a.logMin + a.logMax;
+              const double centreB = b.logMin + b.logMax;
+              return centreA != centreB ? centreA < centreB : a.name < b.name;
+            });
+
+  // A series joins the current cluster while its range overlaps the
+  // cluster's by at least the threshold. Ranges are widened to 'width'
+  // decades first so that, at a threshold of 0.3, two constant-magnitude
+  // series still share an axis when their peaks are within ~3.3x.
+  struct Cluster {
+    int first;
+    int last;
+    double logMin;
+    double logMax;
+  };
+  const double threshold = qBound(1e-6, m_groupingThreshold, 0.999);
+  const double width =
+      -std::log10(threshold) * (1.0 + threshold) / (1.0 - threshold);
+  QVector<Cluster> clusters; // [first, last] into ordered
+  for (int i = 0; i < ordered.size(); ++i) {
+    const GroupedSeries &grouped = ordered[i];
+    if (!clusters.isEmpty() &&
+        logRangeOverlap(clusters.last().logMin, clusters.last().logMax,
+                        grouped.logMin, grouped.logMax, width) >= threshold) {
+      Cluster &cluster = clusters.last();
+      cluster.last = i;
+      cluster.logMin = qMin(cluster.logMin, grouped.logMin);
+      cluster.logMax = qMax(cluster.logMax, grouped.logMax);
+    } else {
+      Cluster cluster = {i, i, grouped.logMin, grouped.logMax};
+      clusters.append(cluster);
+    }
   }
 
-  calculateAutoScaleForAxis(0);
+  // Too many clusters: merge the neighbours whose ranges overlap most
+  const int maxAxes = qMax(m_maxYAxes, 1);
+  while (clusters.size() > maxAxes) {
+    int best = 0;
+    double bestOverlap = -1.0;
+    double bestGap = std::numeric_limits<double>::max();
+    for (int c = 0; c + 1 < clusters.size(); ++c) {
+      const double overlap =
+          logRangeOverlap(clusters[c].logMin, clusters[c].logMax,
+                          clusters[c + 1].logMin, clusters[c + 1].logMax,
+                          width);
+      const double gap = clusters[c + 1].logMin - clusters[c].logMax;
+      if (overlap > bestOverlap || (overlap == bestOverlap && gap < bestGap)) {
+        bestOverlap = overlap;
+        bestGap = gap;
+        best = c;
+      }
+    }
+    clusters[best].last = clusters[best + 1].last;
+    clusters[best].logMin =
+        qMin(clusters[best].logMin, clusters[best + 1].logMin);
+    clusters[best].logMax =
+        qMax(clusters[best].logMax, clusters[best + 1].logMax);
+    clusters.remove(best + 1);
+  }
+
+  // Largest clusters pick first, each keeping the axis most of its members
+  // are already on so streaming updates do not shuffle axes
+  QVector<int> clusterOrder(clusters.size());
+  for (int c = 0; c < clusters.size(); ++c) {
+    clusterOrder[c] = c;
+  }
+  std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                   [&clusters](int a, int b) {
+                     return clusters[a].last - clusters[a].first >
+                            clusters[b].last - clusters[b].first;
+                   });
+
+  QSet<int> usedAxes;
+  for (int c : clusterOrder) {
+    QMap<int, int> votes;
+    for (int i = clusters[c].first; i <= clusters[c].last; ++i) {
+      int axisId = m_series[ordered[i].name].yAxisId;
+      if (m_yAxes.contains(axisId) && !usedAxes.contains(axisId)) {
+        ++votes[axisId];
+      }
+    }
+
+    int axisId = -1;
+    for (auto it = votes.constBegin(); it != votes.constEnd(); ++it) {
+      if (axisId < 0 || it.value() > votes.value(axisId)) {
+        axisId = it.key();
+      }
+    }
+    if (axisId < 0) {
+      for (auto it = m_yAxes.constBegin(); it != m_yAxes.constEnd(); ++it) {
+        if (!usedAxes.contains(it.key())) {
+          axisId = it.key();
+          break;
+        }
+      }
+    }
+    if (axisId < 0) {
+      axisId = m_nextAxisId;
+      Qt::AlignmentFlag side = countAxesOnSide(Qt::AlignLeft) <=
+                                       countAxesOnSide(Qt::AlignRight)
+                                   ? Qt::AlignLeft
+                                   : Qt::AlignRight;
+      createYAxis(axisId, ordered[clusters[c].first].name, side);
+      m_autoCreatedAxes.append(axisId);
+    }
+    usedAxes.insert(axisId);
+
+    YAxisInfo &axis = m_yAxes[axisId];
+    for (int i = clusters[c].first; i <= clusters[c].last; ++i) {
+      DataSeries &series = m_series[ordered[i].name];
+      series.yAxisId = axisId;
+      series.groupedLogMin = ordered[i].logMin;
+      series.groupedLogMax = ordered[i].logMax;
+      axis.seriesNames.append(series.name);
+    }
+    axis.color = m_series[ordered[clusters[c].first].name].color;
+  }
+
+  for (const QString &seriesName : pending) {
+    DataSeries &series = m_series[seriesName];
+    if (!m_yAxes.contains(series.yAxisId)) {
+      series.yAxisId = 0;
+    }
+    m_yAxes[series.yAxisId].seriesNames.append(seriesName);
+  }
+
+  // Drop axes this function created that are no longer needed
+  for (int i = m_autoCreatedAxes.size() - 1; i >= 0; --i) {
+    int axisId = m_autoCreatedAxes[i];
+    if (m_yAxes.value(axisId).seriesNames.isEmpty()) {
+      m_yAxes.remove(axisId);
+      m_autoCreatedAxes.removeAt(i);
+    }
+  }
+
+  for (auto it = m_yAxes.begin(); it != m_yAxes.end(); ++it) {
+    calculateAutoScaleForAxis(it.key());
+  }
+  updateMargins();
 }
 
 void XYChartWidget::calculateAutoScaleForAxis(int axisId) {
@@ -999,32 +3873,42 @@ void XYChartWidget::calculateAutoScaleForAxis(int axisId) {
   }
 
   if (axis.seriesNames.isEmpty()) {
-    axis.min = 0.0;
+    axis.min = axis.logScale ? 1.0 : 0.0;
     axis.max = 10.0;
     return;
   }
 
+  // Fitted in layout space, so a log axis gets its margin in decades
   bool firstPoint = true;
-  double minVal = 0.0, maxVal = 10.0;
+  double minVal = 0.0, maxVal = axis.logScale ? 1.0 : 10.0;
 
   for (const QString &seriesName : axis.seriesNames) {
     if (!m_series.contains(seriesName)) {
       continue;
     }
 
-    const DataSeries &series = m_series[seriesName];
-    if (!series.visible || series.points.isEmpty()) {
+    DataSeries &series = m_series[seriesName];
+    if (!series.visible) {
       continue;
     }
 
-    for (const QPointF &point : series.points) {
-      if (firstPoint) {
-        minVal = maxVal = point.y();
-        firstPoint = false;
-      } else {
-        minVal = qMin(minVal, point.y());
-        maxVal = qMax(maxVal, point.y());
-      }
+    const SeriesExtent &extent = extentOf(series);
+    if (!extent.valid) {
+      continue;
+    }
+
+    double seriesMin = extent.yMin, seriesMax = extent.yMax;
+    if (axis.logScale && !logExtent(series, false, seriesMin, seriesMax)) {
+      continue;
+    }
+
+    if (firstPoint) {
+      minVal = seriesMin;
+      maxVal = seriesMax;
+      firstPoint = false;
+    } else {
+      minVal = qMin(minVal, seriesMin);
+      maxVal = qMax(maxVal, seriesMax);
     }
   }
 
@@ -1034,8 +3918,8 @@ void XYChartWidget::calculateAutoScaleForAxis(int axisId) {
     range = 1.0;
   }
 
-  axis.min = minVal - range * 0.05;
-  axis.max = maxVal + range * 0.05;
+  axis.min = axisValue(minVal - range * 0.05, axis.logScale);
+  axis.max = axisValue(maxVal + range * 0.05, axis.logScale);
 }
 
 int XYChartWidget::calculateAxisPosition(const YAxisInfo &axis) const {
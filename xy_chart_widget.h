@@ -8,6 +8,29 @@
 #include <QPen>
 #include <QString>
 #include <QMap>
+#include <QSharedPointer>
+#include <QImage>
+#include "annotation_layer.h"
+#include "compressed_series.h"
+#include "density_raster.h"
+#include "derived_series.h"
+#include "log_column.h"
+#include "marker_sprite.h"
+#include "persistence_buffer.h"
+#include "range_statistics.h"
+#include "render_quality_governor.h"
+#include "ring_buffer.h"
+#include "sample_series.h"
+#include "series_statistics.h"
+#include "series_data_source.h"
+#include "shared_ring_source.h"
+#include "threshold_monitor.h"
+#include "tiered_history.h"
+#include "trigger_engine.h"
+#include <limits>
+
+class QFontMetrics;
+class QTimer;
 
 struct YAxisInfo {
     int axisId;
@@ -18,20 +41,118 @@ struct YAxisInfo {
     Qt::AlignmentFlag side;
     QStringList seriesNames;
     bool autoScale;
+    // log10 scale; min and max stay positive
+    bool logScale;
 
     YAxisInfo() : axisId(0), min(0.0), max(10.0),
-                  color(Qt::black), side(Qt::AlignLeft), autoScale(true) {}
+                  color(Qt::black), side(Qt::AlignLeft), autoScale(true),
+                  logScale(false) {}
+};
+
+// Cached bounding box of a series. Kept up to date on append and only
+// rescanned when an evicted point may have been an extremum; while x is
+// sorted the x extent is read from the first and last point.
+struct SeriesExtent {
+    double xMin, xMax;
+    double yMin, yMax;
+    bool valid;
+    bool xSorted;
+
+    SeriesExtent() : xMin(0.0), xMax(0.0), yMin(0.0), yMax(0.0),
+                     valid(false), xSorted(true) {}
+};
+
+// How a series is drawn. LineMode is the classic line (plus markers);
+// DensityMode bins the points into a per-pixel histogram and draws it as a
+// colour-mapped image, for heavily overplotted data; PersistenceMode
+// overlays successive sweeps in a fading phosphor buffer; EnvelopeMode
+// fills the min/max band of each pixel column under a mean line.
+enum SeriesRenderMode {
+    LineMode,
+    DensityMode,
+    PersistenceMode,
+    EnvelopeMode
+};
+
+// Samples falling into one pixel column of the plot
+struct ColumnStats {
+    double firstY, lastY;
+    double minY, maxY;
+    double meanY;
+    qint64 count;
+
+    ColumnStats() : firstY(0.0), lastY(0.0), minY(0.0), maxY(0.0),
+                    meanY(0.0), count(0) {}
+};
+
+// Bytes held by one series, by layer
+struct SeriesMemoryUsage {
+    qint64 points;      // raw sample window
+    qint64 compressed;  // encoded blocks (setSeriesCompressed)
+    qint64 index;       // search structures: block headers, overview levels
+    qint64 history;     // min/max/mean tiers
+    qint64 caches;      // render buffers, marker sprite, decoded blocks
+
+    SeriesMemoryUsage() : points(0), compressed(0), index(0), history(0),
+                          caches(0) {}
+    qint64 total() const {
+        return points + compressed + index + history + caches;
+    }
 };
 
 struct DataSeries {
     QString name;
-    QVector<QPointF> points;
+    // Bounded to setMaxPointsPerSeries() as a ring, otherwise a plain vector
+    RingBuffer<QPointF> points;
     QColor color;
     QPen pen;
     bool visible;
     int yAxisId;
+    // External storage rendered instead of points (e.g. MappedSeriesFile)
+    QSharedPointer<SeriesDataSource> source;
+    SeriesExtent extent;
+    // log10 |y| range [min, max] when auto-grouping last placed this series
+    double groupedLogMin;
+    double groupedLogMax;
+    // Point markers; the sprite is re-rendered only when the style changes
+    MarkerShape markerShape;
+    int markerSize;
+    bool lineVisible;
+    MarkerSprite markerSprite;
+    SeriesRenderMode renderMode;
+    DensityRaster densityRaster;
+    PersistenceBuffer persistence;
+    int persistenceHalfLifeMs;
+    // Total samples ever added, so incremental renderers can find new data
+    qint64 samplesAppended;
+    // Points evicted from the bounded window, kept at coarser resolution
+    TieredHistory history;
+    // Compressed storage; also installed as the source while enabled
+    QSharedPointer<CompressedSeries> compressed;
+    // Raw acquisition samples; also installed as the source while set
+    QSharedPointer<SampleSource> samples;
+    // Ring written by another process; also installed as the source
+    QSharedPointer<SharedRingSource> sharedRing;
+    // Block tree over y for cursor measurements, synchronized on demand
+    RangeStatistics statistics;
+    // Running last/min/max/mean/std-dev for the legend, maintained only
+    // while the legend shows them
+    SeriesStatistics legendStatistics;
+    // Set on a series computed from another one (see addDerivedSeries)
+    QSharedPointer<DerivedSeries> derivation;
+    // Alarm band checked as samples arrive (see setSeriesThreshold)
+    QSharedPointer<ThresholdMonitor> threshold;
+    // log10 of the points while their axis is logarithmic
+    LogColumn logX;
+    LogColumn logY;
 
-    DataSeries() : visible(true), yAxisId(0) {
+    DataSeries() : visible(true), yAxisId(0),
+                   groupedLogMin(std::numeric_limits<double>::quiet_NaN()),
+                   groupedLogMax(std::numeric_limits<double>::quiet_NaN()),
+                   markerShape(CircleMarker), markerSize(6), lineVisible(true),
+                   renderMode(LineMode), persistenceHalfLifeMs(500),
+                   samplesAppended(0), logX(LogColumn::X),
+                   logY(LogColumn::Y) {
         pen.setWidth(2);
     }
 };
@@ -53,10 +174,63 @@ public:
     
     // Thêm nhiều điểm cùng lúc
     void addPoints(const QString &seriesName, const QVector<QPointF> &points);
+    void addPoints(const QString &seriesName, QVector<QPointF> &&points);
     
     // Cập nhật toàn bộ dữ liệu của series
     void setSeriesData(const QString &seriesName, const QVector<QPointF> &points);
+    void setSeriesData(const QString &seriesName, QVector<QPointF> &&points);
+
+    // Zero-copy: display external memory in place (see BufferDataSource).
+    // 'release' is called once the chart no longer references the buffer.
+    void setSeriesData(const QString &seriesName, const QPointF *points,
+                       qint64 count,
+                       const std::function<void()> &release =
+                           std::function<void()>());
+    void setSeriesData(const QString &seriesName, const double *y,
+                       qint64 count, double x0, double dx,
+                       const std::function<void()> &release =
+                           std::function<void()>());
     
+    // Reserve storage up front when the final point count is known
+    void reserveSeries(const QString &seriesName, int capacity);
+
+    // Render a series straight from external storage, without copying it
+    void setSeriesSource(const QString &seriesName,
+                         const QSharedPointer<SeriesDataSource> &source);
+
+    // Render a series in place from a shared-memory ring that another
+    // process fills through SharedRingWriter. The ring is polled every
+    // pollMs; each poll processes only the samples published since the
+    // last one. False if 'key' names no valid ring.
+    bool attachSharedRing(const QString &seriesName, const QString &key,
+                          int pollMs = 10);
+
+    // Keep a series' points in compressed blocks (a few bytes per point for
+    // regularly sampled data) instead of 16 bytes each. Appending works as
+    // usual; the series is unbounded while compressed.
+    void setSeriesCompressed(const QString &seriesName, bool enabled);
+
+    // Keep a series as raw int16/int32/float samples at x = x0 + index * dx
+    // (see SampleSeries); y = raw * gain + offset is applied only when the
+    // series is read for drawing. Replaces the series' data. addSamples()
+    // creates a series of its sample type if the name is new.
+    void setSeriesSampleFormat(const QString &seriesName, SampleFormat format,
+                               double x0 = 0.0, double dx = 1.0);
+    void setSeriesScale(const QString &seriesName, double gain, double offset);
+    void addSamples(const QString &seriesName, const qint16 *samples, int count);
+    void addSamples(const QString &seriesName, const qint32 *samples, int count);
+    void addSamples(const QString &seriesName, const float *samples, int count);
+
+    // A series that follows 'sourceName': each update of the source feeds
+    // only its new samples through the operation (see DerivedSeries) and
+    // appends the result, or, for Spectrum, replaces the series with the
+    // amplitude spectrum once the worker thread has computed it. Derived
+    // series can themselves be sources. Removing the source leaves the
+    // derived series as plain data.
+    void addDerivedSeries(const QString &seriesName, const QString &sourceName,
+                          DerivedOperation operation, int length = 16,
+                          const QColor &color = QColor());
+
     // Xóa dữ liệu
     void clearSeries(const QString &seriesName);
     void clearAllSeries();
@@ -70,18 +244,67 @@ public:
     // Cài đặt màu sắc và độ dày đường
     void setSeriesColor(const QString &seriesName, const QColor &color);
     void setSeriesPenWidth(const QString &seriesName, int width);
+
+    // Point markers. Line series show them while there are no more points
+    // than plot pixels across; series without a line (scatter) always do.
+    void setSeriesMarker(const QString &seriesName, MarkerShape shape,
+                         int size = 6);
+    void setSeriesLineVisible(const QString &seriesName, bool visible);
+    // Upper bound on the points fed to marker drawing per frame
+    void setMarkerBudget(int maxPoints);
+
+    void setSeriesRenderMode(const QString &seriesName, SeriesRenderMode mode);
+    // Fade time of PersistenceMode: intensity halves every halfLifeMs
+    void setSeriesPersistence(const QString &seriesName, int halfLifeMs);
     
     // Cài đặt giới hạn trục
     void setXRange(double min, double max);
     void setYRange(double min, double max);
     void setAutoScale(bool enable);
+
+    // Logarithmic axes. log10 of in-memory points is cached per series as
+    // they arrive, so log axes draw and auto-scale at the cost of linear
+    // ones; values <= 0 are left out. setYLogScale() sets axis 0.
+    void setXLogScale(bool enabled);
+    bool isXLogScale() const;
+    void setYLogScale(bool enabled);
     
     // Cài đặt số lượng điểm tối đa (để giới hạn bộ nhớ cho realtime)
     void setMaxPointsPerSeries(int maxPoints);
+
+    // Instead of discarding points beyond setMaxPointsPerSeries(), keep them
+    // as min/max/mean buckets of growing span within a byte budget per
+    // series (0 discards them, the default). Drawing and auto-scale include
+    // the history.
+    void setHistoryBudget(qint64 bytesPerSeries);
+    void setSeriesHistoryBudget(const QString &seriesName, qint64 bytes);
+
+    // Memory accounting, in bytes
+    SeriesMemoryUsage seriesMemoryUsage(const QString &seriesName) const;
+    qint64 memoryUsage() const;
+
+    // Byte budget for all series of this chart (0 = none, the default).
+    // Checked when set and then at most every 100 ms while data arrives.
+    // Once past it, render caches of hidden series are dropped first, then
+    // the series holding the most samples are trimmed, oldest first, until
+    // every series is at or below an equal share of what must go. Trimmed
+    // points move to the history if it is enabled.
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+
+    // The same across every chart in the process (GUI thread only)
+    static void setGlobalMemoryBudget(qint64 bytes);
+    static qint64 globalMemoryBudget();
+    static qint64 globalMemoryUsage();
     
     // Cài đặt lưới và nhãn
     void setGridVisible(bool visible);
     void setAxisLabelsVisible(bool visible);
+    // Adds last, min, max, mean, std-dev and sample rate (samples per x
+    // unit) under each legend entry. Kept up to date as points are added
+    // and evicted, so drawing them never rescans the data.
+    void setLegendStatisticsVisible(bool visible);
+    bool isLegendStatisticsVisible() const;
     void setTitle(const QString &title);
     void setXLabel(const QString &label);
     void setYLabel(const QString &label);
@@ -94,6 +317,73 @@ public:
     void setCrosshairVisible(bool visible);
     bool isCrosshairVisible() const;
 
+    // Two draggable vertical cursors with a readout of delta-X and the
+    // min/max/mean/RMS of each visible series between them. Statistics
+    // come from a per-series block tree kept up to date as data arrives,
+    // so moving a cursor costs O(log N) even on very long series.
+    void setMeasurementCursorsVisible(bool visible);
+    bool isMeasurementCursorsVisible() const;
+    void setMeasurementCursors(double x1, double x2);
+    double measurementCursor(int index) const;
+
+    // Statistics of a series' raw samples with x in [x1, x2]; empty if the
+    // series is not sorted by x
+    RangeSummary rangeStatistics(const QString &seriesName, double x1,
+                                 double x2);
+
+    // Oscilloscope-style trigger on one series: each edge found in newly
+    // added samples (searched off the GUI thread) freezes the x range to
+    // the settings' window, placed so the edge sits at the pre-trigger
+    // fraction of it, until the next edge. Y keeps auto-scaling.
+    void setTrigger(const QString &seriesName, const TriggerSettings &settings);
+    void clearTrigger();
+
+    // Event annotations: vertical markers and spans over x with optional
+    // labels, kept in an interval tree so only those intersecting the
+    // visible x range are laid out and drawn. Labels are placed in rows
+    // that avoid overlaps once per change of the range, not every paint.
+    int addAnnotation(double x, const QString &label = QString(),
+                      const QColor &color = QColor());
+    int addAnnotationSpan(double xStart, double xEnd,
+                          const QString &label = QString(),
+                          const QColor &color = QColor());
+    bool removeAnnotation(int id);
+    void clearAnnotations();
+    int annotationCount() const;
+
+    // Alarm band on a series: samples are checked against [lower, upper]
+    // as they are added, the limits are drawn as dashed lines and the x
+    // ranges outside them shaded, and thresholdCrossed() reports each
+    // exit from and return into the band. Use -inf/+inf for a one-sided
+    // band; an invalid colour takes the series'. Points the series already
+    // holds are checked without signals.
+    void setSeriesThreshold(const QString &seriesName, double lower,
+                            double upper,
+                            const QColor &color = QColor(220, 40, 40));
+    void clearSeriesThreshold(const QString &seriesName);
+
+    // Mouse zoom and pan: the wheel zooms about the cursor (Shift: X only,
+    // Ctrl: Y only), a left drag pans, a right drag zooms to the dragged
+    // rectangle and a double click restores auto-scale. While the view is
+    // moving, the last rendered frame is scaled and shifted as a preview;
+    // the series are drawn exactly once it has been still for a moment.
+    void setZoomPanEnabled(bool enabled);
+    bool isZoomPanEnabled() const;
+
+    // New data repaints through the shared ChartUpdateScheduler, which
+    // coalesces updates of all charts into capped frames; charts with a
+    // higher priority are repainted first when frames run over budget
+    void setUpdatePriority(int priority);
+    int updatePriority() const;
+
+    // Frame time budget of the render quality governor: while data streams
+    // in or the view moves, frames over budget step rendering down (see
+    // RenderQuality) and cheap ones step it back up; a full quality frame
+    // is drawn once things have been idle briefly. 0 keeps full quality.
+    void setFrameTimeBudget(int ms);
+    int frameTimeBudget() const;
+    RenderQuality renderQuality() const;
+
     // Dark mode support
     void setDarkModeEnabled(bool enabled);
     bool isDarkModeEnabled() const;
@@ -101,6 +391,10 @@ public:
     // Multi-axis support
     void setMultiAxisEnabled(bool enabled);
     bool isMultiAxisEnabled() const;
+    // Series whose log10 |y| ranges overlap share an axis, at most four
+    // axes in all. A series crossing zero has no smallest |y| and is placed
+    // by its peak alone; a series is regrouped only once either end of its
+    // range drifts by more than half a decade.
     void setAutoGroupSeries(bool enabled);
     bool isAutoGroupEnabled() const;
     void createYAxis(int axisId, const QString &label, Qt::AlignmentFlag side);
@@ -108,15 +402,32 @@ public:
     int getAxisForSeries(const QString &seriesName) const;
     void setAxisRange(int axisId, double min, double max);
     void setAxisAutoScale(int axisId, bool enabled);
+    void setAxisLogScale(int axisId, bool enabled);
+    bool isAxisLogScale(int axisId) const;
 
 signals:
     void seriesClicked(const QString &seriesName, const QPointF &point);
+    // Emitted after a memory budget trimmed this chart's series
+    void memoryTrimmed(qint64 bytesReleased);
+    // A measurement cursor was moved
+    void measurementChanged(double x1, double x2);
+    // The trigger fired on an edge at x and the view was aligned to it
+    void triggered(double x);
+    // The view was zoomed or panned with the mouse
+    void viewChanged(double xMin, double xMax, double yMin, double yMax);
+    // A series left (violating) or returned into its threshold band; point
+    // is where its line crossed the limit
+    void thresholdCrossed(const QString &seriesName, const QPointF &point,
+                          bool violating);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
     void leaveEvent(QEvent *event) override;
     
 private:
@@ -129,14 +440,29 @@ private:
     QString m_yLabel;
     bool m_showGrid;
     bool m_showAxisLabels;
+    bool m_legendStatisticsVisible;
     bool m_autoScale;
     
     // Giới hạn trục
     double m_xMin, m_xMax;
     double m_yMin, m_yMax;
+    bool m_xLogScale;
     
     // Giới hạn điểm
     int m_maxPointsPerSeries;
+    int m_markerBudget;
+    qint64 m_historyBudget;
+    qint64 m_memoryBudget;
+    // Coalesces budget checks for data appended in quick succession
+    QTimer *m_budgetTimer;
+    static void scheduleGlobalBudgetCheck();
+
+    // Keeps repainting while persistence traces are still fading
+    QTimer *m_persistenceTimer;
+
+    // Polls series attached with attachSharedRing(); stopped when none is
+    QTimer *m_sharedRingTimer;
+    void pollSharedRings();
     
     // Margin cho vẽ
     int m_leftMargin;
@@ -146,17 +472,85 @@ private:
     
     // Hàm helper
     void calculateAutoScale();
+    void seriesDataChanged(const QString &seriesName);
+    void appendToSeries(DataSeries &series, const QPointF *points, int count);
+    bool appendCompressed(const QString &seriesName, const QPointF *points,
+                          int count);
+    template <typename T>
+    void appendSamples(const QString &seriesName, const T *samples, int count);
+    SeriesExtent extentOf(DataSeries &series);
+    bool needsRegroup(DataSeries &series);
+    static qint64 trimmableBytes(const DataSeries &series);
+    qint64 releaseHiddenCaches();
+    qint64 trimSeries(DataSeries &series, qint64 maxBytes);
+    static void enforceMemoryBudget(const QList<XYChartWidget *> &charts,
+                                    qint64 budget);
     void calculateAutoScaleForAxis(int axisId);
     QPointF mapToWidget(const QPointF &dataPoint) const;
     QPointF mapToData(const QPointF &widgetPoint) const;
     QPointF mapToWidget(const QPointF &dataPoint, int axisId) const;
     QPointF mapToData(const QPointF &widgetPoint, int axisId) const;
+    // widget = offset + layout * scale, in the (log) layout coordinates of
+    // the X axis and the given Y axis
+    void layoutTransform(int axisId, QPointF &scale, QPointF &offset) const;
+    void syncLogColumns(DataSeries &series);
+    // Extent of a series in log10 units, for auto-scaling a log axis
+    bool logExtent(DataSeries &series, bool xCoordinate, double &min,
+                   double &max);
+    static qint64 seriesCount(const DataSeries &series);
+    // How many of the newest held samples a consumer that has taken in
+    // 'fed' of samplesAppended has yet to read. 'gap' is set when they do
+    // not follow on from what it read; all held samples are then unread.
+    static qint64 unreadSamples(const DataSeries &series, qint64 fed,
+                                bool &gap);
+    // Points [first, first + count) as stored
+    static void readSeriesPoints(const DataSeries &series, qint64 first,
+                                 int count, QPointF *out);
+    // Points [first, first + count) in layout coordinates
+    void readLayoutPoints(DataSeries &series, qint64 first, int count,
+                          QPointF *out);
     void drawGrid(QPainter &painter);
     void drawAxes(QPainter &painter);
     void drawYAxis(QPainter &painter, const YAxisInfo &axis);
     void drawSeries(QPainter &painter);
+    void drawSeriesLayer(QPainter &painter);
+    void drawDecimated(QPainter &painter, const DataSeries &series,
+                       int columnCount);
+    int decimationColumns() const;
+    QPen seriesPen(const DataSeries &series) const;
+    void markBusy();
+    // update() for changes to what the series layer draws; plain update()
+    // repaints only the overlays over the cached frame
+    void updateSeriesLayer();
+    void showWidgetRect(const QRectF &rect);
+    void drawSourceSeries(QPainter &painter, DataSeries &series,
+                          int &markerBudget);
+    void drawDensitySeries(QPainter &painter, DataSeries &series);
+    void drawPersistenceSeries(QPainter &painter, DataSeries &series);
+    void drawEnvelopeSeries(QPainter &painter, DataSeries &series);
+    void aggregateColumns(const DataSeries &series, int plotWidth,
+                          QVector<ColumnStats> &columns) const;
+    void aggregateHistory(const DataSeries &series, int plotWidth,
+                          QVector<ColumnStats> &columns) const;
+    void clampToLogAxis(const DataSeries &series,
+                        QVector<ColumnStats> &columns) const;
+    void drawHistory(QPainter &painter, const DataSeries &series);
+    void drawMarkers(QPainter &painter, DataSeries &series,
+                     const QVector<QPointF> &widgetPoints, int &markerBudget);
     void drawLegend(QPainter &painter);
+    QString legendStatisticsText(DataSeries &series);
     void drawCrosshair(QPainter &painter);
+    void drawMeasurementCursors(QPainter &painter);
+    void layoutAnnotations(const QFontMetrics &metrics);
+    void drawAnnotations(QPainter &painter);
+    void drawThreshold(QPainter &painter, const DataSeries &series);
+    void syncStatistics(DataSeries &series);
+    void feedTrigger(DataSeries &series);
+    void feedDerivedSeries(const QString &sourceName);
+    // Checks samples added since the last call against the series' band;
+    // crossings are signalled when 'notify' is set
+    void feedThreshold(DataSeries &series, bool notify);
+    void applyTriggerWindow();
     void drawCrosshairTextBox(QPainter &painter, QPoint pos, const QStringList &lines);
     QColor getNextColor();
     void autoGroupSeriesToAxes();
@@ -173,12 +567,59 @@ private:
     bool m_autoGroupSeries;
     int m_maxYAxes;
     double m_groupingThreshold;
+    QList<int> m_autoCreatedAxes;
     int m_axisSpacing;
 
     // Crosshair
     bool m_crosshairVisible;
     QPoint m_crosshairPos;
 
+    // Measurement cursors; m_draggedCursor is -1 while none is held
+    bool m_measurementCursorsVisible;
+    double m_cursorX[2];
+    int m_draggedCursor;
+
+    // Trigger; m_triggerFed counts the trigger series' samples already
+    // queued to the engine
+    TriggerEngine *m_trigger;
+    QString m_triggerSeries;
+    qint64 m_triggerFed;
+    double m_triggerLastX;
+    bool m_triggerLocked;
+    double m_triggerX;
+
+    // Annotations. m_annotationLayout holds the visible ones as laid out
+    // for the revision, x range and plot edges recorded with it.
+    AnnotationLayer m_annotations;
+    QVector<PlacedAnnotation> m_annotationLayout;
+    quint64 m_annotationRevision;
+    double m_annotationXMin, m_annotationXMax;
+    int m_annotationLeft, m_annotationRight;
+    bool m_annotationXLog;
+
+    // Zoom/pan. m_frame caches the series layer of the last exact render,
+    // drawn at the m_frame* view; while m_previewing it is transformed to
+    // the current view until m_settleTimer fires. It is redrawn only once
+    // m_frameDirty (data or series changed) or the view moved.
+    bool m_zoomPanEnabled;
+    bool m_previewing;
+    QTimer *m_settleTimer;
+    QImage m_frame;
+    double m_frameXMin, m_frameXMax;
+    double m_frameYMin, m_frameYMax;
+    QRect m_framePlotRect;
+    bool m_frameDirty;
+    // Mouse button dragging the view (pan or rubber band), if any
+    Qt::MouseButton m_dragButton;
+    QPoint m_dragStart;
+    QPoint m_dragLast;
+
+    // Render quality; m_busy while data or the view changed within the
+    // last m_qualityTimer interval
+    RenderQualityGovernor m_quality;
+    QTimer *m_qualityTimer;
+    bool m_busy;
+
     // Dark mode
     bool m_darkModeEnabled;
 };